@@ -0,0 +1,203 @@
+#include "bench.h"
+#include "engine/log.h"
+#include "engine/string.h"
+#include "engine/timer.h"
+#include <stdlib.h>
+
+
+namespace Lumix
+{
+namespace Bench
+{
+
+
+Runner::Runner(IAllocator& allocator, int argc, char** argv)
+	: m_allocator(allocator)
+	, m_argc(argc)
+	, m_argv(argv)
+	, m_results(allocator)
+	, m_filter(nullptr)
+	, m_quick(false)
+	, m_failure_count(0)
+{
+	m_timer = Timer::create(allocator);
+	m_quick = hasFlag("--quick");
+	m_filter = getOption("--filter");
+	m_round_time = m_quick ? 2000000 : 50000000;
+	m_rounds = m_quick ? 3 : 9;
+}
+
+
+Runner::~Runner()
+{
+	Timer::destroy(m_timer);
+}
+
+
+bool Runner::isEnabled(const char* name) const
+{
+	if (!m_filter) return true;
+	int filter_len = stringLength(m_filter);
+	for (const char* c = name; *c; ++c)
+	{
+		if (compareMemory(c, m_filter, filter_len) == 0) return true;
+		if (stringLength(c) < filter_len) break;
+	}
+	return false;
+}
+
+
+bool Runner::hasFlag(const char* flag) const
+{
+	for (int i = 1; i < m_argc; ++i)
+	{
+		if (equalStrings(m_argv[i], flag)) return true;
+	}
+	return false;
+}
+
+
+const char* Runner::getOption(const char* option) const
+{
+	for (int i = 1; i + 1 < m_argc; ++i)
+	{
+		if (equalStrings(m_argv[i], option)) return m_argv[i + 1];
+	}
+	return nullptr;
+}
+
+
+u64 Runner::now() const
+{
+	return m_timer->getRawTimeSinceStart();
+}
+
+
+double Runner::toNs(u64 ticks) const
+{
+	return (double)ticks * 1e9 / (double)m_timer->getFrequency();
+}
+
+
+static int compareSamples(const void* a, const void* b)
+{
+	double lhs = *(const double*)a;
+	double rhs = *(const double*)b;
+	return lhs < rhs ? -1 : (lhs > rhs ? 1 : 0);
+}
+
+
+void Runner::addResult(const char* name, int n, const char* unit, double* samples, int count, u64 iterations)
+{
+	qsort(samples, count, sizeof(samples[0]), compareSamples);
+	Result& result = m_results.emplace();
+	copyString(result.name, name);
+	result.n = n;
+	result.unit = unit;
+	result.value = samples[count / 2];
+	result.min = samples[0];
+	result.max = samples[count - 1];
+	result.iterations = iterations;
+	fprintf(stderr, "%-40s n=%-6d %14.2f %s\n", name, n, result.value, unit);
+}
+
+
+void Runner::report(const char* name, int n, double value, const char* unit)
+{
+	if (!isEnabled(name)) return;
+	addResult(name, n, unit, &value, 1, 1);
+}
+
+
+void Runner::fail(const char* name, int n, const char* reason)
+{
+	fprintf(stderr, "FAILED %s n=%d: %s\n", name, n, reason);
+	++m_failure_count;
+}
+
+
+bool Runner::expect(const char* name, int n, const char* what, int value, int expected)
+{
+	if (value == expected) return true;
+	fprintf(stderr, "FAILED %s n=%d: %d %s, expected %d\n", name, n, value, what, expected);
+	++m_failure_count;
+	return false;
+}
+
+
+void Runner::writeJSON(FILE* fp) const
+{
+	fprintf(fp, "{\n\t\"benchmark\": \"lumixengine_js\",\n\t\"quick\": %s,\n\t\"results\": [", m_quick ? "true" : "false");
+	for (int i = 0; i < m_results.size(); ++i)
+	{
+		const Result& r = m_results[i];
+		fprintf(fp,
+			"%s\n\t\t{\"name\": \"%s\", \"n\": %d, \"unit\": \"%s\", \"value\": %.3f, \"min\": %.3f, \"max\": %.3f, "
+			"\"iterations\": %llu}",
+			i > 0 ? "," : "",
+			r.name,
+			r.n,
+			r.unit,
+			r.value,
+			r.min,
+			r.max,
+			(unsigned long long)r.iterations);
+	}
+	fprintf(fp, "\n\t],\n\t\"failures\": %d\n}\n", m_failure_count);
+}
+
+
+int Runner::checkThresholds(const char* path) const
+{
+	FILE* fp = fopen(path, "r");
+	if (!fp)
+	{
+		g_log_error.log("Bench") << "Could not open " << path;
+		return 1;
+	}
+
+	int failed = 0;
+	char line[256];
+	while (fgets(line, sizeof(line), fp))
+	{
+		char name[64];
+		int n;
+		double limit;
+		if (line[0] == '#' || sscanf(line, "%63s %d %lf", name, &n, &limit) != 3) continue;
+
+		bool is_found = false;
+		bool is_size_run = false;
+		for (const Result& result : m_results)
+		{
+			if (result.n == n) is_size_run = true;
+			if (result.n != n || !equalStrings(result.name, name)) continue;
+			is_found = true;
+			if (result.value > limit)
+			{
+				fprintf(stderr, "REGRESSION %s n=%d: %.2f %s > %.2f\n", name, n, result.value, result.unit, limit);
+				++failed;
+			}
+		}
+		if (is_found) continue;
+
+		if (!isEnabled(name))
+		{
+			fprintf(stderr, "SKIPPED %s n=%d: filtered out\n", name, n);
+		}
+		else if (m_quick && !is_size_run)
+		{
+			fprintf(stderr, "SKIPPED %s n=%d: not run with --quick\n", name, n);
+		}
+		else
+		{
+			fprintf(stderr, "MISSING %s n=%d: no result for the limit\n", name, n);
+			++failed;
+		}
+	}
+	fclose(fp);
+	return failed;
+}
+
+
+} // namespace Bench
+} // namespace Lumix
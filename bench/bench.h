@@ -0,0 +1,126 @@
+#pragma once
+
+
+#include "engine/array.h"
+#include <stdio.h>
+
+
+namespace Lumix
+{
+
+
+class Timer;
+
+
+namespace Bench
+{
+
+
+struct Result
+{
+	char name[64];
+	int n;
+	const char* unit;
+	double value; // median of the rounds
+	double min;
+	double max;
+	u64 iterations; // per round
+};
+
+
+class Runner
+{
+public:
+	Runner(IAllocator& allocator, int argc, char** argv);
+	~Runner();
+
+	IAllocator& getAllocator() { return m_allocator; }
+	bool isQuick() const { return m_quick; }
+	bool isEnabled(const char* name) const;
+	bool hasFlag(const char* flag) const;
+	// value following the option on the command line
+	const char* getOption(const char* option) const;
+	const Array<Result>& getResults() const { return m_results; }
+
+	// f(iterations) performs iterations * ops_per_call operations, returns ns per operation
+	// or a negative value if the benchmark is filtered out
+	template <typename F> double measure(const char* name, int n, int ops_per_call, F f);
+	// for operations that can not be repeated, f() runs exactly once
+	template <typename F> double measureOnce(const char* name, int n, int ops, F f);
+	// single value metrics, e.g. memory per instance
+	void report(const char* name, int n, double value, const char* unit);
+	// correctness of the scenario, e.g. that all instances survived a reload. A failure
+	// makes the run fail regardless of the thresholds
+	void fail(const char* name, int n, const char* reason);
+	bool expect(const char* name, int n, const char* what, int value, int expected);
+	int getFailureCount() const { return m_failure_count; }
+	void writeJSON(FILE* fp) const;
+	// lines "name n max_value", returns the number of results above their limit and of
+	// limits without a result. Limits of filtered out benchmarks and of sizes which were
+	// not run with --quick are skipped
+	int checkThresholds(const char* path) const;
+
+private:
+	u64 now() const;
+	double toNs(u64 ticks) const;
+	void addResult(const char* name, int n, const char* unit, double* samples, int count, u64 iterations);
+
+	IAllocator& m_allocator;
+	int m_argc;
+	char** m_argv;
+	Timer* m_timer;
+	Array<Result> m_results;
+	const char* m_filter;
+	bool m_quick;
+	u64 m_round_time; // ns
+	int m_rounds;
+	int m_failure_count;
+};
+
+
+template <typename F> double Runner::measure(const char* name, int n, int ops_per_call, F f)
+{
+	if (!isEnabled(name)) return -1;
+
+	static const int MAX_ROUNDS = 32;
+	static const u64 MAX_ITERATIONS = 1 << 30;
+
+	f(1); // warm up
+
+	u64 iterations = 1;
+	for (;;)
+	{
+		u64 start = now();
+		f(iterations);
+		double elapsed = toNs(now() - start);
+		if (elapsed >= m_round_time || iterations >= MAX_ITERATIONS) break;
+		iterations = elapsed < m_round_time / 100 ? iterations * 10 : iterations * 2;
+	}
+
+	double samples[MAX_ROUNDS];
+	int rounds = m_rounds < MAX_ROUNDS ? m_rounds : MAX_ROUNDS;
+	for (int i = 0; i < rounds; ++i)
+	{
+		u64 start = now();
+		f(iterations);
+		samples[i] = toNs(now() - start) / ((double)iterations * ops_per_call);
+	}
+	addResult(name, n, "ns", samples, rounds, iterations);
+	return m_results.back().value;
+}
+
+
+template <typename F> double Runner::measureOnce(const char* name, int n, int ops, F f)
+{
+	if (!isEnabled(name)) return -1;
+
+	u64 start = now();
+	f();
+	double sample = toNs(now() - start) / ops;
+	addResult(name, n, "ns", &sample, 1, 1);
+	return sample;
+}
+
+
+} // namespace Bench
+} // namespace Lumix
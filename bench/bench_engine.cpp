@@ -0,0 +1,409 @@
+#include "bench_engine.h"
+#include "engine/blob.h"
+#include "engine/engine.h"
+#include "engine/fs/file_system.h"
+#include "engine/fs/ifile.h"
+#include "engine/log.h"
+#include "engine/mt/thread.h"
+#include "engine/property_descriptor.h"
+#include "engine/property_register.h"
+#include "engine/resource_manager.h"
+#include "engine/timer.h"
+#include "engine/universe/universe.h"
+#include "js_script_system.h"
+
+
+namespace Lumix
+{
+
+
+extern "C" IPlugin* createPlugin_lumixengine_js(Engine& engine);
+
+
+static const ComponentType MOVER_TYPE = PropertyRegister::getComponentType("mover");
+static const ComponentType JS_SCRIPT_TYPE = PropertyRegister::getComponentType("js_script");
+static const float WAIT_TIMEOUT = 10.0f;
+
+
+struct MoverPlugin LUMIX_FINAL : public IPlugin
+{
+	explicit MoverPlugin(IAllocator& allocator)
+		: m_allocator(allocator)
+	{
+		PropertyRegister::add("mover",
+			LUMIX_NEW(allocator, SimplePropertyDescriptor<float, MoverScene, PropertyDescriptorBase::DECIMAL>)(
+				"Speed", &MoverScene::getSpeed, &MoverScene::setSpeed));
+		PropertyRegister::add("mover",
+			LUMIX_NEW(allocator, SimplePropertyDescriptor<Vec3, MoverScene, PropertyDescriptorBase::VEC3>)(
+				"Velocity", &MoverScene::getVelocity, &MoverScene::setVelocity));
+		PropertyRegister::add("mover",
+			LUMIX_NEW(allocator, SimplePropertyDescriptor<int, MoverScene, PropertyDescriptorBase::INTEGER>)(
+				"Target", &MoverScene::getTarget, &MoverScene::setTarget));
+	}
+
+
+	const char* getName() const override { return "mover"; }
+
+
+	void createScenes(Universe& universe) override
+	{
+		universe.addScene(LUMIX_NEW(m_allocator, MoverScene)(*this, universe, m_allocator));
+	}
+
+
+	void destroyScene(IScene* scene) override { LUMIX_DELETE(m_allocator, scene); }
+
+
+	IAllocator& m_allocator;
+};
+
+
+MoverScene::MoverScene(IPlugin& plugin, Universe& universe, IAllocator& allocator)
+	: m_plugin(plugin)
+	, m_universe(universe)
+	, m_entity_map(allocator)
+	, m_speeds(allocator)
+	, m_velocities(allocator)
+	, m_targets(allocator)
+{
+	universe.registerComponentType(MOVER_TYPE, this, &MoverScene::serializeMover, &MoverScene::deserializeMover);
+}
+
+
+ComponentHandle MoverScene::createComponent(ComponentType type, Entity entity)
+{
+	if (type != MOVER_TYPE) return INVALID_COMPONENT;
+
+	while (m_entity_map.size() <= entity.index) m_entity_map.push(-1);
+	ComponentHandle cmp = {m_speeds.size()};
+	m_entity_map[entity.index] = cmp.index;
+	m_speeds.push(1);
+	m_velocities.push({0, 0, 0});
+	m_targets.push(-1);
+	m_universe.addComponent(entity, type, this, cmp);
+	return cmp;
+}
+
+
+// the data stays, handles are not reused
+void MoverScene::destroyComponent(ComponentHandle component, ComponentType type)
+{
+	if (type != MOVER_TYPE) return;
+
+	for (int i = 0; i < m_entity_map.size(); ++i)
+	{
+		if (m_entity_map[i] != component.index) continue;
+		m_entity_map[i] = -1;
+		m_universe.destroyComponent({i}, type, this, component);
+		return;
+	}
+}
+
+
+ComponentHandle MoverScene::getComponent(Entity entity, ComponentType type)
+{
+	if (type != MOVER_TYPE) return INVALID_COMPONENT;
+	return getComponent(entity);
+}
+
+
+ComponentHandle MoverScene::getComponent(Entity entity) const
+{
+	if (entity.index < 0 || entity.index >= m_entity_map.size()) return INVALID_COMPONENT;
+	return {m_entity_map[entity.index]};
+}
+
+
+void MoverScene::clear()
+{
+	m_entity_map.clear();
+	m_speeds.clear();
+	m_velocities.clear();
+	m_targets.clear();
+}
+
+
+struct BenchFileDevice::File LUMIX_FINAL : public FS::IFile
+{
+	explicit File(BenchFileDevice& device)
+		: m_device(device)
+		, m_source(nullptr)
+		, m_size(0)
+		, m_pos(0)
+	{
+	}
+
+
+	FS::IFileDevice& getDevice() override { return m_device; }
+
+
+	bool open(const Path& path, FS::Mode mode) override
+	{
+		if (mode != FS::Mode::OPEN_AND_READ) return false;
+		auto iter = m_device.m_sources.find(path.getHash());
+		if (iter == m_device.m_sources.end()) return false;
+
+		m_source = iter.value();
+		m_size = stringLength(m_source);
+		m_pos = 0;
+		return true;
+	}
+
+
+	void close() override { m_source = nullptr; }
+
+
+	bool read(void* buffer, size_t size) override
+	{
+		if (size > m_size - m_pos) return false;
+		if (size > 0) copyMemory(buffer, m_source + m_pos, size);
+		m_pos += size;
+		return true;
+	}
+
+
+	bool write(const void* buffer, size_t size) override { return false; }
+	const void* getBuffer() const override { return m_source; }
+	size_t size() override { return m_size; }
+
+
+	bool seek(FS::SeekMode base, size_t pos) override
+	{
+		switch (base)
+		{
+			case FS::SeekMode::BEGIN: m_pos = pos; break;
+			case FS::SeekMode::CURRENT: m_pos += pos; break;
+			case FS::SeekMode::END: m_pos = m_size - pos; break;
+			default: return false;
+		}
+		if (m_pos > m_size) m_pos = m_size;
+		return true;
+	}
+
+
+	size_t pos() override { return m_pos; }
+
+
+	BenchFileDevice& m_device;
+	const char* m_source;
+	size_t m_size;
+	size_t m_pos;
+};
+
+
+BenchFileDevice::BenchFileDevice(IAllocator& allocator)
+	: m_allocator(allocator)
+	, m_sources(allocator)
+{
+}
+
+
+void BenchFileDevice::setSource(const Path& path, const char* source)
+{
+	auto iter = m_sources.find(path.getHash());
+	if (iter == m_sources.end()) m_sources.insert(path.getHash(), source);
+	else iter.value() = source;
+}
+
+
+// the last device of the chain, the child is always null
+FS::IFile* BenchFileDevice::createFile(FS::IFile*)
+{
+	return LUMIX_NEW(m_allocator, File)(*this);
+}
+
+
+void BenchFileDevice::destroyFile(FS::IFile* file)
+{
+	LUMIX_DELETE(m_allocator, file);
+}
+
+
+BenchEngine::BenchEngine(IAllocator& allocator)
+	: m_allocator(allocator)
+	, m_disk(allocator)
+{
+	m_file_system = FS::FileSystem::create(allocator);
+	m_file_system->mount(&m_disk);
+	m_file_system->setDefaultDevice("disk");
+	m_engine = Engine::create(m_file_system, allocator);
+	PropertyRegister::init(allocator);
+	// the js plugin registers the component types known when it is created
+	m_mover_plugin = LUMIX_NEW(allocator, MoverPlugin)(allocator);
+	m_script_plugin = createPlugin_lumixengine_js(*m_engine);
+}
+
+
+BenchEngine::~BenchEngine()
+{
+	LUMIX_DELETE(m_allocator, m_script_plugin);
+	LUMIX_DELETE(m_allocator, m_mover_plugin);
+	PropertyRegister::shutdown();
+	Engine::destroy(m_engine, m_allocator);
+	m_file_system->unMount(&m_disk);
+	FS::FileSystem::destroy(m_file_system);
+}
+
+
+Path BenchEngine::addScript(const char* path, const char* source)
+{
+	Path script_path(path);
+	m_disk.setSource(script_path, source);
+	return script_path;
+}
+
+
+// like the engine, the plugins are updated after the scenes of the universe
+void BenchEngine::updatePlugins(float time_delta)
+{
+	m_mover_plugin->update(time_delta);
+	m_script_plugin->update(time_delta);
+}
+
+
+void BenchEngine::changeScript(const Path& path, const char* source)
+{
+	m_disk.setSource(path, source);
+	m_engine->getResourceManager().reload(path);
+}
+
+
+// scenes are created in the order of the plugins, like in the engine
+BenchUniverse::BenchUniverse(BenchEngine& engine)
+	: m_engine(engine)
+{
+	IAllocator& allocator = engine.getEngine().getAllocator();
+	m_universe = LUMIX_NEW(allocator, Universe)(allocator);
+	engine.getMoverPlugin().createScenes(*m_universe);
+	engine.getScriptPlugin().createScenes(*m_universe);
+	m_mover_scene = static_cast<MoverScene*>(m_universe->getScene(MOVER_TYPE));
+	m_script_scene = static_cast<JSScriptScene*>(m_universe->getScene(JS_SCRIPT_TYPE));
+	engine.getEngine().startGame(*m_universe);
+}
+
+
+BenchUniverse::~BenchUniverse()
+{
+	m_engine.getEngine().stopGame(*m_universe);
+	Array<IScene*>& scenes = m_universe->getScenes();
+	for (int i = scenes.size() - 1; i >= 0; --i)
+	{
+		scenes[i]->clear();
+		scenes[i]->getPlugin().destroyScene(scenes[i]);
+	}
+	LUMIX_DELETE(m_engine.getEngine().getAllocator(), m_universe);
+}
+
+
+duk_context* BenchUniverse::getContext()
+{
+	return m_script_scene->getGlobalContext();
+}
+
+
+void BenchUniverse::createEntities(int count, bool with_movers)
+{
+	for (int i = 0; i < count; ++i)
+	{
+		Entity entity = m_universe->createEntity({(float)i, 0, 0}, {0, 0, 0, 1});
+		if (with_movers) m_mover_scene->createComponent(MOVER_TYPE, entity);
+	}
+}
+
+
+int BenchUniverse::addScript(Entity entity, const Path& path)
+{
+	ComponentHandle cmp = m_script_scene->getComponent(entity);
+	if (!cmp.isValid()) cmp = m_script_scene->createComponent(JS_SCRIPT_TYPE, entity);
+	int scr_index = m_script_scene->addScript(cmp);
+	m_script_scene->setScriptPath(cmp, scr_index, path);
+	return scr_index;
+}
+
+
+void BenchUniverse::setScript(Entity entity, int scr_index, const Path& path)
+{
+	m_script_scene->setScriptPath({entity.index}, scr_index, path);
+}
+
+
+void BenchUniverse::destroyScripts(Entity entity)
+{
+	ComponentHandle cmp = m_script_scene->getComponent(entity);
+	if (cmp.isValid()) m_script_scene->destroyComponent(cmp, JS_SCRIPT_TYPE);
+}
+
+
+bool BenchUniverse::waitForScripts()
+{
+	Timer* timer = Timer::create(m_engine.getEngine().getAllocator());
+	bool is_timeout = false;
+	for (;;)
+	{
+		for (IScene* scene : m_universe->getScenes()) scene->update(0, true);
+		m_engine.updatePlugins(0);
+		if (m_script_scene->getPendingScriptCount() == 0) break;
+		if (timer->getTimeSinceStart() > WAIT_TIMEOUT)
+		{
+			g_log_error.log("Bench") << m_script_scene->getPendingScriptCount() << " scripts are still pending";
+			is_timeout = true;
+			break;
+		}
+		MT::yield();
+	}
+	Timer::destroy(timer);
+	return !is_timeout;
+}
+
+
+void BenchUniverse::update(float time_delta)
+{
+	m_engine.getEngine().setLastTimeDelta(time_delta);
+	for (IScene* scene : m_universe->getScenes()) scene->update(time_delta, false);
+	m_engine.updatePlugins(time_delta);
+}
+
+
+void BenchUniverse::serialize(OutputBlob& blob)
+{
+	m_script_scene->serialize(blob);
+}
+
+
+void BenchUniverse::deserialize(InputBlob& blob)
+{
+	m_script_scene->clear();
+	m_script_scene->deserialize(blob);
+}
+
+
+int BenchUniverse::getActiveCount()
+{
+	int count = 0;
+	for (int i = 0, c = m_universe->getEntityCount(); i < c; ++i)
+	{
+		ComponentHandle cmp = m_script_scene->getComponent({i});
+		if (!cmp.isValid()) continue;
+		for (int j = 0, scr_count = m_script_scene->getScriptCount(cmp); j < scr_count; ++j)
+		{
+			if (m_script_scene->isScriptActive(cmp, j)) ++count;
+		}
+	}
+	return count;
+}
+
+
+int BenchUniverse::countUpdates()
+{
+	m_script_scene->resetCallbackStats();
+	update(0);
+	int count = 0;
+	for (int i = 0, c = m_script_scene->getProfiledScriptCount(); i < c; ++i)
+	{
+		count += m_script_scene->getCallbackStats(i, JSScriptScene::Callback::UPDATE).call_count;
+	}
+	return count;
+}
+
+
+} // namespace Lumix
@@ -0,0 +1,151 @@
+#pragma once
+
+
+#include "engine/array.h"
+#include "engine/fs/ifile_device.h"
+#include "engine/hash_map.h"
+#include "engine/iplugin.h"
+#include "engine/matrix.h"
+#include "engine/path.h"
+#include "duktape/duktape.h"
+
+
+namespace Lumix
+{
+
+
+namespace FS
+{
+class FileSystem;
+}
+
+
+class Engine;
+class JSScriptScene;
+class Universe;
+
+
+// component the scripts talk to, stands in for a native scene
+class MoverScene LUMIX_FINAL : public IScene
+{
+public:
+	MoverScene(IPlugin& plugin, Universe& universe, IAllocator& allocator);
+
+	ComponentHandle createComponent(ComponentType type, Entity entity) override;
+	void destroyComponent(ComponentHandle component, ComponentType type) override;
+	void serialize(OutputBlob& serializer) override {}
+	void deserialize(InputBlob& serializer) override {}
+	IPlugin& getPlugin() const override { return m_plugin; }
+	void update(float time_delta, bool paused) override {}
+	ComponentHandle getComponent(Entity entity, ComponentType type) override;
+	Universe& getUniverse() override { return m_universe; }
+	void clear() override;
+
+	ComponentHandle getComponent(Entity entity) const;
+	void serializeMover(ISerializer& serializer, ComponentHandle cmp) {}
+	void deserializeMover(IDeserializer& serializer, Entity entity, int scene_version) {}
+	float getSpeed(ComponentHandle cmp) { return m_speeds[cmp.index]; }
+	void setSpeed(ComponentHandle cmp, const float& speed) { m_speeds[cmp.index] = speed; }
+	Vec3 getVelocity(ComponentHandle cmp) { return m_velocities[cmp.index]; }
+	void setVelocity(ComponentHandle cmp, const Vec3& velocity) { m_velocities[cmp.index] = velocity; }
+	int getTarget(ComponentHandle cmp) { return m_targets[cmp.index]; }
+	void setTarget(ComponentHandle cmp, const int& target) { m_targets[cmp.index] = target; }
+
+private:
+	IPlugin& m_plugin;
+	Universe& m_universe;
+	Array<int> m_entity_map;
+	Array<float> m_speeds;
+	Array<Vec3> m_velocities;
+	Array<int> m_targets;
+};
+
+
+// sources of the scripts by path, mounted as "disk" so the resource manager loads them
+// like files. The sources are not copied
+class BenchFileDevice LUMIX_FINAL : public FS::IFileDevice
+{
+public:
+	explicit BenchFileDevice(IAllocator& allocator);
+
+	void setSource(const Path& path, const char* source);
+
+	FS::IFile* createFile(FS::IFile* child) override;
+	void destroyFile(FS::IFile* file) override;
+	const char* name() const override { return "disk"; }
+
+private:
+	struct File;
+
+	IAllocator& m_allocator;
+	HashMap<u32, const char*> m_sources;
+};
+
+
+// headless engine with the mover plugin and the js plugin, one for the whole run
+class BenchEngine
+{
+public:
+	explicit BenchEngine(IAllocator& allocator);
+	~BenchEngine();
+
+	Engine& getEngine() { return *m_engine; }
+	IPlugin& getMoverPlugin() { return *m_mover_plugin; }
+	IPlugin& getScriptPlugin() { return *m_script_plugin; }
+	// source must outlive the engine, returns the path of the script
+	Path addScript(const char* path, const char* source);
+	// like an edited file, the scenes swap the new source into the running instances
+	void changeScript(const Path& path, const char* source);
+	// the once per frame work of the plugins, BenchUniverse::update calls it
+	void updatePlugins(float time_delta);
+
+private:
+	IAllocator& m_allocator;
+	BenchFileDevice m_disk;
+	FS::FileSystem* m_file_system;
+	Engine* m_engine;
+	IPlugin* m_mover_plugin;
+	IPlugin* m_script_plugin;
+};
+
+
+// universe with the mover and the script scene, the game is running
+class BenchUniverse
+{
+public:
+	explicit BenchUniverse(BenchEngine& engine);
+	~BenchUniverse();
+
+	Universe& getUniverse() { return *m_universe; }
+	MoverScene& getMoverScene() { return *m_mover_scene; }
+	JSScriptScene& getScriptScene() { return *m_script_scene; }
+	duk_context* getContext();
+
+	// entities 0 - count-1, with a mover component if with_movers
+	void createEntities(int count, bool with_movers);
+	// adds an instance to the script component of the entity, returns its index. It is
+	// started right away if the script is loaded and compiled, otherwise see waitForScripts
+	int addScript(Entity entity, const Path& path);
+	// an invalid path destroys the instance
+	void setScript(Entity entity, int scr_index, const Path& path);
+	void destroyScripts(Entity entity);
+	// runs paused frames until no instance waits for its script and no reload is pending,
+	// returns false on timeout
+	bool waitForScripts();
+	void update(float time_delta);
+	void serialize(OutputBlob& blob);
+	void deserialize(InputBlob& blob);
+	// instances with an object, i.e. started and not failed
+	int getActiveCount();
+	// runs a frame in which no time passes, returns the number of update calls in it
+	int countUpdates();
+
+private:
+	BenchEngine& m_engine;
+	Universe* m_universe;
+	MoverScene* m_mover_scene;
+	JSScriptScene* m_script_scene;
+};
+
+
+} // namespace Lumix
@@ -0,0 +1,507 @@
+#include "bench.h"
+#include "bench_engine.h"
+#include "engine/blob.h"
+#include "engine/log.h"
+#include "engine/universe/universe.h"
+#include "js_heap_monitor.h"
+#include "js_script_system.h"
+#include "js_wrapper.h"
+
+
+namespace Lumix
+{
+
+
+static const float TIME_DELTA = 1 / 60.0f;
+
+
+static const char* UPDATE_SCRIPT =
+	"({\n"
+	"	time : 0,\n"
+	"	update : function(time_delta) { this.time += time_delta; }\n"
+	"})";
+
+
+static const char* STATEFUL_SCRIPT =
+	"({\n"
+	"	name : 'enemy',\n"
+	"	health : 100,\n"
+	"	waypoints : [[0, 0, 0], [10, 0, 5], [3, 1, 7]],\n"
+	"	config : { speed : 2.5, aggressive : true, tags : ['a', 'b'] },\n"
+	"	entity : _entity,\n"
+	"	update : function(time_delta) { this.health -= time_delta; }\n"
+	"})";
+
+
+// spawned and destroyed all the time, BULLET_POOLED_SCRIPT is reused through onReuse
+static const char* BULLET_SCRIPT =
+	"({\n"
+	"	entity : _entity,\n"
+	"	time : 0,\n"
+	"	velocity : [0, 0, 10],\n"
+	"	update : function(time_delta) { this.time += time_delta; }\n"
+	"})";
+
+
+static const char* BULLET_POOLED_SCRIPT =
+	"({\n"
+	"	entity : _entity,\n"
+	"	time : 0,\n"
+	"	velocity : [0, 0, 10],\n"
+	"	update : function(time_delta) { this.time += time_delta; },\n"
+	"	onReuse : function(entity) { this.entity = entity; this.time = 0; }\n"
+	"})";
+
+
+// both react to hits, the first one by polling the mover in update, the second one
+// subscribes to the event and is not in the update loop
+static const char* HIT_POLLING_SCRIPT =
+	"({\n"
+	"	entity : _entity,\n"
+	"	health : 100,\n"
+	"	hits : 0,\n"
+	"	update : function(time_delta) {\n"
+	"		var hits = this.entity.mover.Target;\n"
+	"		if (hits != this.hits) { this.health -= hits - this.hits; this.hits = hits; }\n"
+	"	}\n"
+	"})";
+
+
+static const char* HIT_EVENT_SCRIPT =
+	"on('hit', function(damage) { this.health -= damage; });\n"
+	"({ health : 100 })";
+
+
+// hits 10 receivers per frame, the targets are created once
+static const char* MESSAGE_SENDER_SCRIPT =
+	"var universe = _entity.c_universe;\n"
+	"({\n"
+	"	next : 1,\n"
+	"	targets : [],\n"
+	"	update : function(time_delta) {\n"
+	"		if (this.targets.length == 0) {\n"
+	"			for (var i = 0; i < 1000; ++i) this.targets.push(new Entity(universe, i));\n"
+	"		}\n"
+	"		for (var i = 0; i < 10; ++i) {\n"
+	"			sendMessage(this.targets[this.next], 'hit', 1);\n"
+	"			this.next = this.next % 999 + 1;\n"
+	"		}\n"
+	"	}\n"
+	"})";
+
+
+static const char* MESSAGE_BROADCASTER_SCRIPT =
+	"({ update : function(time_delta) { broadcast('tick', time_delta); } })";
+
+
+static const char* MESSAGE_RECEIVER_SCRIPT =
+	"({\n"
+	"	health : 100,\n"
+	"	time : 0,\n"
+	"	hit : function(damage) { this.health -= damage; },\n"
+	"	tick : function(time_delta) { this.time += time_delta; }\n"
+	"})";
+
+
+// both do something every 1-10 seconds, the first one counts down in update, the second
+// one uses an interval and is not in the update loop
+static const char* COUNTDOWN_SCRIPT =
+	"({\n"
+	"	period : 1 + _entity.c_entity % 10,\n"
+	"	left : 1 + _entity.c_entity % 10,\n"
+	"	fired : 0,\n"
+	"	update : function(time_delta) {\n"
+	"		this.left -= time_delta;\n"
+	"		if (this.left <= 0) { this.left += this.period; ++this.fired; }\n"
+	"	}\n"
+	"})";
+
+
+static const char* INTERVAL_SCRIPT =
+	"setInterval(function() { ++this.fired; }, 1000 * (1 + _entity.c_entity % 10));\n"
+	"({ fired : 0 })";
+
+
+// each function loops count times inside the VM so the C++ call overhead does not dominate
+static const char* PROPERTY_LOOPS =
+	"({\n"
+	"	plain_get : function(o, count) { var s = 0; for (var i = 0; i < count; ++i) s += o.Speed; return s; },\n"
+	"	float_get : function(m, count) { var s = 0; for (var i = 0; i < count; ++i) s += m.Speed; return s; },\n"
+	"	float_set : function(m, count) { for (var i = 0; i < count; ++i) m.Speed = i; },\n"
+	"	int_get : function(m, count) { var s = 0; for (var i = 0; i < count; ++i) s += m.Target; return s; },\n"
+	"	int_set : function(m, count) { for (var i = 0; i < count; ++i) m.Target = i; },\n"
+	"	vec3_get : function(m, count) { var s = 0; for (var i = 0; i < count; ++i) s += m.Velocity[1]; return s; },\n"
+	"	vec3_set : function(m, count) { var v = [1, 2, 3]; for (var i = 0; i < count; ++i) m.Velocity = v; },\n"
+	"	entity_lookup : function(e, count) { var s = 0; for (var i = 0; i < count; ++i) s += e.mover.Speed; return s; }\n"
+	"})";
+
+
+static void startScripts(BenchUniverse& universe, int first, int count, const Path& script)
+{
+	for (int i = first; i < first + count; ++i) universe.addScript({i}, script);
+	universe.waitForScripts();
+}
+
+
+static void benchUpdateDispatch(Bench::Runner& runner, BenchEngine& engine)
+{
+	static const int COUNTS[] = {100, 1000, 10000};
+	Path script = engine.addScript("bench/update.js", UPDATE_SCRIPT);
+	for (int count : COUNTS)
+	{
+		BenchUniverse universe(engine);
+		universe.createEntities(count, false);
+		startScripts(universe, 0, count, script);
+
+		runner.measure("update_dispatch", count, count, [&](u64 iterations) {
+			for (u64 i = 0; i < iterations; ++i) universe.update(TIME_DELTA);
+		});
+	}
+}
+
+
+static void benchProperties(Bench::Runner& runner, BenchEngine& engine)
+{
+	BenchUniverse universe(engine);
+	universe.createEntities(1, true);
+	duk_context* ctx = universe.getContext();
+
+	if (duk_peval_string(ctx, PROPERTY_LOOPS) != 0)
+	{
+		g_log_error.log("JS Script") << duk_safe_to_string(ctx, -1);
+		duk_pop(ctx);
+		return;
+	}
+	duk_idx_t loops_idx = duk_get_top_index(ctx);
+
+	// [loops] -> [loops, plain, mover, entity]
+	duk_push_object(ctx);
+	duk_push_number(ctx, 1);
+	duk_put_prop_string(ctx, -2, "Speed");
+	duk_get_global_string(ctx, "Entity");
+	duk_push_pointer(ctx, &universe.getUniverse());
+	JSWrapper::push(ctx, Entity{0});
+	duk_new(ctx, 2);
+	duk_get_prop_string(ctx, -1, "mover");
+	duk_swap_top(ctx, -2);
+
+	struct Case
+	{
+		const char* name;
+		const char* function;
+		int target_idx;
+	};
+	const Case cases[] = {
+		{"property_get_plain_js", "plain_get", loops_idx + 1},
+		{"property_get_float", "float_get", loops_idx + 2},
+		{"property_set_float", "float_set", loops_idx + 2},
+		{"property_get_int", "int_get", loops_idx + 2},
+		{"property_set_int", "int_set", loops_idx + 2},
+		{"vec3_property_get", "vec3_get", loops_idx + 2},
+		{"vec3_property_set", "vec3_set", loops_idx + 2},
+		{"entity_component_lookup", "entity_lookup", loops_idx + 3}
+	};
+
+	for (const Case& c : cases)
+	{
+		runner.measure(c.name, 1, 1, [&](u64 iterations) {
+			duk_get_prop_string(ctx, loops_idx, c.function);
+			duk_dup(ctx, c.target_idx);
+			duk_push_number(ctx, (double)iterations);
+			if (duk_pcall(ctx, 2) != DUK_EXEC_SUCCESS)
+			{
+				g_log_error.log("JS Script") << duk_safe_to_string(ctx, -1);
+			}
+			duk_pop(ctx);
+		});
+	}
+	duk_pop_n(ctx, 4);
+}
+
+
+static void benchVec3Marshalling(Bench::Runner& runner, BenchEngine& engine)
+{
+	BenchUniverse universe(engine);
+	duk_context* ctx = universe.getContext();
+
+	Vec3 value(1, 2, 3);
+	runner.measure("vec3_push", 1, 1, [&](u64 iterations) {
+		for (u64 i = 0; i < iterations; ++i)
+		{
+			JSWrapper::push(ctx, value);
+			duk_pop(ctx);
+		}
+	});
+
+	JSWrapper::push(ctx, value);
+	duk_idx_t idx = duk_get_top_index(ctx);
+	Vec3 sum(0, 0, 0);
+	runner.measure("vec3_check_arg", 1, 1, [&](u64 iterations) {
+		for (u64 i = 0; i < iterations; ++i) sum = sum + JSWrapper::checkArg<Vec3>(ctx, idx);
+	});
+	duk_pop(ctx);
+
+	runner.measure("vec3_round_trip", 1, 1, [&](u64 iterations) {
+		for (u64 i = 0; i < iterations; ++i)
+		{
+			JSWrapper::push(ctx, value);
+			value = JSWrapper::toType<Vec3>(ctx, duk_get_top_index(ctx)) * 1.0001f;
+			duk_pop(ctx);
+		}
+	});
+	if (sum.x < 0) g_log_info.log("JS Script") << sum.x; // keep sum alive
+}
+
+
+// entity COUNT keeps the scripts loaded, so the instances start without waiting for the compiler
+static void benchInstantiation(Bench::Runner& runner, BenchEngine& engine)
+{
+	static const int COUNT = 1000;
+	static const struct
+	{
+		const char* path;
+		const char* source;
+		const char* name;
+	} VARIANTS[] = {
+		{"bench/update.js", UPDATE_SCRIPT, "instantiate_update_script"},
+		{"bench/stateful.js", STATEFUL_SCRIPT, "instantiate_stateful_script"},
+	};
+
+	BenchUniverse universe(engine);
+	universe.createEntities(COUNT + 1, true);
+	for (const auto& variant : VARIANTS)
+	{
+		Path script = engine.addScript(variant.path, variant.source);
+		startScripts(universe, COUNT, 1, script);
+
+		runner.measure(variant.name, COUNT, COUNT, [&](u64 iterations) {
+			for (u64 i = 0; i < iterations; ++i)
+			{
+				for (int j = 0; j < COUNT; ++j) universe.addScript({j}, script);
+				for (int j = 0; j < COUNT; ++j) universe.destroyScripts({j});
+			}
+		});
+		universe.destroyScripts({COUNT});
+	}
+}
+
+
+// COUNT bullets are alive, every spawn replaces the oldest one
+static void benchSpawn(Bench::Runner& runner, BenchEngine& engine)
+{
+	static const int COUNT = 100;
+	static const struct
+	{
+		const char* path;
+		const char* source;
+		const char* name;
+		const char* gc_name;
+	} VARIANTS[] = {
+		{"bench/bullet.js", BULLET_SCRIPT, "spawn_bullet", "spawn_bullet_gc"},
+		{"bench/bullet_pooled.js", BULLET_POOLED_SCRIPT, "spawn_bullet_pooled", "spawn_bullet_pooled_gc"},
+	};
+
+	for (const auto& variant : VARIANTS)
+	{
+		BenchUniverse universe(engine);
+		universe.createEntities(COUNT, false);
+		Path script = engine.addScript(variant.path, variant.source);
+		startScripts(universe, 0, COUNT, script);
+
+		Path invalid_path;
+		int oldest = 0;
+		const JSHeapMonitor& heap_monitor = universe.getScriptScene().getHeapMonitor();
+		u32 gc_count = heap_monitor.getStats().gc_count;
+		u64 spawn_count = 0;
+		runner.measure(variant.name, COUNT, 1, [&](u64 iterations) {
+			for (u64 i = 0; i < iterations; ++i)
+			{
+				universe.setScript({oldest}, 0, invalid_path);
+				universe.setScript({oldest}, 0, script);
+				oldest = (oldest + 1) % COUNT;
+			}
+			spawn_count += iterations;
+		});
+		gc_count = heap_monitor.getStats().gc_count - gc_count;
+		runner.report(variant.gc_name, COUNT, gc_count * 1000.0 / spawn_count, "count");
+	}
+}
+
+
+// a few entities are hit every frame
+static void benchEvents(Bench::Runner& runner, BenchEngine& engine)
+{
+	static const int COUNT = 1000;
+	static const int HITS_PER_FRAME = 10;
+
+	int next_hit = 0;
+	{
+		BenchUniverse polling(engine);
+		polling.createEntities(COUNT, true);
+		startScripts(polling, 0, COUNT, engine.addScript("bench/hit_polling.js", HIT_POLLING_SCRIPT));
+		MoverScene& scene = polling.getMoverScene();
+		runner.measure("hit_polling", COUNT, 1, [&](u64 iterations) {
+			for (u64 i = 0; i < iterations; ++i)
+			{
+				for (int j = 0; j < HITS_PER_FRAME; ++j)
+				{
+					ComponentHandle cmp = scene.getComponent({next_hit});
+					scene.setTarget(cmp, scene.getTarget(cmp) + 1);
+					next_hit = (next_hit + 1) % COUNT;
+				}
+				polling.update(TIME_DELTA);
+			}
+		});
+	}
+
+	BenchUniverse events(engine);
+	events.createEntities(COUNT, false);
+	startScripts(events, 0, COUNT, engine.addScript("bench/hit_event.js", HIT_EVENT_SCRIPT));
+	JSScriptScene& scene = events.getScriptScene();
+	runner.measure("hit_events", COUNT, 1, [&](u64 iterations) {
+		for (u64 i = 0; i < iterations; ++i)
+		{
+			for (int j = 0; j < HITS_PER_FRAME; ++j)
+			{
+				scene.postEvent("hit", {next_hit}).add(1.0f);
+				next_hit = (next_hit + 1) % COUNT;
+			}
+			events.update(TIME_DELTA);
+		}
+	});
+	runner.report("hit_events_updates", COUNT, events.countUpdates(), "count");
+}
+
+
+// entity 0 sends the messages to the other 999 entities
+static void benchMessages(Bench::Runner& runner, BenchEngine& engine)
+{
+	static const int COUNT = 1000;
+	static const struct
+	{
+		const char* path;
+		const char* source;
+		const char* name;
+	} VARIANTS[] = {
+		{"bench/message_sender.js", MESSAGE_SENDER_SCRIPT, "message_send"},
+		{"bench/message_broadcaster.js", MESSAGE_BROADCASTER_SCRIPT, "message_broadcast"},
+	};
+
+	Path receiver = engine.addScript("bench/message_receiver.js", MESSAGE_RECEIVER_SCRIPT);
+	for (const auto& variant : VARIANTS)
+	{
+		BenchUniverse universe(engine);
+		universe.createEntities(COUNT, false);
+		universe.addScript({0}, engine.addScript(variant.path, variant.source));
+		startScripts(universe, 1, COUNT - 1, receiver);
+
+		runner.measure(variant.name, COUNT, 1, [&](u64 iterations) {
+			for (u64 i = 0; i < iterations; ++i) universe.update(TIME_DELTA);
+		});
+	}
+}
+
+
+static void benchTimers(Bench::Runner& runner, BenchEngine& engine)
+{
+	static const int COUNTS[] = {1000, 10000};
+	static const struct
+	{
+		const char* path;
+		const char* source;
+		const char* name;
+	} VARIANTS[] = {
+		{"bench/countdown.js", COUNTDOWN_SCRIPT, "timer_countdown"},
+		{"bench/interval.js", INTERVAL_SCRIPT, "timer_interval"},
+	};
+
+	for (int count : COUNTS)
+	{
+		for (const auto& variant : VARIANTS)
+		{
+			BenchUniverse universe(engine);
+			universe.createEntities(count, false);
+			startScripts(universe, 0, count, engine.addScript(variant.path, variant.source));
+
+			runner.measure(variant.name, count, 1, [&](u64 iterations) {
+				for (u64 i = 0; i < iterations; ++i) universe.update(TIME_DELTA);
+			});
+		}
+	}
+}
+
+
+static void benchSerialization(Bench::Runner& runner, BenchEngine& engine)
+{
+	static const int COUNT = 1000;
+	IAllocator& allocator = runner.getAllocator();
+	BenchUniverse universe(engine);
+	BenchUniverse loaded(engine);
+	universe.createEntities(COUNT, true);
+	loaded.createEntities(COUNT, true);
+	startScripts(universe, 0, COUNT, engine.addScript("bench/stateful.js", STATEFUL_SCRIPT));
+
+	OutputBlob blob(allocator);
+	runner.measure("snapshot_save", COUNT, COUNT, [&](u64 iterations) {
+		for (u64 i = 0; i < iterations; ++i)
+		{
+			blob.clear();
+			universe.serialize(blob);
+		}
+	});
+	runner.report("snapshot_size", COUNT, (double)blob.getPos() / COUNT, "bytes");
+
+	runner.measure("snapshot_load", COUNT, COUNT, [&](u64 iterations) {
+		for (u64 i = 0; i < iterations; ++i)
+		{
+			InputBlob input(blob.getData(), blob.getPos());
+			loaded.deserialize(input);
+		}
+	});
+}
+
+
+// walks of the script component storage, every component has one instance of an empty
+// script so the time is not spent in the scripts
+static void benchComponentIteration(Bench::Runner& runner, BenchEngine& engine)
+{
+	static const int COUNTS[] = {1000, 10000, 100000};
+	IAllocator& allocator = runner.getAllocator();
+	Path script = engine.addScript("bench/empty.js", "({})");
+	for (int count : COUNTS)
+	{
+		BenchUniverse universe(engine);
+		universe.createEntities(count, false);
+		startScripts(universe, 0, count, script);
+
+		OutputBlob blob(allocator);
+		runner.measure("component_serialize", count, count, [&](u64 iterations) {
+			for (u64 i = 0; i < iterations; ++i)
+			{
+				blob.clear();
+				universe.serialize(blob);
+			}
+		});
+		runner.measure("component_lookup", count, count, [&](u64 iterations) {
+			for (u64 i = 0; i < iterations; ++i) universe.getActiveCount();
+		});
+	}
+}
+
+
+void runBindingBenchmarks(Bench::Runner& runner, BenchEngine& engine)
+{
+	benchUpdateDispatch(runner, engine);
+	benchProperties(runner, engine);
+	benchVec3Marshalling(runner, engine);
+	benchInstantiation(runner, engine);
+	benchSpawn(runner, engine);
+	benchEvents(runner, engine);
+	benchMessages(runner, engine);
+	benchTimers(runner, engine);
+	benchSerialization(runner, engine);
+	benchComponentIteration(runner, engine);
+}
+
+
+} // namespace Lumix
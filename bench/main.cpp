@@ -0,0 +1,40 @@
+#include "bench.h"
+#include "bench_engine.h"
+#include "engine/iallocator.h"
+
+
+namespace Lumix
+{
+void runBindingBenchmarks(Bench::Runner& runner, BenchEngine& engine);
+void runWrapperBenchmarks(Bench::Runner& runner, BenchEngine& engine);
+void runStressBenchmarks(Bench::Runner& runner, DefaultAllocator& allocator, BenchEngine& engine);
+}
+
+
+// usage: lumixengine_js_bench [--quick] [--stress] [--filter name] [--thresholds path]
+// the report goes to stdout, exit code is 1 if any result is above its threshold, a limit
+// has no result or a scenario check has failed
+int main(int argc, char** argv)
+{
+	Lumix::DefaultAllocator allocator;
+	int failed = 0;
+	{
+		Lumix::Bench::Runner runner(allocator, argc, argv);
+		Lumix::BenchEngine engine(allocator);
+		if (runner.hasFlag("--stress"))
+		{
+			Lumix::runStressBenchmarks(runner, allocator, engine);
+		}
+		else
+		{
+			Lumix::runBindingBenchmarks(runner, engine);
+			Lumix::runWrapperBenchmarks(runner, engine);
+		}
+		runner.writeJSON(stdout);
+
+		failed = runner.getFailureCount();
+		const char* thresholds = runner.getOption("--thresholds");
+		if (thresholds) failed += runner.checkThresholds(thresholds);
+	}
+	return failed > 0 ? 1 : 0;
+}
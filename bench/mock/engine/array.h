@@ -0,0 +1,180 @@
+#pragma once
+
+
+#include "engine/iallocator.h"
+#include "engine/string.h"
+
+
+namespace Lumix
+{
+
+
+template <typename T> class Array
+{
+public:
+	explicit Array(IAllocator& allocator)
+		: m_allocator(allocator)
+		, m_data(nullptr)
+		, m_size(0)
+		, m_capacity(0)
+	{
+	}
+
+
+	Array(const Array& rhs)
+		: m_allocator(rhs.m_allocator)
+		, m_data(nullptr)
+		, m_size(0)
+		, m_capacity(0)
+	{
+		*this = rhs;
+	}
+
+
+	~Array()
+	{
+		clear();
+		m_allocator.deallocate(m_data);
+	}
+
+
+	void operator=(const Array& rhs)
+	{
+		if (this == &rhs) return;
+		clear();
+		reserve(rhs.m_size);
+		for (int i = 0; i < rhs.m_size; ++i) new (&m_data[i]) T(rhs.m_data[i]);
+		m_size = rhs.m_size;
+	}
+
+
+	T* begin() const { return m_data; }
+	T* end() const { return m_data + m_size; }
+	T& operator[](int index) { return m_data[index]; }
+	const T& operator[](int index) const { return m_data[index]; }
+	T& back() { return m_data[m_size - 1]; }
+	int size() const { return m_size; }
+	int capacity() const { return m_capacity; }
+	bool empty() const { return m_size == 0; }
+
+
+	void swap(Array& rhs)
+	{
+		ASSERT(&m_allocator == &rhs.m_allocator);
+		T* data = rhs.m_data;
+		int size = rhs.m_size;
+		int capacity = rhs.m_capacity;
+		rhs.m_data = m_data;
+		rhs.m_size = m_size;
+		rhs.m_capacity = m_capacity;
+		m_data = data;
+		m_size = size;
+		m_capacity = capacity;
+	}
+
+
+	int indexOf(const T& item) const
+	{
+		for (int i = 0; i < m_size; ++i)
+		{
+			if (m_data[i] == item) return i;
+		}
+		return -1;
+	}
+
+
+	void eraseFast(int index)
+	{
+		m_data[index].~T();
+		if (index != m_size - 1)
+		{
+			new (&m_data[index]) T(m_data[m_size - 1]);
+			m_data[m_size - 1].~T();
+		}
+		--m_size;
+	}
+
+
+	void erase(int index)
+	{
+		for (int i = index; i < m_size - 1; ++i) m_data[i] = m_data[i + 1];
+		m_data[m_size - 1].~T();
+		--m_size;
+	}
+
+
+	void eraseItem(const T& item)
+	{
+		int idx = indexOf(item);
+		if (idx >= 0) erase(idx);
+	}
+
+
+	void push(const T& value)
+	{
+		if (m_size == m_capacity) grow();
+		new (&m_data[m_size]) T(value);
+		++m_size;
+	}
+
+
+	template <typename... Params> T& emplace(Params&&... params)
+	{
+		if (m_size == m_capacity) grow();
+		new (&m_data[m_size]) T(static_cast<Params&&>(params)...);
+		++m_size;
+		return m_data[m_size - 1];
+	}
+
+
+	void pop()
+	{
+		m_data[m_size - 1].~T();
+		--m_size;
+	}
+
+
+	void clear()
+	{
+		for (int i = 0; i < m_size; ++i) m_data[i].~T();
+		m_size = 0;
+	}
+
+
+	void resize(int size)
+	{
+		reserve(size);
+		for (int i = m_size; i < size; ++i) new (&m_data[i]) T();
+		for (int i = size; i < m_size; ++i) m_data[i].~T();
+		m_size = size;
+	}
+
+
+	void reserve(int capacity)
+	{
+		if (capacity <= m_capacity) return;
+
+		T* data = (T*)m_allocator.allocate(capacity * sizeof(T));
+		for (int i = 0; i < m_size; ++i)
+		{
+			new (&data[i]) T(m_data[i]);
+			m_data[i].~T();
+		}
+		m_allocator.deallocate(m_data);
+		m_data = data;
+		m_capacity = capacity;
+	}
+
+
+private:
+	void grow() { reserve(m_capacity < 4 ? 4 : m_capacity * 2); }
+
+
+	IAllocator& m_allocator;
+	T* m_data;
+	int m_size;
+	int m_capacity;
+};
+
+
+} // namespace Lumix
@@ -0,0 +1,142 @@
+#pragma once
+
+
+#include "engine/iallocator.h"
+
+
+namespace Lumix
+{
+
+
+// sorted keys with values in a parallel array, find is a binary search
+template <typename Key, typename Value> class AssociativeArray
+{
+public:
+	explicit AssociativeArray(IAllocator& allocator)
+		: m_allocator(allocator)
+		, m_keys(nullptr)
+		, m_values(nullptr)
+		, m_size(0)
+		, m_capacity(0)
+	{
+	}
+
+
+	~AssociativeArray()
+	{
+		clear();
+		m_allocator.deallocate(m_keys);
+		m_allocator.deallocate(m_values);
+	}
+
+
+	int size() const { return m_size; }
+	Value& at(int index) { return m_values[index]; }
+	const Value& at(int index) const { return m_values[index]; }
+	const Key& getKey(int index) const { return m_keys[index]; }
+	Value& operator[](const Key& key) { return m_values[find(key)]; }
+
+
+	int find(const Key& key) const
+	{
+		int l = 0;
+		int h = m_size - 1;
+		while (l <= h)
+		{
+			int mid = (l + h) >> 1;
+			if (m_keys[mid] < key) l = mid + 1;
+			else if (key < m_keys[mid]) h = mid - 1;
+			else return mid;
+		}
+		return -1;
+	}
+
+
+	template <typename... Params> Value& emplace(const Key& key, Params&&... params)
+	{
+		if (m_size == m_capacity) reserve(m_capacity < 4 ? 4 : m_capacity * 2);
+		int i = lowerBound(key);
+		for (int j = m_size; j > i; --j)
+		{
+			new (&m_keys[j]) Key(m_keys[j - 1]);
+			new (&m_values[j]) Value(m_values[j - 1]);
+			m_keys[j - 1].~Key();
+			m_values[j - 1].~Value();
+		}
+		new (&m_keys[i]) Key(key);
+		new (&m_values[i]) Value(static_cast<Params&&>(params)...);
+		++m_size;
+		return m_values[i];
+	}
+
+
+	int insert(const Key& key, const Value& value)
+	{
+		emplace(key, value);
+		return find(key);
+	}
+
+
+	void eraseAt(int index)
+	{
+		m_keys[index].~Key();
+		m_values[index].~Value();
+		for (int i = index; i < m_size - 1; ++i)
+		{
+			new (&m_keys[i]) Key(m_keys[i + 1]);
+			new (&m_values[i]) Value(m_values[i + 1]);
+			m_keys[i + 1].~Key();
+			m_values[i + 1].~Value();
+		}
+		--m_size;
+	}
+
+
+	void clear()
+	{
+		for (int i = 0; i < m_size; ++i)
+		{
+			m_keys[i].~Key();
+			m_values[i].~Value();
+		}
+		m_size = 0;
+	}
+
+
+	void reserve(int capacity)
+	{
+		if (capacity <= m_capacity) return;
+		Key* keys = (Key*)m_allocator.allocate(capacity * sizeof(Key));
+		Value* values = (Value*)m_allocator.allocate(capacity * sizeof(Value));
+		for (int i = 0; i < m_size; ++i)
+		{
+			new (&keys[i]) Key(m_keys[i]);
+			new (&values[i]) Value(m_values[i]);
+			m_keys[i].~Key();
+			m_values[i].~Value();
+		}
+		m_allocator.deallocate(m_keys);
+		m_allocator.deallocate(m_values);
+		m_keys = keys;
+		m_values = values;
+		m_capacity = capacity;
+	}
+
+private:
+	int lowerBound(const Key& key) const
+	{
+		int i = 0;
+		while (i < m_size && m_keys[i] < key) ++i;
+		return i;
+	}
+
+
+	IAllocator& m_allocator;
+	Key* m_keys;
+	Value* m_values;
+	int m_size;
+	int m_capacity;
+};
+
+
+} // namespace Lumix
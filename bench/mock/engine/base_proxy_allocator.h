@@ -0,0 +1,35 @@
+#pragma once
+
+
+#include "engine/iallocator.h"
+
+
+namespace Lumix
+{
+
+
+class LUMIX_ENGINE_API BaseProxyAllocator LUMIX_FINAL : public IAllocator
+{
+public:
+	explicit BaseProxyAllocator(IAllocator& source)
+		: m_source(source)
+	{
+	}
+
+	void* allocate(size_t size) override { return m_source.allocate(size); }
+	void deallocate(void* ptr) override { m_source.deallocate(ptr); }
+	void* reallocate(void* ptr, size_t size) override { return m_source.reallocate(ptr, size); }
+	void* allocate_aligned(size_t size, size_t align) override { return m_source.allocate_aligned(size, align); }
+	void deallocate_aligned(void* ptr) override { m_source.deallocate_aligned(ptr); }
+	void* reallocate_aligned(void* ptr, size_t size, size_t align) override
+	{
+		return m_source.reallocate_aligned(ptr, size, align);
+	}
+	IAllocator& getSourceAllocator() { return m_source; }
+
+private:
+	IAllocator& m_source;
+};
+
+
+} // namespace Lumix
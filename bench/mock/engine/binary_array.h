@@ -0,0 +1,94 @@
+#pragma once
+
+
+#include "engine/array.h"
+
+
+namespace Lumix
+{
+
+
+// one bit per item
+class BinaryArray
+{
+public:
+	class Accessor
+	{
+	public:
+		Accessor(BinaryArray& array, int index)
+			: m_array(array)
+			, m_index(index)
+		{
+		}
+
+		Accessor& operator=(bool value)
+		{
+			m_array.set(m_index, value);
+			return *this;
+		}
+
+		operator bool() const { return m_array.get(m_index); }
+
+	private:
+		BinaryArray& m_array;
+		int m_index;
+	};
+
+public:
+	explicit BinaryArray(IAllocator& allocator)
+		: m_words(allocator)
+		, m_size(0)
+	{
+	}
+
+
+	Accessor operator[](int index) { return Accessor(*this, index); }
+	bool operator[](int index) const { return get(index); }
+	int size() const { return m_size; }
+
+
+	bool get(int index) const { return (m_words[index >> 5] & (1U << (index & 31))) != 0; }
+
+
+	void set(int index, bool value)
+	{
+		if (value) m_words[index >> 5] |= 1U << (index & 31);
+		else m_words[index >> 5] &= ~(1U << (index & 31));
+	}
+
+
+	void push(bool value)
+	{
+		resize(m_size + 1);
+		set(m_size - 1, value);
+	}
+
+
+	void resize(int size)
+	{
+		int old_words = m_words.size();
+		m_words.resize((size + 31) >> 5);
+		for (int i = old_words; i < m_words.size(); ++i) m_words[i] = 0;
+		m_size = size;
+	}
+
+
+	void setAllZeros()
+	{
+		for (u32& word : m_words) word = 0;
+	}
+
+
+	void clear()
+	{
+		m_words.clear();
+		m_size = 0;
+	}
+
+private:
+	Array<u32> m_words;
+	int m_size;
+};
+
+
+} // namespace Lumix
@@ -0,0 +1,64 @@
+#pragma once
+
+
+#include "engine/iallocator.h"
+
+
+namespace Lumix
+{
+
+
+class OutputBlob
+{
+public:
+	explicit OutputBlob(IAllocator& allocator);
+	OutputBlob(void* data, int size);
+	~OutputBlob();
+
+	void reserve(int size);
+	void write(const void* data, int size);
+	void writeString(const char* string);
+	template <class T> void write(const T& value) { write(&value, sizeof(T)); }
+	const void* getData() const { return m_data; }
+	int getPos() const { return m_pos; }
+	void clear() { m_pos = 0; }
+
+private:
+	OutputBlob(const OutputBlob&);
+	void operator=(const OutputBlob&);
+
+	IAllocator* m_allocator;
+	u8* m_data;
+	int m_size;
+	int m_pos;
+};
+
+
+class InputBlob
+{
+public:
+	InputBlob(const void* data, int size);
+
+	bool read(void* data, int size);
+	bool readString(char* data, int max_size);
+	template <class T> void read(T& value) { read(&value, sizeof(T)); }
+	template <class T> T read()
+	{
+		T v;
+		read(&v, sizeof(v));
+		return v;
+	}
+	const void* skip(int size);
+	const void* getData() const { return m_data; }
+	int getSize() const { return m_size; }
+	int getPosition() const { return m_pos; }
+	void setPosition(int pos) { m_pos = pos; }
+
+private:
+	const u8* m_data;
+	int m_size;
+	int m_pos;
+};
+
+
+} // namespace Lumix
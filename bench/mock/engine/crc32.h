@@ -0,0 +1,17 @@
+#pragma once
+
+
+#include "engine/lumix.h"
+
+
+namespace Lumix
+{
+
+
+u32 crc32(const void* data, int length);
+u32 crc32(const char* str);
+u32 continueCrc32(u32 original_crc, const char* str);
+u32 continueCrc32(u32 original_crc, const void* data, int length);
+
+
+} // namespace Lumix
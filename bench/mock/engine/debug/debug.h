@@ -0,0 +1,35 @@
+#pragma once
+
+
+#include "engine/iallocator.h"
+#include "engine/mt/sync.h"
+
+
+namespace Lumix
+{
+namespace Debug
+{
+
+
+// the engine's allocator adds guards and stack traces, the mock only keeps it thread safe
+class LUMIX_ENGINE_API Allocator LUMIX_FINAL : public IAllocator
+{
+public:
+	explicit Allocator(IAllocator& source);
+
+	void* allocate(size_t size) override;
+	void deallocate(void* ptr) override;
+	void* reallocate(void* ptr, size_t size) override;
+	void* allocate_aligned(size_t size, size_t align) override;
+	void deallocate_aligned(void* ptr) override;
+	void* reallocate_aligned(void* ptr, size_t size, size_t align) override;
+	IAllocator& getSourceAllocator() { return m_source; }
+
+private:
+	IAllocator& m_source;
+	MT::SpinMutex m_mutex;
+};
+
+
+} // namespace Debug
+} // namespace Lumix
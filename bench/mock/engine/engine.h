@@ -0,0 +1,48 @@
+#pragma once
+
+
+#include "engine/lumix.h"
+
+
+namespace Lumix
+{
+
+
+namespace FS
+{
+class FileSystem;
+}
+
+
+struct IAllocator;
+class ResourceManager;
+class Universe;
+
+
+// what the plugins use of the engine, the benchmark drives the frames itself
+class LUMIX_ENGINE_API Engine
+{
+public:
+	virtual ~Engine() {}
+
+	static Engine* create(FS::FileSystem* fs, IAllocator& allocator);
+	static void destroy(Engine* engine, IAllocator& allocator);
+
+	virtual IAllocator& getAllocator() = 0;
+	virtual IAllocator& getLIFOAllocator() = 0;
+	virtual FS::FileSystem& getFileSystem() = 0;
+	virtual ResourceManager& getResourceManager() = 0;
+
+	virtual void startGame(Universe& context) = 0;
+	virtual void stopGame(Universe& context) = 0;
+	virtual void pause(bool pause) = 0;
+	virtual void nextFrame() = 0;
+	virtual float getFPS() const = 0;
+	virtual double getTime() const = 0;
+	virtual float getLastTimeDelta() const = 0;
+	virtual void setLastTimeDelta(float time_delta) = 0;
+	virtual bool isPaused() const = 0;
+};
+
+
+} // namespace Lumix
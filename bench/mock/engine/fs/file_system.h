@@ -0,0 +1,49 @@
+#pragma once
+
+
+#include "engine/fs/ifile.h"
+
+
+namespace Lumix
+{
+
+
+struct IAllocator;
+
+
+namespace FS
+{
+
+
+struct IFileDevice;
+
+
+struct LUMIX_ENGINE_API DeviceList
+{
+	IFileDevice* m_devices[8];
+};
+
+
+// synchronous, open() creates the files of the device chain from the last device to the first
+class LUMIX_ENGINE_API FileSystem
+{
+public:
+	static FileSystem* create(IAllocator& allocator);
+	static void destroy(FileSystem* fs);
+
+	virtual ~FileSystem() {}
+
+	virtual bool mount(IFileDevice* device) = 0;
+	virtual bool unMount(IFileDevice* device) = 0;
+
+	virtual IFile* open(const DeviceList& device_list, const Path& file, Mode mode) = 0;
+	virtual void close(IFile& file) = 0;
+
+	virtual void fillDeviceList(const char* dev, DeviceList& device_list) = 0;
+	virtual const DeviceList& getDefaultDevice() const = 0;
+	virtual void setDefaultDevice(const char* dev) = 0;
+};
+
+
+} // namespace FS
+} // namespace Lumix
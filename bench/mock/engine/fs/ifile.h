@@ -0,0 +1,62 @@
+#pragma once
+
+
+#include "engine/lumix.h"
+
+
+namespace Lumix
+{
+
+
+class Path;
+
+
+namespace FS
+{
+
+
+struct IFileDevice;
+
+
+enum class Mode : u32
+{
+	NONE,
+	OPEN_AND_READ,
+	CREATE_AND_WRITE
+};
+
+
+enum class SeekMode : u32
+{
+	BEGIN = 0,
+	END,
+	CURRENT
+};
+
+
+struct LUMIX_ENGINE_API IFile
+{
+	IFile() {}
+	virtual ~IFile() {}
+
+	virtual bool open(const Path& path, Mode mode) = 0;
+	virtual void close() = 0;
+
+	virtual bool read(void* buffer, size_t size) = 0;
+	virtual bool write(const void* buffer, size_t size) = 0;
+
+	virtual const void* getBuffer() const = 0;
+	virtual size_t size() = 0;
+
+	virtual bool seek(SeekMode base, size_t pos) = 0;
+	virtual size_t pos() = 0;
+
+	void release();
+
+protected:
+	virtual IFileDevice& getDevice() = 0;
+};
+
+
+} // namespace FS
+} // namespace Lumix
@@ -0,0 +1,39 @@
+#pragma once
+
+
+#include "engine/fs/ifile.h"
+
+
+namespace Lumix
+{
+
+
+struct IAllocator;
+
+
+namespace FS
+{
+
+
+class LUMIX_ENGINE_API OsFile
+{
+public:
+	OsFile();
+	~OsFile();
+
+	bool open(const char* path, Mode mode, IAllocator& allocator);
+	void close();
+	bool write(const void* data, size_t size);
+	bool read(void* data, size_t size);
+	size_t size();
+	size_t pos();
+	bool seek(SeekMode base, size_t pos);
+	void flush();
+
+private:
+	void* m_handle;
+};
+
+
+} // namespace FS
+} // namespace Lumix
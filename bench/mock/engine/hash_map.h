@@ -0,0 +1,196 @@
+#pragma once
+
+
+#include "engine/iallocator.h"
+
+
+namespace Lumix
+{
+
+
+template <typename K> struct HashFunc
+{
+	static u32 get(const K& key)
+	{
+		u64 x = (u64)key;
+		x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+		x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+		return u32(x ^ (x >> 31));
+	}
+};
+
+
+template <typename K> struct HashFunc<K*>
+{
+	static u32 get(K* key) { return HashFunc<uintptr>::get((uintptr)key); }
+};
+
+
+// open addressing with linear probing, erased slots are tombstones
+template <typename K, typename V, typename Hasher = HashFunc<K>> class HashMap
+{
+	enum State : u8
+	{
+		EMPTY,
+		USED,
+		ERASED
+	};
+
+	struct Slot
+	{
+		K key;
+		V value;
+		State state;
+	};
+
+public:
+	class iterator
+	{
+	public:
+		iterator(HashMap* map, int index)
+			: m_map(map)
+			, m_index(index)
+		{
+		}
+
+		K& key() { return m_map->m_slots[m_index].key; }
+		V& value() { return m_map->m_slots[m_index].value; }
+		V& operator*() { return value(); }
+		bool operator==(const iterator& rhs) const { return m_index == rhs.m_index; }
+		bool operator!=(const iterator& rhs) const { return m_index != rhs.m_index; }
+
+		void operator++()
+		{
+			++m_index;
+			while (m_index < m_map->m_capacity && m_map->m_slots[m_index].state != USED) ++m_index;
+		}
+
+	private:
+		friend class HashMap;
+
+		HashMap* m_map;
+		int m_index;
+	};
+
+public:
+	explicit HashMap(IAllocator& allocator)
+		: m_allocator(allocator)
+		, m_slots(nullptr)
+		, m_size(0)
+		, m_used(0)
+		, m_capacity(0)
+	{
+	}
+
+
+	~HashMap()
+	{
+		clear();
+		m_allocator.deallocate(m_slots);
+	}
+
+
+	iterator begin()
+	{
+		iterator iter(this, -1);
+		++iter;
+		return iter;
+	}
+
+
+	iterator end() { return iterator(this, m_capacity); }
+	int size() const { return m_size; }
+	IAllocator& getAllocator() { return m_allocator; }
+
+
+	iterator find(const K& key)
+	{
+		if (m_capacity == 0) return end();
+
+		u32 mask = m_capacity - 1;
+		for (u32 i = Hasher::get(key) & mask;; i = (i + 1) & mask)
+		{
+			Slot& slot = m_slots[i];
+			if (slot.state == EMPTY) return end();
+			if (slot.state == USED && slot.key == key) return iterator(this, i);
+		}
+	}
+
+
+	V& operator[](const K& key) { return find(key).value(); }
+
+
+	void insert(const K& key, const V& value)
+	{
+		if ((m_used + 1) * 4 > m_capacity * 3) rehash(m_capacity < 16 ? 16 : m_capacity * 2);
+
+		u32 mask = m_capacity - 1;
+		u32 i = Hasher::get(key) & mask;
+		while (m_slots[i].state == USED) i = (i + 1) & mask;
+		if (m_slots[i].state == EMPTY) ++m_used;
+		new (&m_slots[i].key) K(key);
+		new (&m_slots[i].value) V(value);
+		m_slots[i].state = USED;
+		++m_size;
+	}
+
+
+	void erase(const K& key)
+	{
+		iterator iter = find(key);
+		if (iter == end()) return;
+		Slot& slot = m_slots[iter.m_index];
+		slot.key.~K();
+		slot.value.~V();
+		slot.state = ERASED;
+		--m_size;
+	}
+
+
+	void clear()
+	{
+		for (int i = 0; i < m_capacity; ++i)
+		{
+			if (m_slots[i].state == USED)
+			{
+				m_slots[i].key.~K();
+				m_slots[i].value.~V();
+			}
+			m_slots[i].state = EMPTY;
+		}
+		m_size = 0;
+		m_used = 0;
+	}
+
+
+	void rehash(int capacity)
+	{
+		Slot* old = m_slots;
+		int old_capacity = m_capacity;
+
+		m_slots = (Slot*)m_allocator.allocate(sizeof(Slot) * capacity);
+		m_capacity = capacity;
+		m_size = 0;
+		m_used = 0;
+		for (int i = 0; i < capacity; ++i) m_slots[i].state = EMPTY;
+
+		for (int i = 0; i < old_capacity; ++i)
+		{
+			if (old[i].state != USED) continue;
+			insert(old[i].key, old[i].value);
+			old[i].key.~K();
+			old[i].value.~V();
+		}
+		m_allocator.deallocate(old);
+	}
+
+private:
+	IAllocator& m_allocator;
+	Slot* m_slots;
+	int m_size;
+	int m_used;
+	int m_capacity;
+};
+
+
+} // namespace Lumix
@@ -0,0 +1,54 @@
+#pragma once
+
+
+#include "engine/lumix.h"
+#include <atomic>
+
+
+namespace Lumix
+{
+
+
+struct IAllocator
+{
+	virtual ~IAllocator() {}
+
+	virtual void* allocate(size_t size) = 0;
+	virtual void deallocate(void* ptr) = 0;
+	virtual void* reallocate(void* ptr, size_t size) = 0;
+	virtual void* allocate_aligned(size_t size, size_t align) = 0;
+	virtual void deallocate_aligned(void* ptr) = 0;
+	virtual void* reallocate_aligned(void* ptr, size_t size, size_t align) = 0;
+
+	template <class T> void deleteObject(T* ptr)
+	{
+		if (ptr)
+		{
+			ptr->~T();
+			deallocate(ptr);
+		}
+	}
+};
+
+
+// malloc based, counts live bytes so benchmarks can report memory use, thread safe
+class DefaultAllocator LUMIX_FINAL : public IAllocator
+{
+public:
+	DefaultAllocator();
+
+	void* allocate(size_t size) override;
+	void deallocate(void* ptr) override;
+	void* reallocate(void* ptr, size_t size) override;
+	void* allocate_aligned(size_t size, size_t align) override;
+	void deallocate_aligned(void* ptr) override;
+	void* reallocate_aligned(void* ptr, size_t size, size_t align) override;
+
+	u64 getLiveBytes() const { return m_live_bytes; }
+
+private:
+	std::atomic<u64> m_live_bytes;
+};
+
+
+} // namespace Lumix
@@ -0,0 +1,54 @@
+#pragma once
+
+
+#include "engine/lumix.h"
+
+
+namespace Lumix
+{
+
+
+class Engine;
+class InputBlob;
+struct IDeserializer;
+struct IPlugin;
+struct ISerializer;
+class OutputBlob;
+class Universe;
+
+
+struct LUMIX_ENGINE_API IScene
+{
+	virtual ~IScene() {}
+
+	virtual ComponentHandle createComponent(ComponentType, Entity) = 0;
+	virtual void destroyComponent(ComponentHandle component, ComponentType type) = 0;
+	virtual void serialize(OutputBlob& serializer) = 0;
+	virtual void serialize(ISerializer& serializer) {}
+	virtual void deserialize(IDeserializer& serializer) {}
+	virtual void deserialize(InputBlob& serializer) = 0;
+	virtual IPlugin& getPlugin() const = 0;
+	virtual void update(float time_delta, bool paused) = 0;
+	virtual ComponentHandle getComponent(Entity entity, ComponentType type) = 0;
+	virtual Universe& getUniverse() = 0;
+	virtual void startGame() {}
+	virtual void stopGame() {}
+	virtual int getVersion() const { return -1; }
+	virtual void clear() = 0;
+};
+
+
+struct LUMIX_ENGINE_API IPlugin
+{
+	virtual ~IPlugin() {}
+
+	virtual void update(float) {}
+	virtual const char* getName() const = 0;
+	virtual void createScenes(Universe&) {}
+	virtual void destroyScene(IScene*) { ASSERT(false); }
+	virtual void startGame() {}
+	virtual void stopGame() {}
+};
+
+
+} // namespace Lumix
@@ -0,0 +1,16 @@
+#pragma once
+
+
+#include "engine/lumix.h"
+
+
+namespace Lumix
+{
+
+
+// the benchmark does not read or write json, see ISerializer
+class JsonSerializer;
+class JsonDeserializer;
+
+
+} // namespace Lumix
@@ -0,0 +1,40 @@
+#pragma once
+
+
+#include "engine/lumix.h"
+
+
+namespace Lumix
+{
+
+
+class Path;
+
+
+// prints to stderr, stdout is reserved for the benchmark report
+class LogProxy
+{
+public:
+	explicit LogProxy(const char* system);
+	~LogProxy();
+
+	LogProxy& operator<<(const char* message);
+	LogProxy& operator<<(int message);
+	LogProxy& operator<<(float message);
+	LogProxy& operator<<(const Path& path);
+};
+
+
+class Log
+{
+public:
+	LogProxy log(const char* system) { return LogProxy(system); }
+};
+
+
+extern Log g_log_error;
+extern Log g_log_warning;
+extern Log g_log_info;
+
+
+} // namespace Lumix
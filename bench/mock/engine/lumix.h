@@ -0,0 +1,77 @@
+#pragma once
+
+
+// Minimal stand-in for the engine headers, just enough to build the bindings
+// and duktape outside of the engine, see bench/README.md
+
+
+#include <stddef.h>
+#include <stdint.h>
+#include <new>
+
+
+#define LUMIX_FINAL final
+#define LUMIX_ENGINE_API
+#define LUMIX_FORCE_INLINE inline
+#define ASSERT(x) ((void)0)
+#define LUMIX_NEW(allocator, ...) new ((allocator).allocate(sizeof(__VA_ARGS__))) __VA_ARGS__
+#define LUMIX_DELETE(allocator, var) (allocator).deleteObject(var);
+// plugins are linked statically, the benchmark creates them by name
+#define LUMIX_PLUGIN_ENTRY(plugin_name) extern "C" Lumix::IPlugin* createPlugin_##plugin_name(Lumix::Engine& engine)
+
+
+namespace Lumix
+{
+
+
+typedef int8_t i8;
+typedef uint8_t u8;
+typedef int16_t i16;
+typedef uint16_t u16;
+typedef int32_t i32;
+typedef uint32_t u32;
+typedef int64_t i64;
+typedef uint64_t u64;
+typedef uintptr_t uintptr;
+
+
+enum { MAX_PATH_LENGTH = 260 };
+
+
+struct Entity
+{
+	int index;
+	bool operator==(const Entity& rhs) const { return rhs.index == index; }
+	bool operator!=(const Entity& rhs) const { return rhs.index != index; }
+	bool isValid() const { return index >= 0; }
+};
+
+
+struct ComponentHandle
+{
+	int index;
+	bool operator==(const ComponentHandle& rhs) const { return rhs.index == index; }
+	bool isValid() const { return index >= 0; }
+};
+
+
+struct ComponentType
+{
+	int index;
+	bool operator==(const ComponentType& rhs) const { return rhs.index == index; }
+	bool operator!=(const ComponentType& rhs) const { return rhs.index != index; }
+};
+
+
+const Entity INVALID_ENTITY = {-1};
+const ComponentHandle INVALID_COMPONENT = {-1};
+const ComponentType INVALID_COMPONENT_TYPE = {-1};
+
+
+template <typename T, int count> constexpr int lengthOf(const T (&)[count])
+{
+	return count;
+}
+
+
+} // namespace Lumix
@@ -0,0 +1,32 @@
+#pragma once
+
+
+#include "engine/lumix.h"
+
+
+namespace Lumix
+{
+namespace Math
+{
+
+
+template <typename T> LUMIX_FORCE_INLINE T minimum(T x, T y)
+{
+	return x < y ? x : y;
+}
+
+
+template <typename T> LUMIX_FORCE_INLINE T maximum(T x, T y)
+{
+	return x < y ? y : x;
+}
+
+
+template <typename T> LUMIX_FORCE_INLINE T clamp(T value, T min_value, T max_value)
+{
+	return minimum(maximum(value, min_value), max_value);
+}
+
+
+} // namespace Math
+} // namespace Lumix
@@ -0,0 +1,47 @@
+#pragma once
+
+
+#include "engine/math_utils.h"
+
+
+namespace Lumix
+{
+
+
+struct Vec2
+{
+	Vec2() {}
+	Vec2(float _x, float _y) : x(_x), y(_y) {}
+
+	float x, y;
+};
+
+
+struct Int2
+{
+	int x, y;
+};
+
+
+struct Vec3
+{
+	Vec3() {}
+	Vec3(float _x, float _y, float _z) : x(_x), y(_y), z(_z) {}
+
+	Vec3 operator+(const Vec3& rhs) const { return Vec3(x + rhs.x, y + rhs.y, z + rhs.z); }
+	Vec3 operator*(float s) const { return Vec3(x * s, y * s, z * s); }
+
+	float x, y, z;
+};
+
+
+struct Quat
+{
+	Quat() {}
+	Quat(float _x, float _y, float _z, float _w) : x(_x), y(_y), z(_z), w(_w) {}
+
+	float x, y, z, w;
+};
+
+
+} // namespace Lumix
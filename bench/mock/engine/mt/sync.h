@@ -0,0 +1,66 @@
+#pragma once
+
+
+#include "engine/lumix.h"
+
+
+namespace Lumix
+{
+namespace MT
+{
+
+
+class LUMIX_ENGINE_API SpinMutex
+{
+public:
+	explicit SpinMutex(bool locked);
+
+	void lock();
+	bool poll();
+	void unlock();
+
+private:
+	SpinMutex(const SpinMutex&);
+	void operator=(const SpinMutex&);
+
+	volatile i32 m_id;
+};
+
+
+class SpinLock
+{
+public:
+	explicit SpinLock(SpinMutex& mutex)
+		: m_mutex(mutex)
+	{
+		mutex.lock();
+	}
+	~SpinLock() { m_mutex.unlock(); }
+
+private:
+	void operator=(const SpinLock&);
+
+	SpinMutex& m_mutex;
+};
+
+
+class LUMIX_ENGINE_API Semaphore
+{
+public:
+	Semaphore(int init_count, int max_count);
+	~Semaphore();
+
+	void signal();
+	void wait();
+	bool poll();
+
+private:
+	Semaphore(const Semaphore&);
+	void operator=(const Semaphore&);
+
+	void* m_id;
+};
+
+
+} // namespace MT
+} // namespace Lumix
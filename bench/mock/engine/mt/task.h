@@ -0,0 +1,39 @@
+#pragma once
+
+
+#include "engine/lumix.h"
+
+
+namespace Lumix
+{
+
+
+struct IAllocator;
+
+
+namespace MT
+{
+
+
+class LUMIX_ENGINE_API Task
+{
+public:
+	explicit Task(IAllocator& allocator);
+	virtual ~Task();
+
+	virtual int task() = 0;
+
+	bool create(const char* name);
+	bool destroy();
+
+	bool isRunning() const;
+	bool isFinished() const;
+	IAllocator& getAllocator();
+
+private:
+	struct TaskImpl* m_implementation;
+};
+
+
+} // namespace MT
+} // namespace Lumix
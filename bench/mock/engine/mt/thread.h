@@ -0,0 +1,22 @@
+#pragma once
+
+
+#include "engine/lumix.h"
+
+
+namespace Lumix
+{
+namespace MT
+{
+
+
+typedef u32 ThreadID;
+
+
+LUMIX_ENGINE_API void sleep(u32 milliseconds);
+LUMIX_ENGINE_API void yield();
+LUMIX_ENGINE_API ThreadID getCurrentThreadID();
+
+
+} // namespace MT
+} // namespace Lumix
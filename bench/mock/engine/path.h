@@ -0,0 +1,32 @@
+#pragma once
+
+
+#include "engine/lumix.h"
+
+
+namespace Lumix
+{
+
+
+// the engine shares path strings through the path manager, the mock keeps a copy
+class LUMIX_ENGINE_API Path
+{
+public:
+	Path();
+	explicit Path(const char* path);
+
+	bool operator==(const Path& rhs) const { return m_hash == rhs.m_hash; }
+	bool operator!=(const Path& rhs) const { return m_hash != rhs.m_hash; }
+
+	u32 getHash() const { return m_hash; }
+	const char* c_str() const { return m_path; }
+	int length() const;
+	bool isValid() const { return m_path[0] != '\0'; }
+
+private:
+	char m_path[MAX_PATH_LENGTH];
+	u32 m_hash;
+};
+
+
+} // namespace Lumix
@@ -0,0 +1,19 @@
+#pragma once
+
+
+#include "engine/lumix.h"
+
+
+namespace Lumix
+{
+namespace PathUtils
+{
+
+
+LUMIX_ENGINE_API void normalize(const char* path, char* out, u32 max_size);
+LUMIX_ENGINE_API void getExtension(char* extension, int max_length, const char* src);
+LUMIX_ENGINE_API bool hasExtension(const char* filename, const char* ext);
+
+
+} // namespace PathUtils
+} // namespace Lumix
@@ -0,0 +1,15 @@
+#pragma once
+
+
+#include "engine/lumix.h"
+
+
+namespace Lumix
+{
+
+
+// plugins are linked statically into the benchmark, see LUMIX_PLUGIN_ENTRY
+class PluginManager;
+
+
+} // namespace Lumix
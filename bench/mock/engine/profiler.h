@@ -0,0 +1,32 @@
+#pragma once
+
+
+#include "engine/lumix.h"
+
+
+namespace Lumix
+{
+namespace Profiler
+{
+
+
+// the benchmark measures itself, blocks are not recorded
+inline void beginBlock(const char* name) {}
+// key_literal must outlive the profiler, the value is attached to the current block
+inline void pushInt(const char* key_literal, int value) {}
+inline void endBlock() {}
+
+
+struct Scope
+{
+	explicit Scope(const char* name) { beginBlock(name); }
+	~Scope() { endBlock(); }
+};
+
+
+} // namespace Profiler
+} // namespace Lumix
+
+
+#define PROFILE_FUNCTION() Lumix::Profiler::Scope profile_scope(__FUNCTION__);
+#define PROFILE_BLOCK(name) Lumix::Profiler::Scope profile_scope(name);
@@ -0,0 +1,120 @@
+#pragma once
+
+
+#include "engine/blob.h"
+#include "engine/string.h"
+#include "engine/universe/component.h"
+
+
+namespace Lumix
+{
+
+
+class PropertyDescriptorBase
+{
+public:
+	enum Type
+	{
+		RESOURCE = 0,
+		FILE,
+		DECIMAL,
+		BOOL,
+		VEC3,
+		INTEGER,
+		STRING,
+		ARRAY,
+		COLOR,
+		VEC4,
+		VEC2,
+		SAMPLED_FUNCTION,
+		ENUM,
+		INT2,
+		ENTITY,
+		BLOB
+	};
+
+	virtual ~PropertyDescriptorBase() {}
+
+	virtual void set(ComponentUID cmp, int index, InputBlob& stream) const = 0;
+	virtual void get(ComponentUID cmp, int index, OutputBlob& stream) const = 0;
+
+	Type getType() const { return m_type; }
+	const char* getName() const { return m_name; }
+	void setName(const char* name) { copyString(m_name, name); }
+
+protected:
+	Type m_type;
+	char m_name[32];
+};
+
+
+// same shape as the engine's getter/setter descriptors, minus the index variants
+template <typename T, class S, PropertyDescriptorBase::Type TYPE>
+class SimplePropertyDescriptor : public PropertyDescriptorBase
+{
+public:
+	typedef T (S::*Getter)(ComponentHandle);
+	typedef void (S::*Setter)(ComponentHandle, const T&);
+
+	SimplePropertyDescriptor(const char* name, Getter getter, Setter setter)
+		: m_getter(getter)
+		, m_setter(setter)
+	{
+		setName(name);
+		m_type = TYPE;
+	}
+
+
+	void set(ComponentUID cmp, int index, InputBlob& stream) const override
+	{
+		T value;
+		stream.read(&value, sizeof(value));
+		(static_cast<S*>(cmp.scene)->*m_setter)(cmp.handle, value);
+	}
+
+
+	void get(ComponentUID cmp, int index, OutputBlob& stream) const override
+	{
+		T value = (static_cast<S*>(cmp.scene)->*m_getter)(cmp.handle);
+		stream.write(&value, sizeof(value));
+	}
+
+private:
+	Getter m_getter;
+	Setter m_setter;
+};
+
+
+template <class S> class BlobPropertyDescriptor : public PropertyDescriptorBase
+{
+public:
+	typedef void (S::*Getter)(ComponentHandle, OutputBlob&);
+	typedef void (S::*Setter)(ComponentHandle, InputBlob&);
+
+	BlobPropertyDescriptor(const char* name, Getter getter, Setter setter)
+		: m_getter(getter)
+		, m_setter(setter)
+	{
+		setName(name);
+		m_type = BLOB;
+	}
+
+
+	void set(ComponentUID cmp, int index, InputBlob& stream) const override
+	{
+		(static_cast<S*>(cmp.scene)->*m_setter)(cmp.handle, stream);
+	}
+
+
+	void get(ComponentUID cmp, int index, OutputBlob& stream) const override
+	{
+		(static_cast<S*>(cmp.scene)->*m_getter)(cmp.handle, stream);
+	}
+
+private:
+	Getter m_getter;
+	Setter m_setter;
+};
+
+
+} // namespace Lumix
@@ -0,0 +1,31 @@
+#pragma once
+
+
+#include "engine/array.h"
+
+
+namespace Lumix
+{
+
+
+class PropertyDescriptorBase;
+
+
+namespace PropertyRegister
+{
+
+
+LUMIX_ENGINE_API void init(IAllocator& allocator);
+LUMIX_ENGINE_API void shutdown();
+LUMIX_ENGINE_API void add(const char* component_type, PropertyDescriptorBase* descriptor);
+LUMIX_ENGINE_API PropertyDescriptorBase* getDescriptor(ComponentType type, u32 name_hash);
+LUMIX_ENGINE_API PropertyDescriptorBase* getDescriptor(const char* component_type, const char* property_name);
+LUMIX_ENGINE_API Array<PropertyDescriptorBase*>& getDescriptors(ComponentType type);
+LUMIX_ENGINE_API ComponentType getComponentType(const char* id);
+LUMIX_ENGINE_API u32 getComponentTypeHash(ComponentType type);
+LUMIX_ENGINE_API int getComponentTypesCount();
+LUMIX_ENGINE_API const char* getComponentTypeID(int index);
+
+
+} // namespace PropertyRegister
+} // namespace Lumix
@@ -0,0 +1,98 @@
+#pragma once
+
+
+#include "engine/delegate_list.h"
+#include "engine/path.h"
+
+
+namespace Lumix
+{
+
+
+namespace FS
+{
+struct IFile;
+}
+
+
+class ResourceManagerBase;
+
+
+struct LUMIX_ENGINE_API ResourceType
+{
+	ResourceType() : type(0) {}
+	explicit ResourceType(const char* type_name);
+	u32 type;
+	bool operator !=(const ResourceType& rhs) const { return rhs.type != type; }
+	bool operator ==(const ResourceType& rhs) const { return rhs.type == type; }
+};
+const ResourceType INVALID_RESOURCE_TYPE("");
+
+
+// the engine's state machine, loaded synchronously by the mock file system
+class LUMIX_ENGINE_API Resource
+{
+public:
+	friend class ResourceManagerBase;
+
+	enum class State : u32
+	{
+		EMPTY = 0,
+		READY,
+		FAILURE,
+	};
+
+	typedef DelegateList<void(State, State, Resource&)> ObserverCallback;
+
+public:
+	State getState() const { return m_current_state; }
+	bool isEmpty() const { return State::EMPTY == m_current_state; }
+	bool isReady() const { return State::READY == m_current_state; }
+	bool isFailure() const { return State::FAILURE == m_current_state; }
+	u32 getRefCount() const { return m_ref_count; }
+	ObserverCallback& getObserverCb() { return m_cb; }
+	size_t size() const { return m_size; }
+	const Path& getPath() const { return m_path; }
+	ResourceManagerBase& getResourceManager() { return m_resource_manager; }
+
+protected:
+	Resource(const Path& path, ResourceManagerBase& resource_manager, IAllocator& allocator);
+	virtual ~Resource();
+
+	virtual void onBeforeReady() {}
+	virtual void unload() = 0;
+	virtual bool load(FS::IFile& file) = 0;
+
+	void onCreated(State state);
+	void doUnload();
+
+	void addDependency(Resource& dependent_resource);
+	void removeDependency(Resource& dependent_resource);
+	void checkState();
+
+protected:
+	State m_desired_state;
+	u16 m_empty_dep_count;
+	u16 m_failed_dep_count;
+	State m_current_state;
+	size_t m_size;
+	ObserverCallback m_cb;
+	ResourceManagerBase& m_resource_manager;
+
+private:
+	void doLoad();
+	void fileLoaded(FS::IFile* file);
+	void onStateChanged(State old_state, State new_state, Resource&);
+	u32 addRef() { return ++m_ref_count; }
+	u32 remRef() { return --m_ref_count; }
+
+	Resource(const Resource&);
+	void operator=(const Resource&);
+
+private:
+	Path m_path;
+	u32 m_ref_count;
+};
+
+
+} // namespace Lumix
@@ -0,0 +1,57 @@
+#pragma once
+
+
+#include "engine/hash_map.h"
+#include "engine/resource.h"
+
+
+namespace Lumix
+{
+
+
+class ResourceManager;
+
+
+class LUMIX_ENGINE_API ResourceManagerBase
+{
+	friend class Resource;
+
+public:
+	typedef HashMap<u32, Resource*> ResourceTable;
+
+public:
+	void create(ResourceType type, ResourceManager& owner);
+	void destroy();
+
+	void enableUnload(bool enable) { m_is_unload_enabled = enable; }
+
+	Resource* load(const Path& path);
+	void load(Resource& resource);
+	void removeUnreferenced();
+
+	void unload(const Path& path);
+	void unload(Resource& resource);
+
+	void reload(const Path& path);
+	void reload(Resource& resource);
+	ResourceTable& getResourceTable() { return m_resources; }
+
+	explicit ResourceManagerBase(IAllocator& allocator);
+	virtual ~ResourceManagerBase();
+	ResourceManager& getOwner() const { return *m_owner; }
+
+	Resource* get(const Path& path);
+
+protected:
+	virtual Resource* createResource(const Path& path) = 0;
+	virtual void destroyResource(Resource& resource) = 0;
+
+private:
+	u32 m_size;
+	ResourceTable m_resources;
+	ResourceManager* m_owner;
+	bool m_is_unload_enabled;
+};
+
+
+} // namespace Lumix
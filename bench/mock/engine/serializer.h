@@ -0,0 +1,45 @@
+#pragma once
+
+
+#include "engine/lumix.h"
+
+
+namespace Lumix
+{
+
+
+struct Vec3;
+struct Quat;
+
+
+struct LUMIX_ENGINE_API ISerializer
+{
+	virtual ~ISerializer() {}
+
+	virtual void write(const char* label, Entity entity) = 0;
+	virtual void write(const char* label, const Vec3& value) = 0;
+	virtual void write(const char* label, const Quat& value) = 0;
+	virtual void write(const char* label, float value) = 0;
+	virtual void write(const char* label, bool value) = 0;
+	virtual void write(const char* label, i32 value) = 0;
+	virtual void write(const char* label, u32 value) = 0;
+	virtual void write(const char* label, const char* value) = 0;
+};
+
+
+struct LUMIX_ENGINE_API IDeserializer
+{
+	virtual ~IDeserializer() {}
+
+	virtual void read(Entity* entity) = 0;
+	virtual void read(Vec3* value) = 0;
+	virtual void read(Quat* value) = 0;
+	virtual void read(float* value) = 0;
+	virtual void read(bool* value) = 0;
+	virtual void read(i32* value) = 0;
+	virtual void read(u32* value) = 0;
+	virtual void read(char* value, int max_size) = 0;
+};
+
+
+} // namespace Lumix
@@ -0,0 +1,110 @@
+#pragma once
+
+
+#include "engine/iallocator.h"
+
+
+namespace Lumix
+{
+
+
+int stringLength(const char* str);
+bool copyString(char* dst, int max_size, const char* src);
+bool catString(char* dst, int max_size, const char* src);
+bool equalStrings(const char* lhs, const char* rhs);
+bool equalIStrings(const char* lhs, const char* rhs);
+int compareString(const char* lhs, const char* rhs);
+bool startsWith(const char* str, const char* prefix);
+const char* toCString(int value, char* output, int length);
+const char* toCString(u64 value, char* output, int length);
+const char* toCString(float value, char* output, int length, int after_point);
+void copyMemory(void* dst, const void* src, size_t size);
+void moveMemory(void* dst, const void* src, size_t size);
+void setMemory(void* ptr, u8 value, size_t size);
+int compareMemory(const void* lhs, const void* rhs, size_t size);
+
+
+inline bool isLetter(char c)
+{
+	return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
+}
+
+
+inline bool isNumeric(char c)
+{
+	return c >= '0' && c <= '9';
+}
+
+
+inline bool isUpperCase(char c)
+{
+	return c >= 'A' && c <= 'Z';
+}
+
+
+template <int size> bool copyString(char (&dst)[size], const char* src)
+{
+	return copyString(dst, size, src);
+}
+
+
+template <int size> bool catString(char (&dst)[size], const char* src)
+{
+	return catString(dst, size, src);
+}
+
+
+template <int SIZE> struct StaticString
+{
+	StaticString() { data[0] = '\0'; }
+
+
+	template <typename... Args> StaticString(const char* str, Args... args)
+	{
+		copyString(data, str);
+		int tmp[] = {(add(args), 0)...};
+		(void)tmp;
+	}
+
+
+	StaticString& operator<<(const char* str)
+	{
+		catString(data, str);
+		return *this;
+	}
+
+
+	void add(const char* value) { catString(data, value); }
+	bool operator==(const char* str) const { return equalStrings(data, str); }
+	operator const char*() const { return data; }
+
+	char data[SIZE];
+};
+
+
+class string
+{
+public:
+	explicit string(IAllocator& allocator);
+	string(const char* str, IAllocator& allocator);
+	string(const string& rhs);
+	~string();
+
+	void operator=(const string& rhs);
+	void operator=(const char* rhs);
+	bool operator==(const char* rhs) const { return equalStrings(c_str(), rhs); }
+	bool operator!=(const char* rhs) const { return !equalStrings(c_str(), rhs); }
+
+	const char* c_str() const { return m_cstr ? m_cstr : ""; }
+	int length() const { return m_size; }
+	void set(const char* str, int size);
+
+private:
+
+	IAllocator& m_allocator;
+	char* m_cstr;
+	int m_size;
+};
+
+
+} // namespace Lumix
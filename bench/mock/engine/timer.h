@@ -0,0 +1,29 @@
+#pragma once
+
+
+#include "engine/lumix.h"
+
+
+namespace Lumix
+{
+
+
+struct IAllocator;
+
+
+class Timer
+{
+public:
+	virtual ~Timer() {}
+
+	virtual float tick() = 0;
+	virtual float getTimeSinceStart() = 0;
+	virtual u64 getRawTimeSinceStart() = 0;
+	virtual u64 getFrequency() = 0;
+
+	static Timer* create(IAllocator& allocator);
+	static void destroy(Timer* timer);
+};
+
+
+} // namespace Lumix
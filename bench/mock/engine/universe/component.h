@@ -0,0 +1,23 @@
+#pragma once
+
+
+#include "engine/lumix.h"
+
+
+namespace Lumix
+{
+
+
+struct IScene;
+
+
+struct ComponentUID
+{
+	Entity entity;
+	ComponentType type;
+	IScene* scene;
+	ComponentHandle handle;
+};
+
+
+} // namespace Lumix
@@ -0,0 +1,75 @@
+#pragma once
+
+
+#include "engine/array.h"
+#include "engine/associative_array.h"
+#include "engine/matrix.h"
+
+
+namespace Lumix
+{
+
+
+struct IDeserializer;
+struct IScene;
+struct ISerializer;
+
+
+// transforms, component masks and scenes, names and hierarchy are not mocked
+class Universe
+{
+public:
+	typedef void (IScene::*Serialize)(ISerializer&, ComponentHandle);
+	typedef void (IScene::*Deserialize)(IDeserializer&, Entity, int);
+
+	struct ComponentTypeEntry
+	{
+		IScene* scene = nullptr;
+		Serialize serialize;
+		Deserialize deserialize;
+	};
+
+	enum { MAX_COMPONENTS_TYPES_COUNT = 64 };
+
+public:
+	explicit Universe(IAllocator& allocator);
+
+	IAllocator& getAllocator() { return m_allocator; }
+	Entity createEntity(const Vec3& position, const Quat& rotation);
+	void destroyEntity(Entity entity);
+	bool hasEntity(Entity entity) const;
+	int getEntityCount() const { return m_positions.size() - m_free.size(); }
+	const Vec3& getPosition(Entity entity) const { return m_positions[entity.index]; }
+	void setPosition(Entity entity, const Vec3& position) { m_positions[entity.index] = position; }
+	const Quat& getRotation(Entity entity) const { return m_rotations[entity.index]; }
+	void setRotation(Entity entity, const Quat& rotation) { m_rotations[entity.index] = rotation; }
+	Entity getEntityByName(const char* name) { return INVALID_ENTITY; }
+
+	void addComponent(Entity entity, ComponentType component_type, IScene* scene, ComponentHandle index);
+	void destroyComponent(Entity entity, ComponentType component_type, IScene* scene, ComponentHandle index);
+	bool hasComponent(Entity entity, ComponentType component_type) const;
+
+	template <typename T1, typename T2>
+	void registerComponentType(ComponentType type, IScene* scene, T1 serialize, T2 deserialize)
+	{
+		m_component_type_map[type.index].scene = scene;
+		m_component_type_map[type.index].serialize = static_cast<Serialize>(serialize);
+		m_component_type_map[type.index].deserialize = static_cast<Deserialize>(deserialize);
+	}
+	IScene* getScene(ComponentType type) const { return m_component_type_map[type.index].scene; }
+	Array<IScene*>& getScenes() { return m_scenes; }
+	void addScene(IScene* scene) { m_scenes.push(scene); }
+
+private:
+	IAllocator& m_allocator;
+	ComponentTypeEntry m_component_type_map[MAX_COMPONENTS_TYPES_COUNT];
+	Array<IScene*> m_scenes;
+	Array<Vec3> m_positions;
+	Array<Quat> m_rotations;
+	Array<u64> m_components;
+	Array<bool> m_alive;
+	Array<int> m_free;
+};
+
+
+} // namespace Lumix
@@ -0,0 +1,71 @@
+#pragma once
+
+
+// the benchmark draws no frames, widgets do nothing and report no interaction
+
+
+typedef void* ImTextureID;
+typedef unsigned int ImGuiID;
+typedef int ImGuiWindowFlags;
+typedef int ImGuiTreeNodeFlags;
+typedef int ImGuiSelectableFlags;
+
+
+struct ImVec2
+{
+	ImVec2() { x = y = 0.0f; }
+	ImVec2(float _x, float _y) { x = _x; y = _y; }
+
+	float x, y;
+};
+
+
+struct ImVec4
+{
+	ImVec4() { x = y = z = w = 0.0f; }
+	ImVec4(float _x, float _y, float _z, float _w) { x = _x; y = _y; z = _z; w = _w; }
+
+	float x, y, z, w;
+};
+
+
+namespace ImGui
+{
+
+
+inline bool Begin(const char* name, bool* p_open = nullptr, ImGuiWindowFlags flags = 0) { return false; }
+inline void End() {}
+inline bool BeginChildFrame(ImGuiID id, const ImVec2& size, ImGuiWindowFlags extra_flags = 0) { return false; }
+inline void EndChildFrame() {}
+inline bool BeginDock(const char* label, bool* opened = nullptr, ImGuiWindowFlags extra_flags = 0, const ImVec2& default_size = ImVec2(-1, -1)) { return false; }
+inline void EndDock() {}
+inline bool BeginPopup(const char* str_id) { return false; }
+inline void EndPopup() {}
+inline void OpenPopup(const char* str_id) {}
+inline ImGuiID GetID(const char* str_id) { return 0; }
+inline void Text(const char* fmt, ...) {}
+inline void LabelText(const char* label, const char* fmt, ...) {}
+inline bool Button(const char* label, const ImVec2& size = ImVec2(0, 0)) { return false; }
+inline bool Checkbox(const char* label, bool* v) { return false; }
+inline bool CollapsingHeader(const char* label, ImGuiTreeNodeFlags flags = 0) { return false; }
+inline bool Selectable(const char* label, bool* p_selected, ImGuiSelectableFlags flags = 0, const ImVec2& size = ImVec2(0, 0)) { return false; }
+inline bool SliderFloat(const char* label, float* v, float v_min, float v_max, const char* display_format = "%.3f", float power = 1.0f) { return false; }
+inline bool DragFloat(const char* label, float* v, float v_speed = 1.0f, float v_min = 0.0f, float v_max = 0.0f, const char* display_format = "%.3f", float power = 1.0f) { return false; }
+inline void Image(ImTextureID user_texture_id, const ImVec2& size, const ImVec2& uv0 = ImVec2(0, 0), const ImVec2& uv1 = ImVec2(1, 1), const ImVec4& tint_col = ImVec4(1, 1, 1, 1), const ImVec4& border_col = ImVec4(0, 0, 0, 0)) {}
+inline void Dummy(const ImVec2& size) {}
+inline void SameLine(float pos_x = 0.0f, float spacing_w = -1.0f) {}
+inline void NewLine() {}
+inline void Separator() {}
+inline void Indent(float indent_w = 0.0f) {}
+inline void Unindent(float indent_w = 0.0f) {}
+inline void Columns(int count = 1, const char* id = nullptr, bool border = true) {}
+inline void NextColumn() {}
+inline float GetColumnWidth(int column_index = -1) { return 0.0f; }
+inline void PushItemWidth(float item_width) {}
+inline void PopItemWidth() {}
+inline void PopID() {}
+inline void PopStyleColor(int count = 1) {}
+inline void PopStyleVar(int count = 1) {}
+
+
+} // namespace ImGui
@@ -0,0 +1,882 @@
+#include "engine/blob.h"
+#include "engine/crc32.h"
+#include "engine/debug/debug.h"
+#include "engine/engine.h"
+#include "engine/fs/file_system.h"
+#include "engine/iallocator.h"
+#include "engine/log.h"
+#include "engine/path.h"
+#include "engine/path_utils.h"
+#include "engine/property_descriptor.h"
+#include "engine/property_register.h"
+#include "engine/resource.h"
+#include "engine/resource_manager.h"
+#include "engine/string.h"
+#include "engine/timer.h"
+#include "engine/universe/universe.h"
+#include "engine/iplugin.h"
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+namespace Lumix
+{
+
+
+static const size_t ALLOCATION_HEADER_SIZE = 16;
+
+
+DefaultAllocator::DefaultAllocator()
+	: m_live_bytes(0)
+{
+}
+
+
+void* DefaultAllocator::allocate(size_t size)
+{
+	u8* mem = (u8*)malloc(size + ALLOCATION_HEADER_SIZE);
+	if (!mem) return nullptr;
+	*(size_t*)mem = size;
+	m_live_bytes += size;
+	return mem + ALLOCATION_HEADER_SIZE;
+}
+
+
+void DefaultAllocator::deallocate(void* ptr)
+{
+	if (!ptr) return;
+	u8* mem = (u8*)ptr - ALLOCATION_HEADER_SIZE;
+	m_live_bytes -= *(size_t*)mem;
+	free(mem);
+}
+
+
+void* DefaultAllocator::reallocate(void* ptr, size_t size)
+{
+	if (!ptr) return allocate(size);
+	if (size == 0)
+	{
+		deallocate(ptr);
+		return nullptr;
+	}
+	u8* mem = (u8*)ptr - ALLOCATION_HEADER_SIZE;
+	size_t old_size = *(size_t*)mem;
+	u8* new_mem = (u8*)realloc(mem, size + ALLOCATION_HEADER_SIZE);
+	if (!new_mem) return nullptr;
+	*(size_t*)new_mem = size;
+	m_live_bytes += size;
+	m_live_bytes -= old_size;
+	return new_mem + ALLOCATION_HEADER_SIZE;
+}
+
+
+// the header keeps allocations 16 byte aligned, nothing in the plugins needs more
+void* DefaultAllocator::allocate_aligned(size_t size, size_t align)
+{
+	ASSERT(align <= ALLOCATION_HEADER_SIZE);
+	return allocate(size);
+}
+
+
+void DefaultAllocator::deallocate_aligned(void* ptr)
+{
+	deallocate(ptr);
+}
+
+
+void* DefaultAllocator::reallocate_aligned(void* ptr, size_t size, size_t align)
+{
+	ASSERT(align <= ALLOCATION_HEADER_SIZE);
+	return reallocate(ptr, size);
+}
+
+
+namespace Debug
+{
+
+
+Allocator::Allocator(IAllocator& source)
+	: m_source(source)
+	, m_mutex(false)
+{
+}
+
+
+void* Allocator::allocate(size_t size)
+{
+	MT::SpinLock lock(m_mutex);
+	return m_source.allocate(size);
+}
+
+
+void Allocator::deallocate(void* ptr)
+{
+	MT::SpinLock lock(m_mutex);
+	m_source.deallocate(ptr);
+}
+
+
+void* Allocator::reallocate(void* ptr, size_t size)
+{
+	MT::SpinLock lock(m_mutex);
+	return m_source.reallocate(ptr, size);
+}
+
+
+void* Allocator::allocate_aligned(size_t size, size_t align)
+{
+	MT::SpinLock lock(m_mutex);
+	return m_source.allocate_aligned(size, align);
+}
+
+
+void Allocator::deallocate_aligned(void* ptr)
+{
+	MT::SpinLock lock(m_mutex);
+	m_source.deallocate_aligned(ptr);
+}
+
+
+void* Allocator::reallocate_aligned(void* ptr, size_t size, size_t align)
+{
+	MT::SpinLock lock(m_mutex);
+	return m_source.reallocate_aligned(ptr, size, align);
+}
+
+
+} // namespace Debug
+
+
+int stringLength(const char* str)
+{
+	return (int)strlen(str);
+}
+
+
+bool copyString(char* dst, int max_size, const char* src)
+{
+	if (max_size <= 0) return false;
+	int len = (int)strlen(src);
+	bool fits = len < max_size;
+	if (!fits) len = max_size - 1;
+	memcpy(dst, src, len);
+	dst[len] = '\0';
+	return fits;
+}
+
+
+bool catString(char* dst, int max_size, const char* src)
+{
+	int len = (int)strlen(dst);
+	return copyString(dst + len, max_size - len, src);
+}
+
+
+bool equalStrings(const char* lhs, const char* rhs)
+{
+	return strcmp(lhs, rhs) == 0;
+}
+
+
+bool equalIStrings(const char* lhs, const char* rhs)
+{
+	for (; *lhs && *rhs; ++lhs, ++rhs)
+	{
+		char l = *lhs >= 'A' && *lhs <= 'Z' ? *lhs - 'A' + 'a' : *lhs;
+		char r = *rhs >= 'A' && *rhs <= 'Z' ? *rhs - 'A' + 'a' : *rhs;
+		if (l != r) return false;
+	}
+	return *lhs == *rhs;
+}
+
+
+int compareString(const char* lhs, const char* rhs)
+{
+	return strcmp(lhs, rhs);
+}
+
+
+bool startsWith(const char* str, const char* prefix)
+{
+	return strncmp(str, prefix, strlen(prefix)) == 0;
+}
+
+
+const char* toCString(int value, char* output, int length)
+{
+	snprintf(output, length, "%d", value);
+	return output;
+}
+
+
+const char* toCString(u64 value, char* output, int length)
+{
+	snprintf(output, length, "%llu", (unsigned long long)value);
+	return output;
+}
+
+
+const char* toCString(float value, char* output, int length, int after_point)
+{
+	snprintf(output, length, "%.*f", after_point, value);
+	return output;
+}
+
+
+void copyMemory(void* dst, const void* src, size_t size)
+{
+	memcpy(dst, src, size);
+}
+
+
+void moveMemory(void* dst, const void* src, size_t size)
+{
+	memmove(dst, src, size);
+}
+
+
+void setMemory(void* ptr, u8 value, size_t size)
+{
+	memset(ptr, value, size);
+}
+
+
+int compareMemory(const void* lhs, const void* rhs, size_t size)
+{
+	return memcmp(lhs, rhs, size);
+}
+
+
+string::string(IAllocator& allocator)
+	: m_allocator(allocator)
+	, m_cstr(nullptr)
+	, m_size(0)
+{
+}
+
+
+string::string(const char* str, IAllocator& allocator)
+	: m_allocator(allocator)
+	, m_cstr(nullptr)
+	, m_size(0)
+{
+	set(str, stringLength(str));
+}
+
+
+string::string(const string& rhs)
+	: m_allocator(rhs.m_allocator)
+	, m_cstr(nullptr)
+	, m_size(0)
+{
+	set(rhs.c_str(), rhs.length());
+}
+
+
+string::~string()
+{
+	m_allocator.deallocate(m_cstr);
+}
+
+
+void string::operator=(const string& rhs)
+{
+	if (this != &rhs) set(rhs.c_str(), rhs.length());
+}
+
+
+void string::operator=(const char* rhs)
+{
+	set(rhs, stringLength(rhs));
+}
+
+
+void string::set(const char* str, int size)
+{
+	char* cstr = (char*)m_allocator.allocate(size + 1);
+	copyMemory(cstr, str, size);
+	cstr[size] = '\0';
+	m_allocator.deallocate(m_cstr);
+	m_cstr = cstr;
+	m_size = size;
+}
+
+
+Path::Path()
+	: m_hash(0)
+{
+	m_path[0] = '\0';
+}
+
+
+// normalized like the engine's paths, lowercase with forward slashes
+Path::Path(const char* path)
+{
+	PathUtils::normalize(path, m_path, lengthOf(m_path));
+	m_hash = crc32(m_path);
+}
+
+
+int Path::length() const
+{
+	return stringLength(m_path);
+}
+
+
+namespace PathUtils
+{
+
+
+void normalize(const char* path, char* out, u32 max_size)
+{
+	u32 i = 0;
+	if (path[0] == '.' && (path[1] == '\\' || path[1] == '/')) path += 2;
+	for (; path[0] != '\0' && i + 1 < max_size; ++path, ++i)
+	{
+		char c = *path == '\\' ? '/' : *path;
+		out[i] = c >= 'A' && c <= 'Z' ? c - 'A' + 'a' : c;
+	}
+	out[i] = '\0';
+}
+
+
+void getExtension(char* extension, int max_length, const char* src)
+{
+	const char* ext = nullptr;
+	for (const char* c = src; *c; ++c)
+	{
+		if (*c == '.') ext = c + 1;
+		if (*c == '/' || *c == '\\') ext = nullptr;
+	}
+	copyString(extension, max_length, ext ? ext : "");
+}
+
+
+bool hasExtension(const char* filename, const char* ext)
+{
+	char tmp[20];
+	getExtension(tmp, lengthOf(tmp), filename);
+	return equalIStrings(tmp, ext);
+}
+
+
+} // namespace PathUtils
+
+
+ResourceType::ResourceType(const char* type_name)
+{
+	type = crc32(type_name);
+}
+
+
+OutputBlob::OutputBlob(IAllocator& allocator)
+	: m_allocator(&allocator)
+	, m_data(nullptr)
+	, m_size(0)
+	, m_pos(0)
+{
+}
+
+
+OutputBlob::OutputBlob(void* data, int size)
+	: m_allocator(nullptr)
+	, m_data((u8*)data)
+	, m_size(size)
+	, m_pos(0)
+{
+}
+
+
+OutputBlob::~OutputBlob()
+{
+	if (m_allocator) m_allocator->deallocate(m_data);
+}
+
+
+void OutputBlob::reserve(int size)
+{
+	if (size <= m_size) return;
+	ASSERT(m_allocator);
+	m_data = (u8*)m_allocator->reallocate(m_data, size);
+	m_size = size;
+}
+
+
+void OutputBlob::write(const void* data, int size)
+{
+	if (size <= 0) return;
+	if (m_pos + size > m_size)
+	{
+		if (!m_allocator) return;
+		reserve((m_pos + size) << 1);
+	}
+	copyMemory(m_data + m_pos, data, size);
+	m_pos += size;
+}
+
+
+void OutputBlob::writeString(const char* string)
+{
+	if (string)
+	{
+		i32 size = stringLength(string) + 1;
+		write(size);
+		write(string, size);
+	}
+	else
+	{
+		write((i32)0);
+	}
+}
+
+
+InputBlob::InputBlob(const void* data, int size)
+	: m_data((const u8*)data)
+	, m_size(size)
+	, m_pos(0)
+{
+}
+
+
+bool InputBlob::read(void* data, int size)
+{
+	if (m_pos + size > m_size)
+	{
+		setMemory(data, 0, size);
+		return false;
+	}
+	if (size) copyMemory(data, m_data + m_pos, size);
+	m_pos += size;
+	return true;
+}
+
+
+bool InputBlob::readString(char* data, int max_size)
+{
+	i32 size;
+	read(size);
+	if (size > max_size || !read(data, size)) return false;
+	return true;
+}
+
+
+const void* InputBlob::skip(int size)
+{
+	const void* pos = m_data + m_pos;
+	m_pos += size;
+	if (m_pos > m_size) m_pos = m_size;
+	return pos;
+}
+
+
+Log g_log_error;
+Log g_log_warning;
+Log g_log_info;
+
+
+LogProxy::LogProxy(const char* system)
+{
+	fprintf(stderr, "[%s] ", system);
+}
+
+
+LogProxy::~LogProxy()
+{
+	fprintf(stderr, "\n");
+}
+
+
+LogProxy& LogProxy::operator<<(const char* message)
+{
+	fprintf(stderr, "%s", message);
+	return *this;
+}
+
+
+LogProxy& LogProxy::operator<<(int message)
+{
+	fprintf(stderr, "%d", message);
+	return *this;
+}
+
+
+LogProxy& LogProxy::operator<<(const Path& path)
+{
+	fprintf(stderr, "%s", path.c_str());
+	return *this;
+}
+
+
+LogProxy& LogProxy::operator<<(float message)
+{
+	fprintf(stderr, "%f", message);
+	return *this;
+}
+
+
+static u32 crc32_table[256];
+
+
+static void initCrc32Table()
+{
+	if (crc32_table[1]) return;
+	for (u32 i = 0; i < 256; ++i)
+	{
+		u32 c = i;
+		for (int k = 0; k < 8; ++k) c = c & 1 ? 0xEDB88320 ^ (c >> 1) : c >> 1;
+		crc32_table[i] = c;
+	}
+}
+
+
+u32 continueCrc32(u32 original_crc, const void* data, int length)
+{
+	initCrc32Table();
+	u32 crc = ~original_crc;
+	const u8* c = (const u8*)data;
+	for (int i = 0; i < length; ++i) crc = crc32_table[(crc ^ c[i]) & 0xff] ^ (crc >> 8);
+	return ~crc;
+}
+
+
+u32 continueCrc32(u32 original_crc, const char* str)
+{
+	return continueCrc32(original_crc, str, stringLength(str));
+}
+
+
+u32 crc32(const void* data, int length)
+{
+	return continueCrc32(0, data, length);
+}
+
+
+u32 crc32(const char* str)
+{
+	return continueCrc32(0, str, stringLength(str));
+}
+
+
+struct TimerImpl LUMIX_FINAL : public Timer
+{
+	typedef std::chrono::steady_clock Clock;
+
+
+	explicit TimerImpl(IAllocator& allocator)
+		: m_allocator(allocator)
+		, m_first_tick(Clock::now())
+		, m_last_tick(m_first_tick)
+	{
+	}
+
+
+	float tick() override
+	{
+		Clock::time_point now = Clock::now();
+		float delta = std::chrono::duration<float>(now - m_last_tick).count();
+		m_last_tick = now;
+		return delta;
+	}
+
+
+	float getTimeSinceStart() override
+	{
+		return std::chrono::duration<float>(Clock::now() - m_first_tick).count();
+	}
+
+
+	u64 getRawTimeSinceStart() override
+	{
+		return (u64)std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - m_first_tick).count();
+	}
+
+
+	u64 getFrequency() override { return 1000000000; }
+
+
+	IAllocator& m_allocator;
+	Clock::time_point m_first_tick;
+	Clock::time_point m_last_tick;
+};
+
+
+Timer* Timer::create(IAllocator& allocator)
+{
+	return LUMIX_NEW(allocator, TimerImpl)(allocator);
+}
+
+
+void Timer::destroy(Timer* timer)
+{
+	if (!timer) return;
+	IAllocator& allocator = static_cast<TimerImpl*>(timer)->m_allocator;
+	LUMIX_DELETE(allocator, static_cast<TimerImpl*>(timer));
+}
+
+
+Universe::Universe(IAllocator& allocator)
+	: m_allocator(allocator)
+	, m_scenes(allocator)
+	, m_positions(allocator)
+	, m_rotations(allocator)
+	, m_components(allocator)
+	, m_alive(allocator)
+	, m_free(allocator)
+{
+}
+
+
+Entity Universe::createEntity(const Vec3& position, const Quat& rotation)
+{
+	Entity entity;
+	if (!m_free.empty())
+	{
+		entity.index = m_free.back();
+		m_free.pop();
+		m_positions[entity.index] = position;
+		m_rotations[entity.index] = rotation;
+		m_components[entity.index] = 0;
+		m_alive[entity.index] = true;
+		return entity;
+	}
+	entity.index = m_positions.size();
+	m_positions.push(position);
+	m_rotations.push(rotation);
+	m_components.push(0);
+	m_alive.push(true);
+	return entity;
+}
+
+
+void Universe::destroyEntity(Entity entity)
+{
+	if (!hasEntity(entity)) return;
+	m_alive[entity.index] = false;
+	m_free.push(entity.index);
+}
+
+
+bool Universe::hasEntity(Entity entity) const
+{
+	return entity.index >= 0 && entity.index < m_alive.size() && m_alive[entity.index];
+}
+
+
+void Universe::addComponent(Entity entity, ComponentType component_type, IScene* scene, ComponentHandle index)
+{
+	m_components[entity.index] |= (u64)1 << component_type.index;
+}
+
+
+void Universe::destroyComponent(Entity entity, ComponentType component_type, IScene* scene, ComponentHandle index)
+{
+	m_components[entity.index] &= ~((u64)1 << component_type.index);
+}
+
+
+bool Universe::hasComponent(Entity entity, ComponentType component_type) const
+{
+	return (m_components[entity.index] & ((u64)1 << component_type.index)) != 0;
+}
+
+
+namespace PropertyRegister
+{
+
+
+struct ComponentTypeData
+{
+	char id[50];
+	u32 id_hash;
+};
+
+
+// component types are registered by static initializers, before init is called
+static DefaultAllocator& getStaticAllocator()
+{
+	static DefaultAllocator allocator;
+	return allocator;
+}
+
+
+static Array<ComponentTypeData>& getComponentTypes()
+{
+	static Array<ComponentTypeData> types(getStaticAllocator());
+	return types;
+}
+
+
+static Array<Array<PropertyDescriptorBase*>>& getComponentDescriptors()
+{
+	static Array<Array<PropertyDescriptorBase*>> descriptors(getStaticAllocator());
+	return descriptors;
+}
+
+
+static IAllocator* g_allocator = nullptr;
+
+
+void init(IAllocator& allocator)
+{
+	g_allocator = &allocator;
+}
+
+
+void shutdown()
+{
+	for (Array<PropertyDescriptorBase*>& descriptors : getComponentDescriptors())
+	{
+		for (PropertyDescriptorBase* descriptor : descriptors) LUMIX_DELETE(*g_allocator, descriptor);
+		descriptors.clear();
+	}
+	g_allocator = nullptr;
+}
+
+
+void add(const char* component_type, PropertyDescriptorBase* descriptor)
+{
+	getDescriptors(getComponentType(component_type)).push(descriptor);
+}
+
+
+PropertyDescriptorBase* getDescriptor(ComponentType type, u32 name_hash)
+{
+	for (PropertyDescriptorBase* descriptor : getDescriptors(type))
+	{
+		if (crc32(descriptor->getName()) == name_hash) return descriptor;
+	}
+	return nullptr;
+}
+
+
+PropertyDescriptorBase* getDescriptor(const char* component_type, const char* property_name)
+{
+	return getDescriptor(getComponentType(component_type), crc32(property_name));
+}
+
+
+Array<PropertyDescriptorBase*>& getDescriptors(ComponentType type)
+{
+	Array<Array<PropertyDescriptorBase*>>& descriptors = getComponentDescriptors();
+	while (descriptors.size() <= type.index) descriptors.emplace(getStaticAllocator());
+	return descriptors[type.index];
+}
+
+
+ComponentType getComponentType(const char* id)
+{
+	Array<ComponentTypeData>& types = getComponentTypes();
+	u32 id_hash = crc32(id);
+	for (int i = 0; i < types.size(); ++i)
+	{
+		if (types[i].id_hash == id_hash) return {i};
+	}
+
+	ComponentTypeData& type = types.emplace();
+	copyString(type.id, id);
+	type.id_hash = id_hash;
+	ASSERT(types.size() <= Universe::MAX_COMPONENTS_TYPES_COUNT);
+	return {types.size() - 1};
+}
+
+
+u32 getComponentTypeHash(ComponentType type)
+{
+	return getComponentTypes()[type.index].id_hash;
+}
+
+
+int getComponentTypesCount()
+{
+	return getComponentTypes().size();
+}
+
+
+const char* getComponentTypeID(int index)
+{
+	return getComponentTypes()[index].id;
+}
+
+
+} // namespace PropertyRegister
+
+
+class EngineImpl LUMIX_FINAL : public Engine
+{
+public:
+	EngineImpl(FS::FileSystem* fs, IAllocator& allocator)
+		: m_allocator(allocator)
+		, m_resource_manager(allocator)
+		, m_file_system(fs)
+		, m_is_paused(false)
+		, m_next_frame(false)
+		, m_time(0)
+		, m_last_time_delta(0)
+	{
+		m_resource_manager.create(*fs);
+	}
+
+
+	~EngineImpl() { m_resource_manager.destroy(); }
+
+
+	IAllocator& getAllocator() override { return m_allocator; }
+	// the engine's is a stack allocator for temporaries, the mock does not need one
+	IAllocator& getLIFOAllocator() override { return m_allocator; }
+	FS::FileSystem& getFileSystem() override { return *m_file_system; }
+	ResourceManager& getResourceManager() override { return m_resource_manager; }
+
+
+	void startGame(Universe& context) override
+	{
+		for (IScene* scene : context.getScenes()) scene->startGame();
+	}
+
+
+	void stopGame(Universe& context) override
+	{
+		for (IScene* scene : context.getScenes()) scene->stopGame();
+	}
+
+
+	void pause(bool pause) override { m_is_paused = pause; }
+	void nextFrame() override { m_next_frame = true; }
+	bool isPaused() const override { return m_is_paused; }
+	float getFPS() const override { return m_last_time_delta > 0 ? 1 / m_last_time_delta : 0; }
+	double getTime() const override { return m_time; }
+	float getLastTimeDelta() const override { return m_last_time_delta; }
+
+
+	void setLastTimeDelta(float time_delta) override
+	{
+		m_last_time_delta = time_delta;
+		m_time += time_delta;
+		m_next_frame = false;
+	}
+
+private:
+	IAllocator& m_allocator;
+	ResourceManager m_resource_manager;
+	FS::FileSystem* m_file_system;
+	bool m_is_paused;
+	bool m_next_frame;
+	double m_time;
+	float m_last_time_delta;
+};
+
+
+Engine* Engine::create(FS::FileSystem* fs, IAllocator& allocator)
+{
+	return LUMIX_NEW(allocator, EngineImpl)(fs, allocator);
+}
+
+
+void Engine::destroy(Engine* engine, IAllocator& allocator)
+{
+	LUMIX_DELETE(allocator, static_cast<EngineImpl*>(engine));
+}
+
+
+} // namespace Lumix
@@ -0,0 +1,537 @@
+#include "engine/array.h"
+#include "engine/fs/file_system.h"
+#include "engine/fs/ifile.h"
+#include "engine/fs/ifile_device.h"
+#include "engine/fs/os_file.h"
+#include "engine/log.h"
+#include "engine/path.h"
+#include "engine/resource.h"
+#include "engine/resource_manager.h"
+#include "engine/resource_manager_base.h"
+#include "engine/string.h"
+#include <stdio.h>
+
+
+namespace Lumix
+{
+namespace FS
+{
+
+
+void IFile::release()
+{
+	getDevice().destroyFile(this);
+}
+
+
+class FileSystemImpl LUMIX_FINAL : public FileSystem
+{
+public:
+	explicit FileSystemImpl(IAllocator& allocator)
+		: m_allocator(allocator)
+		, m_devices(allocator)
+	{
+		m_default_device.m_devices[0] = nullptr;
+	}
+
+
+	bool mount(IFileDevice* device) override
+	{
+		for (IFileDevice* mounted : m_devices)
+		{
+			if (equalStrings(mounted->name(), device->name())) return false;
+		}
+		m_devices.push(device);
+		return true;
+	}
+
+
+	bool unMount(IFileDevice* device) override
+	{
+		int idx = m_devices.indexOf(device);
+		if (idx < 0) return false;
+		m_devices.eraseFast(idx);
+		return true;
+	}
+
+
+	IFile* open(const DeviceList& device_list, const Path& file, Mode mode) override
+	{
+		IFile* prev = nullptr;
+		for (int i = 0; i < lengthOf(device_list.m_devices) && device_list.m_devices[i]; ++i)
+		{
+			prev = device_list.m_devices[i]->createFile(prev);
+		}
+		if (!prev) return nullptr;
+		if (prev->open(file, mode)) return prev;
+		prev->release();
+		return nullptr;
+	}
+
+
+	void close(IFile& file) override
+	{
+		file.close();
+		file.release();
+	}
+
+
+	// "memory:disk" lists disk first, the device of a name which is not mounted ends the list
+	void fillDeviceList(const char* dev, DeviceList& device_list) override
+	{
+		int device_index = 0;
+		const char* end = dev + stringLength(dev);
+		while (end > dev && device_index < lengthOf(device_list.m_devices) - 1)
+		{
+			const char* token = end;
+			while (token > dev && token[-1] != ':') --token;
+			char device[32];
+			int len = int(end - token) < lengthOf(device) - 1 ? int(end - token) : lengthOf(device) - 1;
+			copyMemory(device, token, len);
+			device[len] = '\0';
+			IFileDevice* found = getDevice(device);
+			if (!found) break;
+			device_list.m_devices[device_index] = found;
+			++device_index;
+			end = token > dev ? token - 1 : dev;
+		}
+		device_list.m_devices[device_index] = nullptr;
+	}
+
+
+	IAllocator& getAllocator() { return m_allocator; }
+	const DeviceList& getDefaultDevice() const override { return m_default_device; }
+	void setDefaultDevice(const char* dev) override { fillDeviceList(dev, m_default_device); }
+
+private:
+	IFileDevice* getDevice(const char* device)
+	{
+		for (IFileDevice* mounted : m_devices)
+		{
+			if (equalStrings(mounted->name(), device)) return mounted;
+		}
+		return nullptr;
+	}
+
+
+	IAllocator& m_allocator;
+	Array<IFileDevice*> m_devices;
+	DeviceList m_default_device;
+};
+
+
+FileSystem* FileSystem::create(IAllocator& allocator)
+{
+	return LUMIX_NEW(allocator, FileSystemImpl)(allocator);
+}
+
+
+void FileSystem::destroy(FileSystem* fs)
+{
+	if (!fs) return;
+	IAllocator& allocator = static_cast<FileSystemImpl*>(fs)->getAllocator();
+	LUMIX_DELETE(allocator, static_cast<FileSystemImpl*>(fs));
+}
+
+
+OsFile::OsFile()
+	: m_handle(nullptr)
+{
+}
+
+
+OsFile::~OsFile()
+{
+	ASSERT(!m_handle);
+}
+
+
+bool OsFile::open(const char* path, Mode mode, IAllocator& allocator)
+{
+	m_handle = fopen(path, mode == Mode::CREATE_AND_WRITE ? "wb" : "rb");
+	return m_handle != nullptr;
+}
+
+
+void OsFile::close()
+{
+	if (m_handle) fclose((FILE*)m_handle);
+	m_handle = nullptr;
+}
+
+
+bool OsFile::write(const void* data, size_t size)
+{
+	return fwrite(data, 1, size, (FILE*)m_handle) == size;
+}
+
+
+bool OsFile::read(void* data, size_t size)
+{
+	return fread(data, 1, size, (FILE*)m_handle) == size;
+}
+
+
+size_t OsFile::size()
+{
+	FILE* file = (FILE*)m_handle;
+	long pos = ftell(file);
+	fseek(file, 0, SEEK_END);
+	long size = ftell(file);
+	fseek(file, pos, SEEK_SET);
+	return (size_t)size;
+}
+
+
+size_t OsFile::pos()
+{
+	return (size_t)ftell((FILE*)m_handle);
+}
+
+
+bool OsFile::seek(SeekMode base, size_t pos)
+{
+	int origin = base == SeekMode::BEGIN ? SEEK_SET : base == SeekMode::END ? SEEK_END : SEEK_CUR;
+	return fseek((FILE*)m_handle, (long)pos, origin) == 0;
+}
+
+
+void OsFile::flush()
+{
+	fflush((FILE*)m_handle);
+}
+
+
+} // namespace FS
+
+
+Resource::Resource(const Path& path, ResourceManagerBase& resource_manager, IAllocator& allocator)
+	: m_desired_state(State::EMPTY)
+	, m_empty_dep_count(1)
+	, m_failed_dep_count(0)
+	, m_current_state(State::EMPTY)
+	, m_size(0)
+	, m_cb(allocator)
+	, m_resource_manager(resource_manager)
+	, m_path(path)
+	, m_ref_count(0)
+{
+}
+
+
+Resource::~Resource() = default;
+
+
+void Resource::checkState()
+{
+	State old_state = m_current_state;
+	if (m_failed_dep_count > 0 && m_current_state != State::FAILURE)
+	{
+		m_current_state = State::FAILURE;
+		m_cb.invoke(old_state, m_current_state, *this);
+	}
+
+	if (m_failed_dep_count == 0)
+	{
+		if (m_empty_dep_count == 0 && m_current_state != State::READY && m_desired_state != State::EMPTY)
+		{
+			onBeforeReady();
+			m_current_state = State::READY;
+			m_cb.invoke(old_state, m_current_state, *this);
+		}
+
+		if (m_empty_dep_count > 0 && m_current_state != State::EMPTY)
+		{
+			m_current_state = State::EMPTY;
+			m_cb.invoke(old_state, m_current_state, *this);
+		}
+	}
+}
+
+
+void Resource::fileLoaded(FS::IFile* file)
+{
+	if (m_desired_state != State::READY) return;
+
+	if (!file)
+	{
+		g_log_error.log("Core") << "Could not open " << getPath().c_str();
+		--m_empty_dep_count;
+		++m_failed_dep_count;
+		checkState();
+		return;
+	}
+
+	if (!load(*file)) ++m_failed_dep_count;
+	--m_empty_dep_count;
+	checkState();
+}
+
+
+void Resource::doUnload()
+{
+	m_desired_state = State::EMPTY;
+	unload();
+	m_size = 0;
+	m_empty_dep_count = 1;
+	m_failed_dep_count = 0;
+	checkState();
+}
+
+
+void Resource::onCreated(State state)
+{
+	ASSERT(m_empty_dep_count == 1);
+	ASSERT(m_failed_dep_count == 0);
+
+	m_current_state = state;
+	m_desired_state = State::READY;
+	m_failed_dep_count = state == State::FAILURE ? 1 : 0;
+	m_empty_dep_count = 0;
+}
+
+
+// the mock file system is synchronous, the file is loaded before doLoad returns
+void Resource::doLoad()
+{
+	if (m_desired_state == State::READY) return;
+	m_desired_state = State::READY;
+
+	FS::FileSystem& fs = m_resource_manager.getOwner().getFileSystem();
+	FS::IFile* file = fs.open(fs.getDefaultDevice(), m_path, FS::Mode::OPEN_AND_READ);
+	fileLoaded(file);
+	if (file) fs.close(*file);
+}
+
+
+void Resource::addDependency(Resource& dependent_resource)
+{
+	ASSERT(m_desired_state != State::EMPTY);
+
+	dependent_resource.m_cb.bind<Resource, &Resource::onStateChanged>(this);
+	if (dependent_resource.isEmpty()) ++m_empty_dep_count;
+	if (dependent_resource.isFailure()) ++m_failed_dep_count;
+
+	checkState();
+}
+
+
+void Resource::removeDependency(Resource& dependent_resource)
+{
+	dependent_resource.m_cb.unbind<Resource, &Resource::onStateChanged>(this);
+	if (dependent_resource.isEmpty()) --m_empty_dep_count;
+	if (dependent_resource.isFailure()) --m_failed_dep_count;
+
+	checkState();
+}
+
+
+void Resource::onStateChanged(State old_state, State new_state, Resource&)
+{
+	ASSERT(old_state != new_state);
+	ASSERT(m_current_state != State::EMPTY || m_desired_state != State::EMPTY);
+
+	if (old_state == State::EMPTY) --m_empty_dep_count;
+	if (old_state == State::FAILURE) --m_failed_dep_count;
+
+	if (new_state == State::EMPTY) ++m_empty_dep_count;
+	if (new_state == State::FAILURE) ++m_failed_dep_count;
+
+	checkState();
+}
+
+
+ResourceManagerBase::ResourceManagerBase(IAllocator& allocator)
+	: m_size(0)
+	, m_resources(allocator)
+	, m_owner(nullptr)
+	, m_is_unload_enabled(true)
+{
+}
+
+
+ResourceManagerBase::~ResourceManagerBase()
+{
+	ASSERT(m_resources.size() == 0);
+}
+
+
+void ResourceManagerBase::create(ResourceType type, ResourceManager& owner)
+{
+	owner.add(type, this);
+	m_owner = &owner;
+}
+
+
+void ResourceManagerBase::destroy()
+{
+	for (auto iter = m_resources.begin(), end = m_resources.end(); iter != end; ++iter)
+	{
+		Resource* resource = iter.value();
+		if (!resource->isEmpty())
+		{
+			g_log_error.log("Engine") << "Leaking resource " << resource->getPath().c_str();
+		}
+		destroyResource(*resource);
+	}
+	m_resources.clear();
+}
+
+
+Resource* ResourceManagerBase::get(const Path& path)
+{
+	auto it = m_resources.find(path.getHash());
+	if (m_resources.end() == it) return nullptr;
+	return it.value();
+}
+
+
+Resource* ResourceManagerBase::load(const Path& path)
+{
+	if (!path.isValid()) return nullptr;
+	Resource* resource = get(path);
+
+	if (!resource)
+	{
+		resource = createResource(path);
+		m_resources.insert(path.getHash(), resource);
+	}
+
+	if (resource->isEmpty() && resource->m_desired_state == Resource::State::EMPTY)
+	{
+		resource->doLoad();
+	}
+
+	resource->addRef();
+	return resource;
+}
+
+
+void ResourceManagerBase::load(Resource& resource)
+{
+	if (resource.isEmpty() && resource.m_desired_state == Resource::State::EMPTY)
+	{
+		resource.doLoad();
+	}
+	resource.addRef();
+}
+
+
+void ResourceManagerBase::removeUnreferenced()
+{
+	if (!m_is_unload_enabled) return;
+
+	Array<Resource*> to_remove(m_resources.getAllocator());
+	for (auto iter = m_resources.begin(), end = m_resources.end(); iter != end; ++iter)
+	{
+		if (iter.value()->getRefCount() == 0) to_remove.push(iter.value());
+	}
+
+	for (Resource* resource : to_remove)
+	{
+		m_resources.erase(resource->getPath().getHash());
+		destroyResource(*resource);
+	}
+}
+
+
+void ResourceManagerBase::unload(const Path& path)
+{
+	Resource* resource = get(path);
+	if (resource) unload(*resource);
+}
+
+
+void ResourceManagerBase::unload(Resource& resource)
+{
+	int new_ref_count = resource.remRef();
+	ASSERT(new_ref_count >= 0);
+	if (new_ref_count == 0 && m_is_unload_enabled) resource.doUnload();
+}
+
+
+void ResourceManagerBase::reload(const Path& path)
+{
+	Resource* resource = get(path);
+	if (resource) reload(*resource);
+}
+
+
+void ResourceManagerBase::reload(Resource& resource)
+{
+	resource.doUnload();
+	resource.doLoad();
+}
+
+
+ResourceManager::ResourceManager(IAllocator& allocator)
+	: m_allocator(allocator)
+	, m_resource_managers(m_allocator)
+	, m_file_system(nullptr)
+{
+}
+
+
+ResourceManager::~ResourceManager() = default;
+
+
+void ResourceManager::create(FS::FileSystem& fs)
+{
+	m_file_system = &fs;
+}
+
+
+void ResourceManager::destroy()
+{
+	m_resource_managers.clear();
+}
+
+
+ResourceManagerBase* ResourceManager::get(ResourceType type)
+{
+	auto it = m_resource_managers.find(type.type);
+	if (it == m_resource_managers.end()) return nullptr;
+	return it.value();
+}
+
+
+void ResourceManager::add(ResourceType type, ResourceManagerBase* rm)
+{
+	m_resource_managers.insert(type.type, rm);
+}
+
+
+void ResourceManager::remove(ResourceType type)
+{
+	m_resource_managers.erase(type.type);
+}
+
+
+void ResourceManager::reload(const Path& path)
+{
+	for (auto iter = m_resource_managers.begin(), end = m_resource_managers.end(); iter != end; ++iter)
+	{
+		iter.value()->reload(path);
+	}
+}
+
+
+void ResourceManager::removeUnreferenced()
+{
+	for (auto iter = m_resource_managers.begin(), end = m_resource_managers.end(); iter != end; ++iter)
+	{
+		iter.value()->removeUnreferenced();
+	}
+}
+
+
+void ResourceManager::enableUnload(bool enable)
+{
+	for (auto iter = m_resource_managers.begin(), end = m_resource_managers.end(); iter != end; ++iter)
+	{
+		iter.value()->enableUnload(enable);
+	}
+}
+
+
+} // namespace Lumix
@@ -0,0 +1,184 @@
+#include "engine/iallocator.h"
+#include "engine/mt/sync.h"
+#include "engine/mt/task.h"
+#include "engine/mt/thread.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+
+namespace Lumix
+{
+namespace MT
+{
+
+
+SpinMutex::SpinMutex(bool locked)
+	: m_id(locked ? 1 : 0)
+{
+}
+
+
+void SpinMutex::lock()
+{
+	while (!poll()) std::this_thread::yield();
+}
+
+
+bool SpinMutex::poll()
+{
+	return __sync_bool_compare_and_swap(&m_id, 0, 1);
+}
+
+
+void SpinMutex::unlock()
+{
+	__sync_lock_release(&m_id);
+}
+
+
+struct SemaphoreImpl
+{
+	std::mutex mutex;
+	std::condition_variable cv;
+	int count;
+	int max_count;
+};
+
+
+Semaphore::Semaphore(int init_count, int max_count)
+{
+	auto* impl = new SemaphoreImpl;
+	impl->count = init_count;
+	impl->max_count = max_count;
+	m_id = impl;
+}
+
+
+Semaphore::~Semaphore()
+{
+	delete (SemaphoreImpl*)m_id;
+}
+
+
+void Semaphore::signal()
+{
+	auto* impl = (SemaphoreImpl*)m_id;
+	{
+		std::lock_guard<std::mutex> lock(impl->mutex);
+		if (impl->count < impl->max_count) ++impl->count;
+	}
+	impl->cv.notify_one();
+}
+
+
+void Semaphore::wait()
+{
+	auto* impl = (SemaphoreImpl*)m_id;
+	std::unique_lock<std::mutex> lock(impl->mutex);
+	impl->cv.wait(lock, [impl] { return impl->count > 0; });
+	--impl->count;
+}
+
+
+bool Semaphore::poll()
+{
+	auto* impl = (SemaphoreImpl*)m_id;
+	std::lock_guard<std::mutex> lock(impl->mutex);
+	if (impl->count == 0) return false;
+	--impl->count;
+	return true;
+}
+
+
+struct TaskImpl
+{
+	explicit TaskImpl(IAllocator& _allocator)
+		: allocator(_allocator)
+		, is_running(false)
+		, is_finished(false)
+	{
+	}
+
+	IAllocator& allocator;
+	std::thread thread;
+	std::atomic<bool> is_running;
+	std::atomic<bool> is_finished;
+};
+
+
+Task::Task(IAllocator& allocator)
+{
+	m_implementation = LUMIX_NEW(allocator, TaskImpl)(allocator);
+}
+
+
+Task::~Task()
+{
+	ASSERT(!m_implementation->thread.joinable());
+	LUMIX_DELETE(m_implementation->allocator, m_implementation);
+}
+
+
+bool Task::create(const char* name)
+{
+	TaskImpl* impl = m_implementation;
+	impl->is_running = true;
+	impl->is_finished = false;
+	impl->thread = std::thread([this, impl] {
+		task();
+		impl->is_finished = true;
+		impl->is_running = false;
+	});
+	return true;
+}
+
+
+bool Task::destroy()
+{
+	if (m_implementation->thread.joinable()) m_implementation->thread.join();
+	return true;
+}
+
+
+bool Task::isRunning() const
+{
+	return m_implementation->is_running;
+}
+
+
+bool Task::isFinished() const
+{
+	return m_implementation->is_finished;
+}
+
+
+IAllocator& Task::getAllocator()
+{
+	return m_implementation->allocator;
+}
+
+
+void sleep(u32 milliseconds)
+{
+	std::this_thread::sleep_for(std::chrono::milliseconds(milliseconds));
+}
+
+
+void yield()
+{
+	std::this_thread::yield();
+}
+
+
+ThreadID getCurrentThreadID()
+{
+	return (ThreadID)std::hash<std::thread::id>()(std::this_thread::get_id());
+}
+
+
+} // namespace MT
+} // namespace Lumix
@@ -0,0 +1,257 @@
+#include "bench.h"
+#include "bench_engine.h"
+#include "engine/blob.h"
+#include "js_gc_scheduler.h"
+#include "js_heap_monitor.h"
+#include "js_script_system.h"
+
+
+namespace Lumix
+{
+
+
+static const float TIME_DELTA = 1 / 60.0f;
+static const int WARMUP_FRAMES = 10;
+
+
+// steers the mover, a component lookup through the entity proxy and Vec3 round trip each frame
+static const char* MOVER_SCRIPT =
+	"({\n"
+	"	entity : _entity,\n"
+	"	time : 0,\n"
+	"	phase : _entity.c_entity * 0.1,\n"
+	"	update : function(time_delta) {\n"
+	"		this.time += time_delta;\n"
+	"		var m = this.entity.mover;\n"
+	"		var v = m.Velocity;\n"
+	"		v[0] = Math.sin(this.time + this.phase) * m.Speed;\n"
+	"		v[2] = Math.cos(this.time + this.phase) * m.Speed;\n"
+	"		m.Velocity = v;\n"
+	"	}\n"
+	"})";
+
+
+// MOVER_SCRIPT after an edit, for the hot reload
+static const char* MOVER_SCRIPT_EDITED =
+	"({\n"
+	"	entity : _entity,\n"
+	"	time : 0,\n"
+	"	phase : _entity.c_entity * 0.1,\n"
+	"	update : function(time_delta) {\n"
+	"		this.time += time_delta;\n"
+	"		var m = this.entity.mover;\n"
+	"		var v = m.Velocity;\n"
+	"		v[0] = Math.cos(this.time + this.phase) * m.Speed;\n"
+	"		v[2] = Math.sin(this.time + this.phase) * m.Speed;\n"
+	"		m.Velocity = v;\n"
+	"	}\n"
+	"})";
+
+
+// MOVER_SCRIPT as a class, the instances share the prototype
+static const char* MOVER_CLASS_SCRIPT =
+	"function Mover(entity) {\n"
+	"	this.entity = entity;\n"
+	"	this.time = 0;\n"
+	"	this.phase = entity.c_entity * 0.1;\n"
+	"}\n"
+	"Mover.prototype.update = function(time_delta) {\n"
+	"	this.time += time_delta;\n"
+	"	var m = this.entity.mover;\n"
+	"	var v = m.Velocity;\n"
+	"	v[0] = Math.sin(this.time + this.phase) * m.Speed;\n"
+	"	v[2] = Math.cos(this.time + this.phase) * m.Speed;\n"
+	"	m.Velocity = v;\n"
+	"};\n"
+	"Mover";
+
+
+// pure script state, strings and a growing/shrinking array
+static const char* AI_SCRIPT =
+	"({\n"
+	"	state : 'idle',\n"
+	"	timer : _entity.c_entity % 7 * 0.05,\n"
+	"	health : 100,\n"
+	"	targets : [],\n"
+	"	update : function(time_delta) {\n"
+	"		this.timer -= time_delta;\n"
+	"		if (this.timer > 0) return;\n"
+	"		this.timer = 0.25;\n"
+	"		switch (this.state) {\n"
+	"			case 'idle': this.state = 'patrol'; break;\n"
+	"			case 'patrol':\n"
+	"				this.targets.push({ id : this.targets.length, distance : this.health });\n"
+	"				if (this.targets.length > 4) this.state = 'attack';\n"
+	"				break;\n"
+	"			case 'attack':\n"
+	"				this.targets.shift();\n"
+	"				this.health -= 1;\n"
+	"				if (this.targets.length == 0) this.state = 'idle';\n"
+	"				break;\n"
+	"		}\n"
+	"	}\n"
+	"})";
+
+
+// keeps a cached component object, scalar property writes every frame
+static const char* STATS_SCRIPT =
+	"({\n"
+	"	mover : _entity.mover,\n"
+	"	frames : 0,\n"
+	"	history : [0, 0, 0, 0, 0, 0, 0, 0],\n"
+	"	update : function(time_delta) {\n"
+	"		this.frames++;\n"
+	"		this.history[this.frames & 7] = time_delta;\n"
+	"		if ((this.frames & 15) == 0) this.mover.Target = this.frames;\n"
+	"		this.mover.Speed = 1 + (this.frames & 3);\n"
+	"	}\n"
+	"})";
+
+
+struct StressScripts
+{
+	explicit StressScripts(BenchEngine& engine)
+		: library(engine)
+	{
+		scripts[0] = engine.addScript("bench/stress/mover.js", MOVER_SCRIPT);
+		scripts[1] = engine.addScript("bench/stress/ai.js", AI_SCRIPT);
+		scripts[2] = engine.addScript("bench/stress/stats.js", STATS_SCRIPT);
+		mover_class = engine.addScript("bench/stress/mover_class.js", MOVER_CLASS_SCRIPT);
+
+		// keeps the scripts loaded and compiled for the whole run, like the prefabs of a level
+		library.createEntities(1, true);
+		for (const Path& path : scripts) library.addScript({0}, path);
+		library.addScript({0}, mover_class);
+	}
+
+	BenchUniverse library;
+	Path scripts[3];
+	Path mover_class;
+};
+
+
+static u64 getHeapBytes(BenchUniverse& universe)
+{
+	duk_gc(universe.getContext(), 0);
+	return universe.getScriptScene().getHeapMonitor().getStats().live_bytes;
+}
+
+
+// entity i has 1 + i % 3 scripts
+static void runScenario(Bench::Runner& runner,
+	DefaultAllocator& allocator,
+	BenchEngine& engine,
+	StressScripts& scripts,
+	int entity_count)
+{
+	BenchUniverse universe(engine);
+	universe.createEntities(entity_count, true);
+
+	int instance_count = 0;
+	for (int i = 0; i < entity_count; ++i) instance_count += 1 + i % 3;
+
+	u64 heap_before = getHeapBytes(universe);
+	u64 total_before = allocator.getLiveBytes();
+
+	runner.measureOnce("stress_instantiate", entity_count, instance_count, [&]() {
+		for (int i = 0; i < entity_count; ++i)
+		{
+			for (int j = 0; j <= i % 3; ++j) universe.addScript({i}, scripts.scripts[j]);
+		}
+	});
+	runner.expect("stress_instantiate", entity_count, "instances running", universe.getActiveCount(), instance_count);
+
+	u64 heap_bytes = getHeapBytes(universe) - heap_before;
+	u64 total_bytes = allocator.getLiveBytes() - total_before;
+	runner.report("stress_heap_per_instance", entity_count, (double)heap_bytes / instance_count, "bytes");
+	runner.report("stress_native_per_instance", entity_count, (double)(total_bytes - heap_bytes) / instance_count, "bytes");
+
+	JSScriptScene& scene = universe.getScriptScene();
+	for (int i = 0; i < WARMUP_FRAMES; ++i) universe.update(TIME_DELTA);
+	scene.getGCScheduler().resetStats();
+	runner.measure("stress_frame", entity_count, 1, [&](u64 iterations) {
+		for (u64 i = 0; i < iterations; ++i) universe.update(TIME_DELTA);
+	});
+	runner.report("stress_frame_gc_count", entity_count, scene.getHeapMonitor().getFrameStats().gc_count, "count");
+	// collections which paused a script, the default policy defers them to the frame end
+	const JSGCScheduler::Stats& gc_stats = scene.getGCScheduler().getStats();
+	runner.report("stress_gc_in_callback", entity_count, gc_stats.count[(int)JSGCScheduler::Trigger::CALLBACK], "count");
+	runner.report("stress_gc_deferred", entity_count, gc_stats.deferred_count, "count");
+
+	// every entity has the mover script, it needs the entity to evaluate so the instances are restarted
+	bool is_reloaded = false;
+	runner.measureOnce("stress_reload", entity_count, entity_count, [&]() {
+		engine.changeScript(scripts.scripts[0], MOVER_SCRIPT_EDITED);
+		is_reloaded = universe.waitForScripts();
+	});
+	if (!is_reloaded) runner.fail("stress_reload", entity_count, "the reload did not finish");
+	runner.expect("stress_reload", entity_count, "instances running", universe.getActiveCount(), instance_count);
+	universe.update(TIME_DELTA);
+
+	OutputBlob blob(allocator);
+	runner.measureOnce("stress_save", entity_count, instance_count, [&]() { universe.serialize(blob); });
+	runner.report("stress_save_size", entity_count, (double)blob.getPos() / instance_count, "bytes");
+
+	BenchUniverse loaded(engine);
+	loaded.createEntities(entity_count, true);
+	runner.measureOnce("stress_load", entity_count, instance_count, [&]() {
+		InputBlob input(blob.getData(), blob.getPos());
+		loaded.deserialize(input);
+	});
+	runner.expect("stress_load", entity_count, "instances running", loaded.getActiveCount(), instance_count);
+
+	// the next scenario starts with the original mover
+	engine.changeScript(scripts.scripts[0], MOVER_SCRIPT);
+	if (!scripts.library.waitForScripts()) runner.fail("stress_reload", entity_count, "the mover was not restored");
+}
+
+
+// heap of the mover instances, evaluated per instance and as a class
+static void runClassScenario(Bench::Runner& runner, BenchEngine& engine, StressScripts& scripts, int entity_count)
+{
+	static const struct
+	{
+		bool is_class;
+		const char* instantiate_name;
+		const char* heap_name;
+	} VARIANTS[] = {
+		{false, "stress_mover_instantiate", "stress_mover_heap_per_instance"},
+		{true, "stress_mover_class_instantiate", "stress_mover_class_heap_per_instance"},
+	};
+
+	for (const auto& variant : VARIANTS)
+	{
+		const Path& script = variant.is_class ? scripts.mover_class : scripts.scripts[0];
+		BenchUniverse universe(engine);
+		universe.createEntities(entity_count, true);
+
+		u64 heap_before = getHeapBytes(universe);
+		runner.measureOnce(variant.instantiate_name, entity_count, entity_count, [&]() {
+			for (int i = 0; i < entity_count; ++i) universe.addScript({i}, script);
+		});
+		u64 heap_bytes = getHeapBytes(universe) - heap_before;
+		runner.report(variant.heap_name, entity_count, (double)heap_bytes / entity_count, "bytes");
+		runner.expect(variant.instantiate_name, entity_count, "update calls", universe.countUpdates(), entity_count);
+	}
+}
+
+
+void runStressBenchmarks(Bench::Runner& runner, DefaultAllocator& allocator, BenchEngine& engine)
+{
+	static const int ENTITY_COUNTS[] = {1000, 10000, 50000};
+	StressScripts scripts(engine);
+	if (!scripts.library.waitForScripts() || scripts.library.getActiveCount() != 4)
+	{
+		runner.fail("stress", 0, "the scripts did not start");
+		return;
+	}
+	for (int entity_count : ENTITY_COUNTS)
+	{
+		if (runner.isQuick() && entity_count > 10000) break;
+		runScenario(runner, allocator, engine, scripts, entity_count);
+		runClassScenario(runner, engine, scripts, entity_count);
+	}
+}
+
+
+} // namespace Lumix
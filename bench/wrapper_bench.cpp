@@ -0,0 +1,472 @@
+#include "bench.h"
+#include "bench_engine.h"
+#include "js_wrapper.h"
+
+
+namespace Lumix
+{
+
+
+static volatile int g_sink = 0;
+static const int MAX_ARITY = 6;
+static const u64 WARM_UP_ITERATIONS = 10000;
+
+
+// sample value and the hand-written duktape equivalent of checkArg/push for each type
+template <typename T> struct Arg;
+
+
+template <> struct Arg<int>
+{
+	static const char* name() { return "int"; }
+	static int sample() { return 1; }
+	static void pushSample(duk_context* ctx) { duk_push_int(ctx, 1); }
+	static int get(duk_context* ctx, int idx) { return duk_require_int(ctx, idx); }
+	static void push(duk_context* ctx, int value) { duk_push_int(ctx, value); }
+	static int sink(int value) { return value; }
+};
+
+
+template <> struct Arg<float>
+{
+	static const char* name() { return "float"; }
+	static float sample() { return 1.5f; }
+	static void pushSample(duk_context* ctx) { duk_push_number(ctx, 1.5); }
+	static float get(duk_context* ctx, int idx) { return (float)duk_require_number(ctx, idx); }
+	static void push(duk_context* ctx, float value) { duk_push_number(ctx, value); }
+	static int sink(float value) { return (int)value; }
+};
+
+
+template <> struct Arg<const char*>
+{
+	static const char* name() { return "string"; }
+	static const char* sample() { return "sample"; }
+	static void pushSample(duk_context* ctx) { duk_push_string(ctx, "sample"); }
+	static const char* get(duk_context* ctx, int idx) { return duk_require_string(ctx, idx); }
+	static void push(duk_context* ctx, const char* value) { duk_push_string(ctx, value); }
+	static int sink(const char* value) { return value[0]; }
+};
+
+
+template <> struct Arg<Vec3>
+{
+	static const char* name() { return "vec3"; }
+	static Vec3 sample() { return {1, 2, 3}; }
+
+	static void pushSample(duk_context* ctx) { push(ctx, sample()); }
+
+	static Vec3 get(duk_context* ctx, int idx)
+	{
+		if (!duk_is_array(ctx, idx)) duk_error(ctx, DUK_ERR_TYPE_ERROR, "expected Vec3");
+		Vec3 v;
+		duk_get_prop_index(ctx, idx, 0);
+		duk_get_prop_index(ctx, idx, 1);
+		duk_get_prop_index(ctx, idx, 2);
+		v.x = (float)duk_require_number(ctx, -3);
+		v.y = (float)duk_require_number(ctx, -2);
+		v.z = (float)duk_require_number(ctx, -1);
+		duk_pop_3(ctx);
+		return v;
+	}
+
+	static void push(duk_context* ctx, const Vec3& value)
+	{
+		duk_idx_t idx = duk_push_array(ctx);
+		duk_push_number(ctx, value.x);
+		duk_put_prop_index(ctx, idx, 0);
+		duk_push_number(ctx, value.y);
+		duk_put_prop_index(ctx, idx, 1);
+		duk_push_number(ctx, value.z);
+		duk_put_prop_index(ctx, idx, 2);
+	}
+
+	static int sink(const Vec3& value) { return (int)value.x; }
+};
+
+
+template <> struct Arg<void*>
+{
+	static const char* name() { return "pointer"; }
+	static void* sample() { return (void*)&g_sink; }
+	static void pushSample(duk_context* ctx) { duk_push_pointer(ctx, sample()); }
+	static void* get(duk_context* ctx, int idx) { return duk_require_pointer(ctx, idx); }
+	static void push(duk_context* ctx, void* value) { duk_push_pointer(ctx, value); }
+	static int sink(void* value) { return value != nullptr; }
+};
+
+
+template <typename T> struct Native
+{
+	typedef Arg<T> A;
+
+	static int f0() { return g_sink; }
+	static int f1(T a) { return A::sink(a); }
+	static int f2(T a, T b) { return A::sink(a) + A::sink(b); }
+	static int f3(T a, T b, T c) { return A::sink(a) + A::sink(b) + A::sink(c); }
+	static int f4(T a, T b, T c, T d) { return A::sink(a) + A::sink(b) + A::sink(c) + A::sink(d); }
+	static int f5(T a, T b, T c, T d, T e) { return A::sink(a) + A::sink(b) + A::sink(c) + A::sink(d) + A::sink(e); }
+	static int f6(T a, T b, T c, T d, T e, T f)
+	{
+		return A::sink(a) + A::sink(b) + A::sink(c) + A::sink(d) + A::sink(e) + A::sink(f);
+	}
+
+	int m0() { return value; }
+	int m1(T a) { return value + A::sink(a); }
+	int m2(T a, T b) { return value + A::sink(a) + A::sink(b); }
+	int m3(T a, T b, T c) { return value + A::sink(a) + A::sink(b) + A::sink(c); }
+	int m4(T a, T b, T c, T d) { return value + A::sink(a) + A::sink(b) + A::sink(c) + A::sink(d); }
+	int m5(T a, T b, T c, T d, T e) { return value + A::sink(a) + A::sink(b) + A::sink(c) + A::sink(d) + A::sink(e); }
+	int m6(T a, T b, T c, T d, T e, T f)
+	{
+		return value + A::sink(a) + A::sink(b) + A::sink(c) + A::sink(d) + A::sink(e) + A::sink(f);
+	}
+
+	int value;
+};
+
+
+// what a binding looks like without JSWrapper
+template <typename T> struct Raw
+{
+	typedef Arg<T> A;
+	typedef Native<T> N;
+
+	static int f0(duk_context* ctx)
+	{
+		duk_push_int(ctx, N::f0());
+		return 1;
+	}
+
+	static int f1(duk_context* ctx)
+	{
+		duk_push_int(ctx, N::f1(A::get(ctx, 0)));
+		return 1;
+	}
+
+	static int f2(duk_context* ctx)
+	{
+		duk_push_int(ctx, N::f2(A::get(ctx, 0), A::get(ctx, 1)));
+		return 1;
+	}
+
+	static int f3(duk_context* ctx)
+	{
+		duk_push_int(ctx, N::f3(A::get(ctx, 0), A::get(ctx, 1), A::get(ctx, 2)));
+		return 1;
+	}
+
+	static int f4(duk_context* ctx)
+	{
+		duk_push_int(ctx, N::f4(A::get(ctx, 0), A::get(ctx, 1), A::get(ctx, 2), A::get(ctx, 3)));
+		return 1;
+	}
+
+	static int f5(duk_context* ctx)
+	{
+		duk_push_int(ctx, N::f5(A::get(ctx, 0), A::get(ctx, 1), A::get(ctx, 2), A::get(ctx, 3), A::get(ctx, 4)));
+		return 1;
+	}
+
+	static int f6(duk_context* ctx)
+	{
+		duk_push_int(
+			ctx, N::f6(A::get(ctx, 0), A::get(ctx, 1), A::get(ctx, 2), A::get(ctx, 3), A::get(ctx, 4), A::get(ctx, 5)));
+		return 1;
+	}
+
+	static N* getThis(duk_context* ctx)
+	{
+		duk_push_this(ctx);
+		duk_get_prop_string(ctx, -1, "c_ptr");
+		N* inst = (N*)duk_get_pointer(ctx, -1);
+		duk_pop_2(ctx);
+		return inst;
+	}
+
+	static int m0(duk_context* ctx)
+	{
+		duk_push_int(ctx, getThis(ctx)->m0());
+		return 1;
+	}
+
+	static int m1(duk_context* ctx)
+	{
+		duk_push_int(ctx, getThis(ctx)->m1(A::get(ctx, 0)));
+		return 1;
+	}
+
+	static int m2(duk_context* ctx)
+	{
+		duk_push_int(ctx, getThis(ctx)->m2(A::get(ctx, 0), A::get(ctx, 1)));
+		return 1;
+	}
+
+	static int m3(duk_context* ctx)
+	{
+		duk_push_int(ctx, getThis(ctx)->m3(A::get(ctx, 0), A::get(ctx, 1), A::get(ctx, 2)));
+		return 1;
+	}
+
+	static int m4(duk_context* ctx)
+	{
+		duk_push_int(ctx, getThis(ctx)->m4(A::get(ctx, 0), A::get(ctx, 1), A::get(ctx, 2), A::get(ctx, 3)));
+		return 1;
+	}
+
+	static int m5(duk_context* ctx)
+	{
+		duk_push_int(
+			ctx, getThis(ctx)->m5(A::get(ctx, 0), A::get(ctx, 1), A::get(ctx, 2), A::get(ctx, 3), A::get(ctx, 4)));
+		return 1;
+	}
+
+	static int m6(duk_context* ctx)
+	{
+		N* inst = getThis(ctx);
+		duk_push_int(
+			ctx, inst->m6(A::get(ctx, 0), A::get(ctx, 1), A::get(ctx, 2), A::get(ctx, 3), A::get(ctx, 4), A::get(ctx, 5)));
+		return 1;
+	}
+};
+
+
+#define WRAP(F) &JSWrapper::wrap<decltype(&Native<T>::F), &Native<T>::F>
+#define WRAP_METHOD(F) &JSWrapper::wrapMethod<Native<T>, decltype(&Native<T>::F), &Native<T>::F>
+
+
+// calls o.f(a, ...) count times from a JS loop, the loop itself is measured by the js_call cases
+static void pushCallLoop(duk_context* ctx, int arity)
+{
+	char src[256];
+	copyString(src, "(function(o, a, count) { for (var i = 0; i < count; ++i) o.f(");
+	for (int i = 0; i < arity; ++i) catString(src, i == 0 ? "a" : ", a");
+	catString(src, "); })");
+	duk_eval_string(ctx, src);
+}
+
+
+class WrapperBench
+{
+public:
+	WrapperBench(Bench::Runner& runner, duk_context* ctx)
+		: m_runner(runner)
+		, m_ctx(ctx)
+	{
+		// referenced from the stash so they are not collected
+		duk_push_global_stash(m_ctx);
+		duk_push_array(m_ctx);
+		for (int i = 0; i <= MAX_ARITY; ++i)
+		{
+			pushCallLoop(m_ctx, i);
+			m_call_loops[i] = duk_get_heapptr(m_ctx, -1);
+			duk_put_prop_index(m_ctx, -2, (duk_uarridx_t)i);
+		}
+		duk_put_prop_string(m_ctx, -2, "wrapper_bench_loops");
+		duk_pop(m_ctx);
+	}
+
+
+	// [] -> [o, a], o.f = func, o.c_ptr = inst
+	void pushCallArgs(duk_c_function func, void* inst, void (*push_arg)(duk_context*))
+	{
+		duk_context* ctx = m_ctx;
+		duk_push_object(ctx);
+		duk_push_pointer(ctx, inst);
+		duk_put_prop_string(ctx, -2, "c_ptr");
+		duk_push_c_function(ctx, func, DUK_VARARGS);
+		duk_put_prop_string(ctx, -2, "f");
+		push_arg(ctx);
+	}
+
+
+	// [] -> [], runs o.f(a...) with f = func and o.c_ptr = inst
+	double measureCall(const char* name, int arity, duk_c_function func, void* inst, void (*push_arg)(duk_context*))
+	{
+		pushCallArgs(func, inst, push_arg);
+		double result = measureLoop(name, arity);
+		duk_pop_2(m_ctx);
+		return result;
+	}
+
+
+	// [] -> [], runs both sides of a wrapped/raw pair unmeasured, otherwise the first one measured
+	// pays for cold caches and the overhead of the pair comes out negative
+	void warmUpPair(int arity, duk_c_function wrapped, duk_c_function raw, void* inst, void (*push_arg)(duk_context*))
+	{
+		const duk_c_function funcs[] = {wrapped, raw};
+		for (duk_c_function func : funcs)
+		{
+			pushCallArgs(func, inst, push_arg);
+			runLoop(arity, WARM_UP_ITERATIONS);
+			duk_pop_2(m_ctx);
+		}
+	}
+
+
+	// [o, a] -> [o, a]
+	void runLoop(int arity, u64 iterations)
+	{
+		duk_context* ctx = m_ctx;
+		duk_push_heapptr(ctx, m_call_loops[arity]);
+		duk_dup(ctx, -3);
+		duk_dup(ctx, -3);
+		duk_push_number(ctx, (double)iterations);
+		if (duk_pcall(ctx, 3) != DUK_EXEC_SUCCESS)
+		{
+			g_log_error.log("JS Script") << duk_safe_to_string(ctx, -1);
+		}
+		duk_pop(ctx);
+	}
+
+
+	// [o, a] -> [o, a]
+	double measureLoop(const char* name, int arity)
+	{
+		return m_runner.measure(name, arity, 1, [&](u64 iterations) { runLoop(arity, iterations); });
+	}
+
+
+	void measureJSCalls()
+	{
+		duk_context* ctx = m_ctx;
+		for (int i = 0; i <= MAX_ARITY; ++i)
+		{
+			duk_eval_string(ctx, "({ f : function() { return 0; } })");
+			duk_push_int(ctx, 1);
+			measureLoop("js_call", i);
+			duk_pop_2(ctx);
+		}
+	}
+
+
+	void reportOverhead(const char* prefix, const char* type_name, int arity, double wrapped, double raw)
+	{
+		if (wrapped < 0 || raw < 0) return;
+		char name[64];
+		copyString(name, prefix);
+		catString(name, type_name);
+		m_runner.report(name, arity, wrapped - raw, "ns");
+	}
+
+
+	template <typename T> void measureType()
+	{
+		typedef Raw<T> R;
+		const duk_c_function wrapped[] = {WRAP(f0), WRAP(f1), WRAP(f2), WRAP(f3), WRAP(f4), WRAP(f5), WRAP(f6)};
+		const duk_c_function raw[] = {&R::f0, &R::f1, &R::f2, &R::f3, &R::f4, &R::f5, &R::f6};
+		const duk_c_function wrapped_methods[] = {
+			WRAP_METHOD(m0), WRAP_METHOD(m1), WRAP_METHOD(m2), WRAP_METHOD(m3), WRAP_METHOD(m4), WRAP_METHOD(m5), WRAP_METHOD(m6)};
+		const duk_c_function raw_methods[] = {&R::m0, &R::m1, &R::m2, &R::m3, &R::m4, &R::m5, &R::m6};
+
+		const char* type_name = Arg<T>::name();
+		Native<T> inst;
+		inst.value = 1;
+		char name[64];
+		for (int arity = 0; arity <= MAX_ARITY; ++arity)
+		{
+			// arity 0 does not depend on the type
+			if (arity == 0 && !equalStrings(type_name, "int")) continue;
+
+			warmUpPair(arity, wrapped[arity], raw[arity], nullptr, &Arg<T>::pushSample);
+			makeName(name, "wrap_", type_name);
+			double wrap_time = measureCall(name, arity, wrapped[arity], nullptr, &Arg<T>::pushSample);
+			makeName(name, "raw_", type_name);
+			double raw_time = measureCall(name, arity, raw[arity], nullptr, &Arg<T>::pushSample);
+			reportOverhead("wrap_overhead_", type_name, arity, wrap_time, raw_time);
+
+			warmUpPair(arity, wrapped_methods[arity], raw_methods[arity], &inst, &Arg<T>::pushSample);
+			makeName(name, "wrap_method_", type_name);
+			wrap_time = measureCall(name, arity, wrapped_methods[arity], &inst, &Arg<T>::pushSample);
+			makeName(name, "raw_method_", type_name);
+			raw_time = measureCall(name, arity, raw_methods[arity], &inst, &Arg<T>::pushSample);
+			reportOverhead("wrap_method_overhead_", type_name, arity, wrap_time, raw_time);
+		}
+
+		measureConversions<T>();
+	}
+
+
+	// checkArg and push called directly from C++, without a JS call around them
+	template <typename T> void measureConversions()
+	{
+		duk_context* ctx = m_ctx;
+		const char* type_name = Arg<T>::name();
+		char name[64];
+		int sink = 0;
+
+		Arg<T>::pushSample(ctx);
+		// absolute index, ToType<Vec3> pushes while reading so -1 would not stay valid
+		duk_idx_t idx = duk_get_top_index(ctx);
+		auto check_arg = [&](u64 iterations) {
+			for (u64 i = 0; i < iterations; ++i) sink += Arg<T>::sink(JSWrapper::checkArg<T>(ctx, idx));
+		};
+		auto raw_get = [&](u64 iterations) {
+			for (u64 i = 0; i < iterations; ++i) sink += Arg<T>::sink(Arg<T>::get(ctx, idx));
+		};
+		check_arg(WARM_UP_ITERATIONS);
+		raw_get(WARM_UP_ITERATIONS);
+		makeName(name, "check_arg_", type_name);
+		double wrapped = m_runner.measure(name, 1, 1, check_arg);
+		makeName(name, "raw_get_", type_name);
+		double raw = m_runner.measure(name, 1, 1, raw_get);
+		reportOverhead("check_arg_overhead_", type_name, 1, wrapped, raw);
+		duk_pop(ctx);
+
+		T value = Arg<T>::sample();
+		auto push = [&](u64 iterations) {
+			for (u64 i = 0; i < iterations; ++i)
+			{
+				JSWrapper::push(ctx, value);
+				duk_pop(ctx);
+			}
+		};
+		auto raw_push = [&](u64 iterations) {
+			for (u64 i = 0; i < iterations; ++i)
+			{
+				Arg<T>::push(ctx, value);
+				duk_pop(ctx);
+			}
+		};
+		push(WARM_UP_ITERATIONS);
+		raw_push(WARM_UP_ITERATIONS);
+		makeName(name, "push_", type_name);
+		wrapped = m_runner.measure(name, 1, 1, push);
+		makeName(name, "raw_push_", type_name);
+		raw = m_runner.measure(name, 1, 1, raw_push);
+		reportOverhead("push_overhead_", type_name, 1, wrapped, raw);
+		g_sink = sink;
+	}
+
+private:
+	static void makeName(char (&name)[64], const char* prefix, const char* type_name)
+	{
+		copyString(name, prefix);
+		catString(name, type_name);
+	}
+
+	Bench::Runner& m_runner;
+	duk_context* m_ctx;
+	void* m_call_loops[MAX_ARITY + 1];
+};
+
+
+#undef WRAP
+#undef WRAP_METHOD
+
+
+void runWrapperBenchmarks(Bench::Runner& runner, BenchEngine& engine)
+{
+	BenchUniverse universe(engine);
+	WrapperBench bench(runner, universe.getContext());
+
+	bench.measureJSCalls();
+	bench.measureType<int>();
+	bench.measureType<float>();
+	bench.measureType<const char*>();
+	bench.measureType<Vec3>();
+	bench.measureType<void*>();
+}
+
+
+} // namespace Lumix
@@ -11,3 +11,19 @@ project "lumixengine_js"
 	links { "engine" }
 	useLua()
 	defaultConfigurations()
+
+project "lumixengine_js_bench"
+	kind "ConsoleApp"
+	files {
+		"bench/**.cpp",
+		"bench/**.h",
+		"src/duktape/duktape.c",
+		"src/*.cpp",
+		"src/*.h",
+		"genie.lua"
+	}
+	includedirs { "../../lumixengine_js/bench/mock", "../../lumixengine_js/src", }
+	configuration { "linux-*" }
+		links { "pthread" }
+	configuration {}
+	defaultConfigurations()
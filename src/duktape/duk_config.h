@@ -2939,6 +2939,54 @@ typedef struct duk_hthread duk_context;
 
 /* __OVERRIDE_DEFINES__ */
 
+/* Lumix: the sampling profiler (js_profiler.cpp) runs from the execution
+ * timeout check, which never reports a timeout.  The interrupt is taken
+ * every lumix_duk_interrupt_interval bytecode instructions, zero meaning
+ * DUK_HTHREAD_INTCTR_DEFAULT, and must not call back into Duktape,
+ * lumix_duk_get_callstack reads the call stack.
+ */
+#define DUK_USE_INTERRUPT_COUNTER
+#define DUK_USE_EXEC_TIMEOUT_CHECK(udata) lumix_duk_interrupt((udata))
+#define DUK_USE_LUMIX_INTERRUPT_INTERVAL(udata) lumix_duk_interrupt_interval((udata))
+
+/* Lumix: mark-and-sweep telemetry (js_heap_monitor.cpp), called with
+ * the heap udata.  The hooks must not call back into Duktape.
+ */
+#define DUK_USE_LUMIX_GC_BEGIN(udata) lumix_duk_gc_begin((udata))
+#define DUK_USE_LUMIX_GC_END(udata,objects,strings) lumix_duk_gc_end((udata), (objects), (strings))
+
+/* Lumix: frame-aware GC scheduling (js_gc_scheduler.cpp).  Called when
+ * a voluntary mark-and-sweep is due, returning zero defers it.  Emergency
+ * collections on allocation failure are not affected.
+ */
+#define DUK_USE_LUMIX_GC_VOLUNTARY(udata) lumix_duk_gc_voluntary((udata))
+
+/* Lumix: heaps created with a NULL udata, e.g. the compile-only heap of
+ * js_compiler.cpp, are not tracked and the hooks ignore them.
+ */
+
+/* Lumix: an activation of the running thread, the strings are owned by the
+ * function and NULL if it has no name or file name.
+ */
+typedef struct {
+	const char *name;
+	const char *file_name;
+	duk_uint_t line;
+} lumix_duk_frame;
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+extern int lumix_duk_interrupt(void *udata);
+extern duk_int_t lumix_duk_interrupt_interval(void *udata);
+extern duk_int_t lumix_duk_get_callstack(struct duk_hthread *ctx, lumix_duk_frame *frames, duk_int_t max_count);
+extern void lumix_duk_gc_begin(void *udata);
+extern void lumix_duk_gc_end(void *udata, duk_size_t object_count, duk_size_t string_count);
+extern int lumix_duk_gc_voluntary(void *udata);
+#if defined(__cplusplus)
+}
+#endif
+
 /*
  *  Date provider selection
  *
@@ -47542,6 +47542,9 @@ DUK_INTERNAL void duk_heap_mark_and_sweep(duk_heap *heap, duk_small_uint_t flags
 	DUK_ASSERT(heap->ms_running == 0);
 	heap->ms_prevent_count = 1;
 	heap->ms_running = 1;
+#if defined(DUK_USE_LUMIX_GC_BEGIN)
+	DUK_USE_LUMIX_GC_BEGIN(heap->heap_udata);
+#endif
 
 	/*
 	 *  Mark roots, hoping that recursion limit is not normally hit.
@@ -47651,6 +47654,9 @@ DUK_INTERNAL void duk_heap_mark_and_sweep(duk_heap *heap, duk_small_uint_t flags
 	heap->ms_prevent_count = 0;
 	DUK_ASSERT(heap->ms_running == 1);
 	heap->ms_running = 0;
+#if defined(DUK_USE_LUMIX_GC_END)
+	DUK_USE_LUMIX_GC_END(heap->heap_udata, count_keep_obj, count_keep_str);
+#endif
 
 	/*
 	 *  Assertions after
@@ -47733,6 +47739,15 @@ DUK_INTERNAL void duk_heap_mark_and_sweep(duk_heap *heap, duk_small_uint_t flags
 #if defined(DUK_USE_VOLUNTARY_GC)
 DUK_LOCAL DUK_INLINE void duk__check_voluntary_gc(duk_heap *heap) {
 	if (DUK_UNLIKELY(--(heap)->ms_trigger_counter < 0)) {
+#if defined(DUK_USE_LUMIX_GC_VOLUNTARY)
+		/* Lumix: the embedder may defer the collection and run it
+		 * later with duk_gc(); check again after a while.
+		 */
+		if (!DUK_USE_LUMIX_GC_VOLUNTARY(heap->heap_udata)) {
+			heap->ms_trigger_counter = DUK_HEAP_MARK_AND_SWEEP_TRIGGER_SKIP;
+			return;
+		}
+#endif
 #if defined(DUK_USE_DEBUG)
 		if (heap->ms_prevent_count == 0) {
 			DUK_D(DUK_DPRINT("triggering voluntary mark-and-sweep"));
@@ -51685,6 +51700,49 @@ DUK_INTERNAL duk_uint_fast32_t duk_hobject_pc2line_query(duk_context *ctx, duk_i
 }
 
 #endif  /* DUK_USE_PC2LINE */
+
+/* Lumix: call stack of the running thread for the sampling profiler, top
+ * entry first.  Called from the executor interrupt, so it only reads the
+ * activations and touches neither the value stack nor the heap.
+ */
+DUK_EXTERNAL duk_int_t lumix_duk_get_callstack(duk_context *ctx, lumix_duk_frame *frames, duk_int_t max_count) {
+	duk_hthread *thr = ((duk_hthread *) ctx)->heap->curr_thread;
+	duk_int_t count = 0;
+	duk_size_t i;
+
+	if (thr == NULL) {
+		return 0;
+	}
+	for (i = thr->callstack_top; i > 0 && count < max_count; i--) {
+		duk_activation *act = thr->callstack + i - 1;
+		lumix_duk_frame *frame = frames + count++;
+		duk_tval *tv;
+
+		frame->name = NULL;
+		frame->file_name = NULL;
+		frame->line = 0;
+		if (act->func == NULL) {
+			continue;  /* lightfunc */
+		}
+		tv = duk_hobject_find_existing_entry_tval_ptr(thr->heap, act->func, DUK_HTHREAD_STRING_NAME(thr));
+		if (tv != NULL && DUK_TVAL_IS_STRING(tv)) {
+			frame->name = (const char *) DUK_HSTRING_GET_DATA(DUK_TVAL_GET_STRING(tv));
+		}
+		tv = duk_hobject_find_existing_entry_tval_ptr(thr->heap, act->func, DUK_HTHREAD_STRING_FILE_NAME(thr));
+		if (tv != NULL && DUK_TVAL_IS_STRING(tv)) {
+			frame->file_name = (const char *) DUK_HSTRING_GET_DATA(DUK_TVAL_GET_STRING(tv));
+		}
+#if defined(DUK_USE_PC2LINE)
+		tv = duk_hobject_find_existing_entry_tval_ptr(thr->heap, act->func, DUK_HTHREAD_STRING_INT_PC2LINE(thr));
+		if (tv != NULL && DUK_TVAL_IS_BUFFER(tv)) {
+			frame->line = (duk_uint_t) duk__hobject_pc2line_query_raw(thr,
+			                                                          (duk_hbuffer_fixed *) DUK_TVAL_GET_BUFFER(tv),
+			                                                          duk_hthread_get_act_prev_pc(thr, act));
+		}
+#endif
+	}
+	return count;
+}
 #line 1 "duk_hobject_props.c"
 /*
  *  duk_hobject property access functionality.
@@ -72342,7 +72400,15 @@ DUK_LOCAL DUK_NOINLINE DUK_COLD duk_small_uint_t duk__executor_interrupt(duk_hth
 #endif
 
 	retval = DUK__INT_NOACTION;
+#if defined(DUK_USE_LUMIX_INTERRUPT_INTERVAL)
+	/* Lumix: lowered while the sampling profiler runs. */
+	ctr = DUK_USE_LUMIX_INTERRUPT_INTERVAL(thr->heap->heap_udata);
+	if (ctr <= 0) {
+		ctr = DUK_HTHREAD_INTCTR_DEFAULT;
+	}
+#else
 	ctr = DUK_HTHREAD_INTCTR_DEFAULT;
+#endif
 
 	/*
 	 *  Avoid nested calls.  Concretely this happens during debugging, e.g.
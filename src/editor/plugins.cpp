@@ -25,8 +25,15 @@
 #include "engine/resource_manager.h"
 #include "engine/universe/universe.h"
 #include "imgui/imgui.h"
+#include "../js_alloc_tracker.h"
+#include "../js_binding_stats.h"
+#include "../js_bundle.h"
+#include "../js_gc_scheduler.h"
+#include "../js_heap_monitor.h"
+#include "../js_profiler.h"
 #include "../js_script_manager.h"
 #include "../js_script_system.h"
+#include <cfloat>
 #include <cstdlib>
 
 
@@ -477,16 +484,37 @@ struct AssetBrowserPlugin : AssetBrowser::IPlugin
 	}
 
 
+	// the script drops its source once it is compiled, read it from the file then
+	void readSource(JSScript& script)
+	{
+		if (script.hasSource())
+		{
+			copyString(m_text_buffer, script.getSourceCode());
+			return;
+		}
+
+		auto& fs = m_app.getWorldEditor()->getEngine().getFileSystem();
+		auto* file = fs.open(fs.getDefaultDevice(), script.getPath(), FS::Mode::OPEN_AND_READ);
+		if (!file)
+		{
+			g_log_warning.log("JS Script") << "Could not read " << script.getPath();
+			return;
+		}
+		int size = (int)file->size();
+		if (size >= lengthOf(m_text_buffer)) size = lengthOf(m_text_buffer) - 1;
+		file->read(m_text_buffer, size);
+		m_text_buffer[size] = '\0';
+		fs.close(*file);
+	}
+
+
 	bool onGUI(Resource* resource, ResourceType type) override
 	{
 		if (type != JS_SCRIPT_RESOURCE_TYPE) return false;
 
 		auto* script = static_cast<JSScript*>(resource);
 
-		if (m_text_buffer[0] == '\0')
-		{
-			copyString(m_text_buffer, script->getSourceCode());
-		}
+		if (m_text_buffer[0] == '\0') readSource(*script);
 		ImGui::InputTextMultiline("Code", m_text_buffer, sizeof(m_text_buffer), ImVec2(0, 300));
 		if (ImGui::Button("Save"))
 		{
@@ -545,6 +573,15 @@ struct ConsolePlugin LUMIX_FINAL : public StudioApp::IPlugin
 		action->is_selected.bind<ConsolePlugin, &ConsolePlugin::isOpened>(this);
 		app.addWindowAction(action);
 		buf[0] = '\0';
+
+		// edited scripts would be shadowed by a stale bundle
+		getScene()->setBundleEnabled(false);
+	}
+
+
+	JSScriptScene* getScene()
+	{
+		return (JSScriptScene*)app.getWorldEditor()->getUniverse()->getScene(JS_SCRIPT_TYPE);
 	}
 
 
@@ -665,9 +702,60 @@ struct ConsolePlugin LUMIX_FINAL : public StudioApp::IPlugin
 	}
 
 
+	// dir is relative to the project, "" is the project root
+	bool addToBundle(JSBundle::Builder& builder, const char* dir)
+	{
+		IAllocator& allocator = app.getWorldEditor()->getAllocator();
+		auto* iter = PlatformInterface::createFileIterator(dir[0] ? dir : ".", allocator);
+		PlatformInterface::FileInfo info;
+		bool success = true;
+		while (PlatformInterface::getNextFile(iter, &info))
+		{
+			if (info.filename[0] == '.') continue;
+
+			StaticString<MAX_PATH_LENGTH> path(dir, dir[0] ? "/" : "", info.filename);
+			if (info.is_directory)
+			{
+				success = addToBundle(builder, path.data) && success;
+				continue;
+			}
+			if (!PathUtils::hasExtension(path.data, "js")) continue;
+
+			FS::OsFile file;
+			if (!file.open(path.data, FS::Mode::OPEN_AND_READ, allocator))
+			{
+				g_log_error.log("JS Script") << "Failed to open file " << path.data;
+				success = false;
+				continue;
+			}
+			Array<char> data(allocator);
+			data.resize((int)file.size() + 1);
+			file.read(&data[0], file.size());
+			file.close();
+			data.back() = '\0';
+			success = builder.add(path.data, &data[0], data.size() - 1, bundle_with_source) && success;
+		}
+		PlatformInterface::destroyFileIterator(iter);
+		return success;
+	}
+
+
+	void buildBundle()
+	{
+		JSBundle::Builder builder(app.getWorldEditor()->getAllocator());
+		if (!addToBundle(builder, ""))
+		{
+			g_log_error.log("JS Script") << JS_BUNDLE_PATH << " not built, some scripts failed";
+			return;
+		}
+		if (!builder.save(JS_BUNDLE_PATH)) return;
+		g_log_info.log("JS Script") << "Bundled " << builder.getEntryCount() << " scripts to " << JS_BUNDLE_PATH;
+	}
+
+
 	void onWindowGUI() override
 	{
-		auto* scene = (JSScriptScene*)app.getWorldEditor()->getUniverse()->getScene(JS_SCRIPT_TYPE);
+		JSScriptScene* scene = getScene();
 		duk_context* context = scene->getGlobalContext();
 
 		if (ImGui::BeginDock("JS Script console", &opened))
@@ -712,6 +800,16 @@ struct ConsolePlugin LUMIX_FINAL : public StudioApp::IPlugin
 					}
 				}
 			}
+			ImGui::SameLine();
+			if (ImGui::Button("Build bundle")) buildBundle();
+			ImGui::SameLine();
+			ImGui::Checkbox("With source", &bundle_with_source);
+			ImGui::SameLine();
+			bool use_bundle = scene->isBundleEnabled();
+			if (ImGui::Checkbox("Use bundle", &use_bundle) && !scene->setBundleEnabled(use_bundle))
+			{
+				g_log_error.log("JS Script") << "Could not open " << JS_BUNDLE_PATH;
+			}
 			if(insert_value) ImGui::SetKeyboardFocusHere();
 			ImGui::InputTextMultiline("",
 				buf,
@@ -757,12 +855,382 @@ struct ConsolePlugin LUMIX_FINAL : public StudioApp::IPlugin
 	Array<string> autocomplete;
 	bool opened;
 	bool open_autocomplete = false;
+	bool bundle_with_source = false;
 	int autocomplete_selected = 1;
 	const char* insert_value = nullptr;
 	char buf[10 * 1024];
 };
 
 
+struct ProfilerPlugin LUMIX_FINAL : public StudioApp::IPlugin
+{
+	explicit ProfilerPlugin(StudioApp& _app)
+		: app(_app)
+		, opened(false)
+		, alloc_warmup_frames(60)
+	{
+		Action* action = LUMIX_NEW(app.getWorldEditor()->getAllocator(), Action)("JS Script Profiler", "script_profiler");
+		action->func.bind<ProfilerPlugin, &ProfilerPlugin::toggleOpened>(this);
+		action->is_selected.bind<ProfilerPlugin, &ProfilerPlugin::isOpened>(this);
+		app.addWindowAction(action);
+	}
+
+
+	const char* getName() const override { return "script_profiler"; }
+
+
+	bool isOpened() const { return opened; }
+	void toggleOpened() { opened = !opened; }
+
+
+	void showCallbackStats(JSScriptScene& scene, int script_idx, JSScriptScene::Callback callback, const char* name)
+	{
+		const JSScriptScene::CallbackStats& stats = scene.getCallbackStats(script_idx, callback);
+		if (stats.call_count == 0) return;
+
+		float to_ms = 1000.0f / (float)scene.getProfilerFrequency();
+		float total = stats.total_time * to_ms;
+		ImGui::Text("%s", name);
+		ImGui::NextColumn();
+		ImGui::Text("%u", stats.call_count);
+		ImGui::NextColumn();
+		ImGui::Text("%.3f", total);
+		ImGui::NextColumn();
+		ImGui::Text("%.3f", total / stats.call_count);
+		ImGui::NextColumn();
+		ImGui::Text("%.3f", stats.max_time * to_ms);
+		ImGui::NextColumn();
+		ImGui::Text("%d", stats.max_entity.index);
+		ImGui::NextColumn();
+	}
+
+
+	void saveProfile(JSProfiler& profiler, JSProfiler::Format format)
+	{
+		char path[MAX_PATH_LENGTH];
+		bool is_json = format == JSProfiler::Format::SPEEDSCOPE;
+		const char* filter = is_json ? "Speedscope\0*.json\0" : "Collapsed stacks\0*.txt\0";
+		if (PlatformInterface::getSaveFilename(path, lengthOf(path), filter, is_json ? "json" : "txt"))
+		{
+			profiler.save(path, format);
+		}
+	}
+
+
+	void onSamplerGUI(JSProfiler& profiler)
+	{
+		if (!ImGui::CollapsingHeader("Sampler")) return;
+
+		if (profiler.isRunning())
+		{
+			if (ImGui::Button("Stop")) profiler.stop();
+		}
+		else if (ImGui::Button("Start"))
+		{
+			profiler.start();
+		}
+		ImGui::SameLine();
+		if (ImGui::Button("Clear")) profiler.clear();
+		ImGui::SameLine();
+		if (ImGui::Button("Save collapsed")) saveProfile(profiler, JSProfiler::Format::COLLAPSED);
+		ImGui::SameLine();
+		if (ImGui::Button("Save speedscope")) saveProfile(profiler, JSProfiler::Format::SPEEDSCOPE);
+
+		float interval = profiler.getSampleInterval();
+		if (ImGui::DragFloat("Interval (ms)", &interval, 0.1f, 0.01f, 100.0f)) profiler.setSampleInterval(interval);
+		int instructions = profiler.getInterruptInstructions();
+		if (ImGui::DragInt("Interrupt (instructions)", &instructions, 10, 100, 1000000))
+		{
+			profiler.setInterruptInstructions(instructions);
+		}
+		ImGui::Text("Samples: %d", profiler.getSampleCount());
+	}
+
+
+	void onHeapGUI(const JSHeapMonitor& monitor)
+	{
+		if (!ImGui::CollapsingHeader("Heap")) return;
+
+		const JSHeapMonitor::Stats& stats = monitor.getStats();
+		const JSHeapMonitor::FrameStats& frame = monitor.getFrameStats();
+		ImGui::Text("Live: %.2f MB (peak %.2f MB)", stats.live_bytes / (1024.0f * 1024.0f), stats.peak_bytes / (1024.0f * 1024.0f));
+		ImGui::Text("Live allocations: %u", stats.live_allocations);
+		ImGui::Text("Objects: %u, strings: %u", stats.object_count, stats.string_count);
+		ImGui::Text("Allocations: %u per frame, %.2f KB/s", frame.alloc_count, frame.alloc_rate / 1024.0f);
+		ImGui::Text("GC: %u total, %u this frame, %.3f ms this frame", stats.gc_count, frame.gc_count, frame.gc_time);
+		ImGui::Text("GC pause: last %.3f ms, max %.3f ms", stats.last_gc_time, stats.max_gc_time);
+
+		ImGui::PlotLines("GC time (ms)",
+			monitor.getGCTimeHistory(),
+			JSHeapMonitor::HISTORY_SIZE,
+			monitor.getHistoryOffset(),
+			nullptr,
+			0,
+			FLT_MAX,
+			ImVec2(0, 50));
+		ImGui::PlotLines("Live bytes",
+			monitor.getLiveBytesHistory(),
+			JSHeapMonitor::HISTORY_SIZE,
+			monitor.getHistoryOffset(),
+			nullptr,
+			FLT_MAX,
+			FLT_MAX,
+			ImVec2(0, 50));
+	}
+
+
+	static bool getGCPolicyName(void*, int idx, const char** out)
+	{
+		*out = JSGCScheduler::getPolicyName((JSGCScheduler::Policy)idx);
+		return true;
+	}
+
+
+	void onGCSchedulerGUI(JSGCScheduler& scheduler)
+	{
+		if (!ImGui::CollapsingHeader("GC scheduling")) return;
+
+		int policy = (int)scheduler.getPolicy();
+		if (ImGui::Combo("Policy", &policy, &getGCPolicyName, nullptr, (int)JSGCScheduler::Policy::COUNT))
+		{
+			scheduler.setPolicy((JSGCScheduler::Policy)policy);
+		}
+		float budget = scheduler.getBudget();
+		if (ImGui::DragFloat("Budget (ms per frame)", &budget, 0.01f, 0, 100)) scheduler.setBudget(budget);
+		int max_pending_frames = scheduler.getMaxPendingFrames();
+		if (ImGui::InputInt("Max deferred frames", &max_pending_frames)) scheduler.setMaxPendingFrames(max_pending_frames);
+
+		const JSGCScheduler::Stats& stats = scheduler.getStats();
+		ImGui::Text("Deferred: %u", stats.deferred_count);
+		if (scheduler.isPending())
+		{
+			ImGui::SameLine();
+			ImGui::Text("(pending for %d frames)", scheduler.getPendingFrames());
+		}
+		ImGui::SameLine();
+		if (ImGui::Button("Reset##gc")) scheduler.resetStats();
+
+		ImGui::Columns(3);
+		ImGui::Text("Trigger");
+		ImGui::NextColumn();
+		ImGui::Text("Collections");
+		ImGui::NextColumn();
+		ImGui::Text("Time (ms)");
+		ImGui::NextColumn();
+		ImGui::Separator();
+		for (int i = 0; i < (int)JSGCScheduler::Trigger::COUNT; ++i)
+		{
+			ImGui::Text("%s", JSGCScheduler::getTriggerName((JSGCScheduler::Trigger)i));
+			ImGui::NextColumn();
+			ImGui::Text("%u", stats.count[i]);
+			ImGui::NextColumn();
+			ImGui::Text("%.3f", stats.time[i]);
+			ImGui::NextColumn();
+		}
+		ImGui::Columns();
+	}
+
+
+	void onInstancesGUI(JSScriptScene* scene)
+	{
+		if (!ImGui::CollapsingHeader("Instances")) return;
+
+		bool is_lazy = scene->isLazyStart();
+		if (ImGui::Checkbox("Lazy start", &is_lazy)) scene->setLazyStart(is_lazy);
+		ImGui::Text("Dormant: %d", scene->getDormantScriptCount());
+	}
+
+
+	void onAllocationsGUI(JSScriptScene* scene)
+	{
+		if (!ImGui::CollapsingHeader("Allocations")) return;
+
+		JSAllocTracker& tracker = scene->getAllocTracker();
+		if (tracker.isRunning())
+		{
+			if (ImGui::Button("Stop tracking")) tracker.stop();
+		}
+		else
+		{
+			if (ImGui::Button("Start tracking")) tracker.start(alloc_warmup_frames);
+			ImGui::SameLine();
+			ImGui::InputInt("Warm-up frames", &alloc_warmup_frames);
+		}
+		ImGui::Text("Frames with allocations: %u", tracker.getDirtyFrameCount());
+		if (tracker.getSiteCount() == 0) return;
+
+		ImGui::Text("Last at frame %u", tracker.getLastDirtyFrame());
+		ImGui::Columns(6);
+		ImGui::Text("Script");
+		ImGui::NextColumn();
+		ImGui::Text("Site");
+		ImGui::NextColumn();
+		ImGui::Text("Heap count");
+		ImGui::NextColumn();
+		ImGui::Text("Heap bytes");
+		ImGui::NextColumn();
+		ImGui::Text("Engine count");
+		ImGui::NextColumn();
+		ImGui::Text("Engine bytes");
+		ImGui::NextColumn();
+		ImGui::Separator();
+		for (int i = 0, c = tracker.getSiteCount(); i < c; ++i)
+		{
+			const JSAllocTracker::Site& site = tracker.getSite(i);
+			ImGui::Text("%s", site.script < 0 ? "plugin" : scene->getProfiledScriptPath(site.script).c_str());
+			ImGui::NextColumn();
+			ImGui::Text(site.is_binding ? "%s (binding)" : "%s", site.name ? site.name : "unknown");
+			ImGui::NextColumn();
+			ImGui::Text("%u", site.heap_count);
+			ImGui::NextColumn();
+			ImGui::Text("%u", (u32)site.heap_bytes);
+			ImGui::NextColumn();
+			ImGui::Text("%u", site.engine_count);
+			ImGui::NextColumn();
+			ImGui::Text("%u", (u32)site.engine_bytes);
+			ImGui::NextColumn();
+		}
+		ImGui::Columns();
+	}
+
+
+	void showBindingCounter(const char* name, const JSBindingStats::Counter& counter, const JSBindingStats& stats)
+	{
+		ImGui::Text("%s", name);
+		ImGui::NextColumn();
+		ImGui::Text("%u", counter.calls);
+		ImGui::NextColumn();
+		ImGui::Text("%.3f", stats.toMs(counter.time));
+		ImGui::NextColumn();
+	}
+
+
+	void onBindingsGUI(JSScriptScene* scene)
+	{
+		if (!ImGui::CollapsingHeader("Bindings")) return;
+
+		JSBindingStats& stats = scene->getBindingStats();
+		bool is_enabled = stats.isEnabled();
+		if (ImGui::Checkbox("Count calls", &is_enabled)) stats.setEnabled(is_enabled);
+		ImGui::SameLine();
+		if (ImGui::Button("Reset##bindings")) stats.reset();
+
+		// called bindings, by total time
+		Array<int> sorted(app.getWorldEditor()->getAllocator());
+		for (int i = 0, c = stats.getBindingCount(); i < c; ++i)
+		{
+			u64 time = stats.getTotal(i).time;
+			if (stats.getTotal(i).calls == 0) continue;
+
+			int pos = sorted.size();
+			while (pos > 0 && stats.getTotal(sorted[pos - 1]).time < time) --pos;
+			sorted.insert(pos, i);
+		}
+
+		ImGui::Columns(5);
+		ImGui::Text("Binding");
+		ImGui::NextColumn();
+		ImGui::Text("Calls (frame)");
+		ImGui::NextColumn();
+		ImGui::Text("Time (frame, ms)");
+		ImGui::NextColumn();
+		ImGui::Text("Calls");
+		ImGui::NextColumn();
+		ImGui::Text("Time (ms)");
+		ImGui::NextColumn();
+		ImGui::Separator();
+		for (int binding : sorted)
+		{
+			const JSBindingStats::Counter& frame = stats.getLastFrame(binding);
+			showBindingCounter(stats.getBindingName(binding), frame, stats);
+			ImGui::Text("%u", stats.getTotal(binding).calls);
+			ImGui::NextColumn();
+			ImGui::Text("%.3f", stats.toMs(stats.getTotal(binding).time));
+			ImGui::NextColumn();
+		}
+		ImGui::Columns();
+
+		ImGui::PushID("bindings");
+		for (int i = 0, c = stats.getScriptCount(); i < c; ++i)
+		{
+			if (!ImGui::TreeNode((const void*)(intptr_t)i, "%s", scene->getProfiledScriptPath(i).c_str())) continue;
+
+			ImGui::Columns(5);
+			for (int binding : sorted)
+			{
+				const JSBindingStats::Counter& total = stats.getScriptCounter(i, binding);
+				if (total.calls == 0) continue;
+
+				showBindingCounter(stats.getBindingName(binding), stats.getScriptLastFrame(i, binding), stats);
+				ImGui::Text("%u", total.calls);
+				ImGui::NextColumn();
+				ImGui::Text("%.3f", stats.toMs(total.time));
+				ImGui::NextColumn();
+			}
+			ImGui::Columns();
+			ImGui::TreePop();
+		}
+		ImGui::PopID();
+	}
+
+
+	void onWindowGUI() override
+	{
+		auto* scene = (JSScriptScene*)app.getWorldEditor()->getUniverse()->getScene(JS_SCRIPT_TYPE);
+
+		if (ImGui::BeginDock("JS Script profiler", &opened))
+		{
+			onSamplerGUI(scene->getProfiler());
+			onHeapGUI(scene->getHeapMonitor());
+			onGCSchedulerGUI(scene->getGCScheduler());
+			onInstancesGUI(scene);
+			onAllocationsGUI(scene);
+			onBindingsGUI(scene);
+
+			if (ImGui::Button("Reset")) scene->resetCallbackStats();
+
+			for (int i = 0, c = scene->getProfiledScriptCount(); i < c; ++i)
+			{
+				if (!ImGui::TreeNode((const void*)(intptr_t)i, "%s", scene->getProfiledScriptPath(i).c_str())) continue;
+
+				ImGui::Columns(6);
+				ImGui::Text("Callback");
+				ImGui::NextColumn();
+				ImGui::Text("Calls");
+				ImGui::NextColumn();
+				ImGui::Text("Total (ms)");
+				ImGui::NextColumn();
+				ImGui::Text("Mean (ms)");
+				ImGui::NextColumn();
+				ImGui::Text("Max (ms)");
+				ImGui::NextColumn();
+				ImGui::Text("Max entity");
+				ImGui::NextColumn();
+				ImGui::Separator();
+				showCallbackStats(*scene, i, JSScriptScene::Callback::UPDATE, "update");
+				showCallbackStats(*scene, i, JSScriptScene::Callback::START_GAME, "onStartGame");
+				showCallbackStats(*scene, i, JSScriptScene::Callback::DESTROY, "onDestroy");
+				showCallbackStats(*scene, i, JSScriptScene::Callback::GUI, "onGUI");
+				showCallbackStats(*scene, i, JSScriptScene::Callback::DRAW_GIZMO, "onDrawGizmo");
+				showCallbackStats(*scene, i, JSScriptScene::Callback::REUSE, "onReuse");
+				showCallbackStats(*scene, i, JSScriptScene::Callback::EVENT, "events");
+				showCallbackStats(*scene, i, JSScriptScene::Callback::TIMER, "timers");
+				showCallbackStats(*scene, i, JSScriptScene::Callback::MESSAGE, "messages");
+				showCallbackStats(*scene, i, JSScriptScene::Callback::OTHER, "other");
+				ImGui::Columns();
+				ImGui::TreePop();
+			}
+		}
+		ImGui::EndDock();
+	}
+
+
+	StudioApp& app;
+	bool opened;
+	int alloc_warmup_frames;
+};
+
+
 IEditorCommand* createAddScriptCommand(WorldEditor& editor)
 {
 	return LUMIX_NEW(editor.getAllocator(), PropertyGridPlugin::AddScriptCommand)(editor);
@@ -921,6 +1389,9 @@ LUMIX_STUDIO_ENTRY(lumixengine_js)
 
 	auto* console_plugin = LUMIX_NEW(editor.getAllocator(), ConsolePlugin)(app);
 	app.addPlugin(*console_plugin);
+
+	auto* profiler_plugin = LUMIX_NEW(editor.getAllocator(), ProfilerPlugin)(app);
+	app.addPlugin(*profiler_plugin);
 }
 
 
@@ -0,0 +1,191 @@
+#include "js_alloc_tracker.h"
+#include "engine/string.h"
+
+
+namespace Lumix
+{
+
+
+JSAllocTracker::Scope::Scope(JSAllocTracker& _tracker, const char* name)
+	: tracker(_tracker)
+	, prev_name(_tracker.m_site_name)
+	, prev_is_binding(_tracker.m_is_binding)
+	, is_ended(false)
+{
+	tracker.m_site_name = name;
+	tracker.m_is_binding = true;
+}
+
+
+void JSAllocTracker::Scope::end()
+{
+	if (is_ended) return;
+
+	is_ended = true;
+	tracker.m_site_name = prev_name;
+	tracker.m_is_binding = prev_is_binding;
+}
+
+
+JSAllocTracker::JSAllocTracker(IAllocator& source)
+	: m_source(source)
+	, m_is_running(false)
+	, m_is_tracking(false)
+	, m_warmup_frames(0)
+	, m_frame(0)
+	, m_last_dirty_frame(0)
+	, m_dirty_frame_count(0)
+	, m_script(-1)
+	, m_site_name(nullptr)
+	, m_is_binding(false)
+	, m_frame_site_count(0)
+	, m_site_count(0)
+{
+}
+
+
+void* JSAllocTracker::allocate(size_t size)
+{
+	if (m_is_tracking) track(size, false);
+	return m_source.allocate(size);
+}
+
+
+void JSAllocTracker::deallocate(void* ptr)
+{
+	m_source.deallocate(ptr);
+}
+
+
+void* JSAllocTracker::reallocate(void* ptr, size_t size)
+{
+	if (m_is_tracking) track(size, false);
+	return m_source.reallocate(ptr, size);
+}
+
+
+void* JSAllocTracker::allocate_aligned(size_t size, size_t align)
+{
+	if (m_is_tracking) track(size, false);
+	return m_source.allocate_aligned(size, align);
+}
+
+
+void JSAllocTracker::deallocate_aligned(void* ptr)
+{
+	m_source.deallocate_aligned(ptr);
+}
+
+
+void* JSAllocTracker::reallocate_aligned(void* ptr, size_t size, size_t align)
+{
+	if (m_is_tracking) track(size, false);
+	return m_source.reallocate_aligned(ptr, size, align);
+}
+
+
+void JSAllocTracker::onHeapAllocate(size_t size)
+{
+	if (m_is_tracking) track(size, true);
+}
+
+
+void JSAllocTracker::start(int warmup_frames)
+{
+	m_is_running = true;
+	m_warmup_frames = warmup_frames;
+	m_frame = 0;
+	m_last_dirty_frame = 0;
+	m_dirty_frame_count = 0;
+	m_site_count = 0;
+}
+
+
+void JSAllocTracker::stop()
+{
+	m_is_running = false;
+	m_is_tracking = false;
+}
+
+
+void JSAllocTracker::beginFrame()
+{
+	if (!m_is_running) return;
+
+	++m_frame;
+	m_is_tracking = m_frame > (u32)m_warmup_frames;
+	m_frame_site_count = 0;
+}
+
+
+bool JSAllocTracker::endFrame()
+{
+	if (!m_is_tracking) return false;
+
+	m_is_tracking = false;
+	if (m_frame_site_count == 0) return false;
+
+	copyMemory(m_sites, m_frame_sites, sizeof(m_sites[0]) * m_frame_site_count);
+	m_site_count = m_frame_site_count;
+	m_last_dirty_frame = m_frame;
+	++m_dirty_frame_count;
+	return true;
+}
+
+
+void JSAllocTracker::setSite(int script, const char* name, bool is_binding)
+{
+	m_script = script;
+	m_site_name = name;
+	m_is_binding = is_binding;
+}
+
+
+// must not allocate itself
+void JSAllocTracker::track(size_t size, bool is_heap)
+{
+	// see the log or the profiler window for the site
+	ASSERT(!m_is_binding);
+
+	Site* site = nullptr;
+	for (int i = 0; i < m_frame_site_count; ++i)
+	{
+		Site& s = m_frame_sites[i];
+		if (s.script == m_script && s.name == m_site_name)
+		{
+			site = &s;
+			break;
+		}
+	}
+	if (!site)
+	{
+		// the last site collects the overflow
+		if (m_frame_site_count == MAX_SITES)
+		{
+			site = &m_frame_sites[MAX_SITES - 1];
+		}
+		else
+		{
+			site = &m_frame_sites[m_frame_site_count];
+			++m_frame_site_count;
+			setMemory(site, 0, sizeof(*site));
+			site->script = m_script;
+			site->name = m_site_name;
+			site->is_binding = m_is_binding;
+		}
+	}
+
+	if (is_heap)
+	{
+		++site->heap_count;
+		site->heap_bytes += size;
+	}
+	else
+	{
+		++site->engine_count;
+		site->engine_bytes += size;
+	}
+}
+
+
+} // namespace Lumix
@@ -0,0 +1,94 @@
+#pragma once
+
+
+#include "engine/iallocator.h"
+
+
+namespace Lumix
+{
+
+
+// Debug mode for the steady state. It sits between the plugin and its allocator and it
+// is told about script heap allocations by the system. While a frame is tracked each
+// allocation is attributed to the running script and call site. Allocations in a
+// binding scope are asserted, bindings are expected not to allocate after the warm-up.
+class JSAllocTracker LUMIX_FINAL : public IAllocator
+{
+public:
+	static const int MAX_SITES = 64;
+
+	struct Site
+	{
+		int script; // stats index of the script, -1 outside of callbacks
+		const char* name; // callback or binding
+		bool is_binding;
+		u32 heap_count;
+		u64 heap_bytes;
+		u32 engine_count;
+		u64 engine_bytes;
+	};
+
+	// duktape errors longjmp past destructors, end the scope before anything that can throw
+	struct Scope
+	{
+		Scope(JSAllocTracker& _tracker, const char* name);
+		~Scope() { end(); }
+		void end();
+
+		JSAllocTracker& tracker;
+		const char* prev_name;
+		bool prev_is_binding;
+		bool is_ended;
+	};
+
+public:
+	explicit JSAllocTracker(IAllocator& source);
+
+	void* allocate(size_t size) override;
+	void deallocate(void* ptr) override;
+	void* reallocate(void* ptr, size_t size) override;
+	void* allocate_aligned(size_t size, size_t align) override;
+	void deallocate_aligned(void* ptr) override;
+	void* reallocate_aligned(void* ptr, size_t size, size_t align) override;
+	IAllocator& getSourceAllocator() { return m_source; }
+
+	void start(int warmup_frames);
+	void stop();
+	bool isRunning() const { return m_is_running; }
+	void beginFrame();
+	// returns true if the frame allocated after the warm-up
+	bool endFrame();
+	void setSite(int script, const char* name, bool is_binding);
+	int getSiteScript() const { return m_script; }
+	const char* getSiteName() const { return m_site_name; }
+	bool isBindingSite() const { return m_is_binding; }
+	void onHeapAllocate(size_t size);
+
+	// sites of the last frame which allocated
+	int getSiteCount() const { return m_site_count; }
+	const Site& getSite(int idx) const { return m_sites[idx]; }
+	u32 getFrame() const { return m_frame; }
+	u32 getLastDirtyFrame() const { return m_last_dirty_frame; }
+	u32 getDirtyFrameCount() const { return m_dirty_frame_count; }
+
+private:
+	void track(size_t size, bool is_heap);
+
+	IAllocator& m_source;
+	bool m_is_running;
+	bool m_is_tracking;
+	int m_warmup_frames;
+	u32 m_frame;
+	u32 m_last_dirty_frame;
+	u32 m_dirty_frame_count;
+	int m_script;
+	const char* m_site_name;
+	bool m_is_binding;
+	Site m_frame_sites[MAX_SITES];
+	int m_frame_site_count;
+	Site m_sites[MAX_SITES];
+	int m_site_count;
+};
+
+
+} // namespace Lumix
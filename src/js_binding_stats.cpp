@@ -0,0 +1,183 @@
+#include "js_binding_stats.h"
+#include "engine/iallocator.h"
+#include "engine/timer.h"
+
+
+namespace Lumix
+{
+
+
+static const JSBindingStats::Counter EMPTY_COUNTER = {};
+
+
+JSBindingStats::JSBindingStats(IAllocator& allocator)
+	: m_allocator(allocator)
+	, m_bindings(allocator)
+	, m_script_counters(allocator)
+	, m_frame_counters(allocator)
+	, m_last_frame_counters(allocator)
+	, m_script_count(0)
+	, m_script(-1)
+	, m_current(-1)
+	, m_is_enabled(false)
+{
+	m_timer = Timer::create(allocator);
+	m_to_ms = 1000.0f / m_timer->getFrequency();
+}
+
+
+JSBindingStats::~JSBindingStats()
+{
+	Timer::destroy(m_timer);
+}
+
+
+// bindings registered more than once, e.g. property accessors, share the entry
+int JSBindingStats::addBinding(const char* name)
+{
+	for (int i = 0, c = m_bindings.size(); i < c; ++i)
+	{
+		if (equalStrings(m_bindings[i].name.data, name)) return i;
+	}
+
+	Binding& binding = m_bindings.emplace();
+	copyString(binding.name.data, name);
+	binding.total = EMPTY_COUNTER;
+	binding.frame = EMPTY_COUNTER;
+	binding.last_frame = EMPTY_COUNTER;
+
+	// the layout of the per script counters depends on the binding count
+	clearScriptCounters();
+	return m_bindings.size() - 1;
+}
+
+
+void JSBindingStats::reset()
+{
+	for (Binding& binding : m_bindings)
+	{
+		binding.total = EMPTY_COUNTER;
+		binding.frame = EMPTY_COUNTER;
+		binding.last_frame = EMPTY_COUNTER;
+	}
+	clearScriptCounters();
+}
+
+
+void JSBindingStats::clearScriptCounters()
+{
+	m_script_counters.clear();
+	m_frame_counters.clear();
+	m_last_frame_counters.clear();
+	m_script_count = 0;
+}
+
+
+void JSBindingStats::endFrame()
+{
+	for (Binding& binding : m_bindings)
+	{
+		binding.last_frame = binding.frame;
+		binding.frame = EMPTY_COUNTER;
+	}
+
+	for (int idx : m_last_frame_counters) m_script_counters[idx].last_frame = EMPTY_COUNTER;
+	for (int idx : m_frame_counters)
+	{
+		ScriptCounter& counter = m_script_counters[idx];
+		counter.last_frame = counter.frame;
+		counter.frame = EMPTY_COUNTER;
+	}
+	m_last_frame_counters.swap(m_frame_counters);
+	m_frame_counters.clear();
+}
+
+
+u64 JSBindingStats::getTime() const
+{
+	return m_timer->getRawTimeSinceStart();
+}
+
+
+float JSBindingStats::toMs(u64 ticks) const
+{
+	return ticks * m_to_ms;
+}
+
+
+JSBindingStats::State JSBindingStats::beginScript(int script)
+{
+	State state = { m_script, m_current };
+	m_script = script;
+	m_current = -1;
+	return state;
+}
+
+
+void JSBindingStats::endScript(const State& state)
+{
+	m_script = state.script;
+	m_current = state.binding;
+}
+
+
+int JSBindingStats::beginCall(int binding)
+{
+	int prev = m_current;
+	m_current = binding;
+	return prev;
+}
+
+
+int JSBindingStats::endCall(int prev_binding, u64 duration)
+{
+	int binding = m_current;
+	m_current = prev_binding;
+	if (!m_is_enabled || binding < 0) return binding;
+
+	Binding& b = m_bindings[binding];
+	++b.frame.calls;
+	b.frame.time += duration;
+	++b.total.calls;
+	b.total.time += duration;
+
+	if (m_script < 0) return binding;
+	if (m_script >= m_script_count)
+	{
+		int binding_count = m_bindings.size();
+		m_script_counters.resize((m_script + 1) * binding_count);
+		for (int i = m_script_count * binding_count; i < m_script_counters.size(); ++i)
+		{
+			ScriptCounter& counter = m_script_counters[i];
+			counter.total = EMPTY_COUNTER;
+			counter.frame = EMPTY_COUNTER;
+			counter.last_frame = EMPTY_COUNTER;
+		}
+		m_script_count = m_script + 1;
+	}
+	int idx = m_script * m_bindings.size() + binding;
+	ScriptCounter& counter = m_script_counters[idx];
+	if (counter.frame.calls == 0) m_frame_counters.push(idx);
+	++counter.frame.calls;
+	counter.frame.time += duration;
+	++counter.total.calls;
+	counter.total.time += duration;
+	return binding;
+}
+
+
+const JSBindingStats::Counter& JSBindingStats::getScriptCounter(int script, int binding) const
+{
+	if (script < 0 || script >= m_script_count) return EMPTY_COUNTER;
+	return m_script_counters[script * m_bindings.size() + binding].total;
+}
+
+
+const JSBindingStats::Counter& JSBindingStats::getScriptLastFrame(int script, int binding) const
+{
+	if (script < 0 || script >= m_script_count) return EMPTY_COUNTER;
+	return m_script_counters[script * m_bindings.size() + binding].last_frame;
+}
+
+
+} // namespace Lumix
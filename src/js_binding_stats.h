@@ -0,0 +1,106 @@
+#pragma once
+
+
+#include "engine/array.h"
+#include "engine/lumix.h"
+#include "engine/string.h"
+
+
+namespace Lumix
+{
+
+
+class Timer;
+struct IAllocator;
+
+
+// Call counts and cumulative time of native bindings, per frame and per script.
+// Bindings are instrumented where they are registered, see instrumentedBinding.
+class JSBindingStats
+{
+public:
+	struct Counter
+	{
+		u32 calls;
+		u64 time; // timer ticks, see toMs
+	};
+
+public:
+	explicit JSBindingStats(IAllocator& allocator);
+	~JSBindingStats();
+
+	int addBinding(const char* name);
+	int getBindingCount() const { return m_bindings.size(); }
+	const char* getBindingName(int binding) const { return m_bindings[binding].name.data; }
+
+	void setEnabled(bool enabled) { m_is_enabled = enabled; }
+	bool isEnabled() const { return m_is_enabled; }
+	void reset();
+	void endFrame();
+	u64 getTime() const;
+	float toMs(u64 ticks) const;
+
+	// the script and the binding of the outer call, see beginScript
+	struct State
+	{
+		int script;
+		int binding;
+	};
+
+	// stats index of the running script, -1 outside of callbacks. Callbacks run
+	// inside bindings too, e.g. require or a dormant instance woken by getScriptInstance,
+	// so the returned state of the outer call must be passed to endScript
+	State beginScript(int script);
+	// also recovers from bindings which threw, their endCall never runs
+	void endScript(const State& state);
+	// returns the previous binding, which must be passed to endCall
+	int beginCall(int binding);
+	// attributes the running call to a more specific binding, e.g. a component property
+	void redirect(int binding) { m_current = binding; }
+	int getCurrentBinding() const { return m_current; }
+	// returns the binding the call has been attributed to
+	int endCall(int prev_binding, u64 duration);
+
+	const Counter& getTotal(int binding) const { return m_bindings[binding].total; }
+	const Counter& getLastFrame(int binding) const { return m_bindings[binding].last_frame; }
+	int getScriptCount() const { return m_script_count; }
+	// totals since reset
+	const Counter& getScriptCounter(int script, int binding) const;
+	const Counter& getScriptLastFrame(int script, int binding) const;
+
+private:
+	struct Binding
+	{
+		StaticString<64> name;
+		Counter total;
+		Counter frame;
+		Counter last_frame;
+	};
+
+	struct ScriptCounter
+	{
+		Counter total;
+		Counter frame;
+		Counter last_frame;
+	};
+
+private:
+	void clearScriptCounters();
+
+private:
+	IAllocator& m_allocator;
+	Timer* m_timer;
+	Array<Binding> m_bindings;
+	Array<ScriptCounter> m_script_counters; // m_script_count x bindings
+	// indices into m_script_counters, so endFrame does not touch every counter
+	Array<int> m_frame_counters;
+	Array<int> m_last_frame_counters;
+	int m_script_count;
+	int m_script;
+	int m_current;
+	bool m_is_enabled;
+	float m_to_ms;
+};
+
+
+} // namespace Lumix
@@ -0,0 +1,433 @@
+#include "js_bundle.h"
+#include "engine/blob.h"
+#include "engine/crc32.h"
+#include "engine/fs/ifile.h"
+#include "engine/fs/os_file.h"
+#include "engine/iallocator.h"
+#include "engine/log.h"
+#include "engine/path.h"
+#include "engine/string.h"
+#include "js_lz4.h"
+#include "js_script_manager.h"
+
+
+namespace Lumix
+{
+
+
+static const u32 BUNDLE_MAGIC = 0x4e42534a; // "JSBN"
+static const u32 BUNDLE_VERSION = 0;
+static const u32 RECORD_MAGIC = 0x42534a00; // "\0JSB", a source can not start with NUL
+static const u32 RECORD_VERSION = 0;
+
+
+// nullptr if the block does not fit
+static const void* readBlock(InputBlob& blob, int size)
+{
+	if (size < 0 || size > blob.getSize() - blob.getPosition()) return nullptr;
+	return blob.skip(size);
+}
+
+
+JSBundle::Builder::Builder(IAllocator& allocator)
+	: m_allocator(allocator)
+	, m_entries(allocator)
+	, m_data(allocator)
+{
+	// compile only, the udata tells duk_config.h hooks there is no system
+	m_context = duk_create_heap(nullptr, nullptr, nullptr, nullptr, nullptr);
+}
+
+
+JSBundle::Builder::~Builder()
+{
+	duk_destroy_heap(m_context);
+}
+
+
+bool JSBundle::Builder::dump(const char* path, const char* source, int size, bool is_module, OutputBlob& out)
+{
+	duk_context* ctx = m_context;
+	if (is_module)
+	{
+		duk_push_string(ctx, JS_MODULE_HEADER);
+		duk_push_lstring(ctx, source, size);
+		duk_push_string(ctx, JS_MODULE_FOOTER);
+		duk_concat(ctx, 3);
+	}
+	else
+	{
+		duk_push_lstring(ctx, source, size);
+	}
+	duk_push_string(ctx, path);
+	if (duk_pcompile(ctx, is_module ? DUK_COMPILE_FUNCTION : DUK_COMPILE_EVAL) != 0)
+	{
+		if (!is_module) g_log_error.log("JS Script") << duk_safe_to_string(ctx, -1);
+		duk_pop(ctx);
+		out.write((u32)0);
+		return false;
+	}
+
+	duk_dump_function(ctx);
+	duk_size_t bytecode_size;
+	const void* bytecode = duk_get_buffer(ctx, -1, &bytecode_size);
+	out.write((u32)bytecode_size);
+	out.write(bytecode, (int)bytecode_size);
+	duk_pop(ctx);
+	return true;
+}
+
+
+bool JSBundle::Builder::add(const char* path, const char* source, int size, bool with_source)
+{
+	OutputBlob record(m_allocator);
+	record.write(RECORD_MAGIC);
+	record.write(RECORD_VERSION);
+	record.write(crc32(source, size));
+	if (!dump(path, source, size, false, record)) return false;
+	// not every script is a valid function body, such modules are compiled from the source
+	dump(path, source, size, true, record);
+	record.write((u32)(with_source ? size : 0));
+	if (with_source) record.write(source, size);
+
+	// the scan needs a NUL terminated source
+	Array<char> text(m_allocator);
+	text.resize(size + 1);
+	if (size > 0) copyMemory(&text[0], source, size);
+	text[size] = '\0';
+	Array<Path> requires(m_allocator);
+	getJSRequires(&text[0], path, requires);
+	record.write((u32)requires.size());
+	for (const Path& require : requires) record.write(require.c_str(), stringLength(require.c_str()) + 1);
+
+	Entry& entry = m_entries.emplace();
+	copyString(entry.path, path);
+	entry.path_hash = Path(path).getHash();
+	entry.offset = m_data.size();
+	entry.size = record.getPos();
+	m_data.resize(entry.offset + JSLZ4::compressBound(entry.size));
+	entry.compressed_size = JSLZ4::compress(
+		(const u8*)record.getData(), entry.size, &m_data[entry.offset], m_data.size() - entry.offset);
+	m_data.resize(entry.offset + entry.compressed_size);
+	return true;
+}
+
+
+void JSBundle::Builder::write(OutputBlob& blob) const
+{
+	blob.write(BUNDLE_MAGIC);
+	blob.write(BUNDLE_VERSION);
+	blob.write((u32)m_entries.size());
+	for (const Entry& entry : m_entries)
+	{
+		u32 path_length = stringLength(entry.path);
+		blob.write(entry.path_hash);
+		blob.write(path_length);
+		blob.write(entry.path, path_length + 1);
+		blob.write((u32)entry.offset);
+		blob.write((u32)entry.compressed_size);
+		blob.write((u32)entry.size);
+	}
+	if (!m_data.empty()) blob.write(&m_data[0], m_data.size());
+}
+
+
+bool JSBundle::Builder::save(const char* path) const
+{
+	OutputBlob blob(m_allocator);
+	write(blob);
+
+	FS::OsFile file;
+	if (!file.open(path, FS::Mode::CREATE_AND_WRITE, m_allocator))
+	{
+		g_log_error.log("JS Script") << "Failed to create " << path;
+		return false;
+	}
+	bool is_written = file.write(blob.getData(), blob.getPos());
+	file.close();
+	if (!is_written) g_log_error.log("JS Script") << "Failed to write " << path;
+	return is_written;
+}
+
+
+JSBundle::JSBundle(IAllocator& allocator)
+	: m_allocator(allocator)
+	, m_data(allocator)
+	, m_entries(allocator)
+	, m_map(allocator)
+{
+}
+
+
+// the whole archive stays in memory, entries are decompressed when they are opened
+bool JSBundle::open(const char* path)
+{
+	close();
+
+	FS::OsFile file;
+	if (!file.open(path, FS::Mode::OPEN_AND_READ, m_allocator)) return false;
+	m_data.resize((int)file.size());
+	bool is_read = m_data.empty() || file.read(&m_data[0], m_data.size());
+	file.close();
+	if (!is_read || !parseIndex())
+	{
+		g_log_error.log("JS Script") << "Invalid script bundle " << path;
+		close();
+		return false;
+	}
+	return true;
+}
+
+
+bool JSBundle::open(const void* data, int size)
+{
+	close();
+
+	m_data.resize(size);
+	if (size > 0) copyMemory(&m_data[0], data, size);
+	if (parseIndex()) return true;
+
+	close();
+	return false;
+}
+
+
+bool JSBundle::parseIndex()
+{
+	if (m_data.empty()) return false;
+
+	InputBlob blob(&m_data[0], m_data.size());
+	u32 magic = 0;
+	u32 version = 0;
+	u32 count = 0;
+	blob.read(magic);
+	blob.read(version);
+	blob.read(count);
+	if (magic != BUNDLE_MAGIC || version != BUNDLE_VERSION || count > (u32)m_data.size()) return false;
+
+	for (u32 i = 0; i < count; ++i)
+	{
+		u32 path_hash = 0;
+		u32 path_length = 0;
+		blob.read(path_hash);
+		blob.read(path_length);
+		Entry& entry = m_entries.emplace();
+		entry.path_offset = blob.getPosition();
+		if (!readBlock(blob, (int)path_length + 1)) return false;
+		if (m_data[entry.path_offset + path_length] != '\0') return false;
+
+		u32 offset = 0;
+		u32 compressed_size = 0;
+		u32 size = 0;
+		blob.read(offset);
+		blob.read(compressed_size);
+		if (!blob.read(&size, sizeof(size))) return false;
+		entry.offset = (int)offset;
+		entry.compressed_size = (int)compressed_size;
+		entry.size = (int)size;
+		m_map.insert(path_hash, m_entries.size() - 1);
+	}
+
+	// offsets are relative to the end of the index
+	int data_start = blob.getPosition();
+	for (Entry& entry : m_entries)
+	{
+		entry.offset += data_start;
+		if (entry.offset < data_start || entry.compressed_size > m_data.size() - entry.offset) return false;
+	}
+	return true;
+}
+
+
+void JSBundle::close()
+{
+	m_data.clear();
+	m_entries.clear();
+	m_map.clear();
+}
+
+
+int JSBundle::find(const Path& path)
+{
+	auto iter = m_map.find(path.getHash());
+	return iter == m_map.end() ? -1 : iter.value();
+}
+
+
+bool JSBundle::read(int entry, void* out) const
+{
+	const Entry& e = m_entries[entry];
+	return JSLZ4::decompress(&m_data[e.offset], e.compressed_size, (u8*)out, e.size);
+}
+
+
+bool JSBundle::parseRecord(const void* data, int size, Record& record)
+{
+	if (!data || size < 8) return false;
+
+	InputBlob blob(data, size);
+	if (blob.read<u32>() != RECORD_MAGIC) return false;
+	if (blob.read<u32>() != RECORD_VERSION)
+	{
+		g_log_error.log("JS Script") << "Unsupported script record version";
+		return false;
+	}
+
+	record.source_hash = blob.read<u32>();
+	record.bytecode_size = (int)blob.read<u32>();
+	record.bytecode = (const u8*)readBlock(blob, record.bytecode_size);
+	record.module_bytecode_size = (int)blob.read<u32>();
+	record.module_bytecode = (const u8*)readBlock(blob, record.module_bytecode_size);
+	record.source_size = (int)blob.read<u32>();
+	record.source = (const char*)readBlock(blob, record.source_size);
+	record.require_count = (int)blob.read<u32>();
+	record.requires = (const char*)readBlock(blob, 0);
+	if (!record.bytecode || !record.module_bytecode || !record.source || !record.requires) return false;
+
+	// every path is NUL terminated within the record
+	const char* end = (const char*)data + size;
+	const char* c = record.requires;
+	for (int i = 0; i < record.require_count; ++i)
+	{
+		while (c < end && *c) ++c;
+		if (c == end) return false;
+		++c;
+	}
+	return true;
+}
+
+
+struct JSBundleDevice::File LUMIX_FINAL : public FS::IFile
+{
+	File(JSBundleDevice& device, FS::IFile* child, IAllocator& allocator)
+		: m_device(device)
+		, m_child(child)
+		, m_data(allocator)
+		, m_pos(0)
+		, m_is_bundled(false)
+	{
+	}
+
+
+	~File()
+	{
+		if (m_child) m_child->release();
+	}
+
+
+	FS::IFileDevice& getDevice() override { return m_device; }
+
+
+	bool open(const Path& path, FS::Mode mode) override
+	{
+		JSBundle& bundle = m_device.m_bundle;
+		int entry = mode == FS::Mode::OPEN_AND_READ ? bundle.find(path) : -1;
+		if (entry < 0) return m_child && m_child->open(path, mode);
+
+		m_data.resize(bundle.getRecordSize(entry));
+		if (!bundle.read(entry, m_data.empty() ? nullptr : &m_data[0]))
+		{
+			g_log_error.log("JS Script") << "Corrupted bundle entry " << path.c_str();
+			return false;
+		}
+		m_pos = 0;
+		m_is_bundled = true;
+		return true;
+	}
+
+
+	void close() override
+	{
+		if (!m_is_bundled)
+		{
+			if (m_child) m_child->close();
+			return;
+		}
+		m_data.clear();
+		m_is_bundled = false;
+	}
+
+
+	bool read(void* buffer, size_t size) override
+	{
+		if (!m_is_bundled) return m_child && m_child->read(buffer, size);
+
+		if (size > m_data.size() - m_pos) return false;
+		if (size > 0) copyMemory(buffer, &m_data[(int)m_pos], size);
+		m_pos += size;
+		return true;
+	}
+
+
+	bool write(const void* buffer, size_t size) override
+	{
+		return !m_is_bundled && m_child && m_child->write(buffer, size);
+	}
+
+
+	const void* getBuffer() const override
+	{
+		if (!m_is_bundled) return m_child ? m_child->getBuffer() : nullptr;
+		return m_data.empty() ? nullptr : &m_data[0];
+	}
+
+
+	size_t size() override
+	{
+		if (!m_is_bundled) return m_child ? m_child->size() : 0;
+		return m_data.size();
+	}
+
+
+	bool seek(FS::SeekMode base, size_t pos) override
+	{
+		if (!m_is_bundled) return m_child && m_child->seek(base, pos);
+
+		size_t size = m_data.size();
+		switch (base)
+		{
+			case FS::SeekMode::BEGIN: m_pos = pos; break;
+			case FS::SeekMode::CURRENT: m_pos += pos; break;
+			case FS::SeekMode::END: m_pos = size - pos; break;
+			default: return false;
+		}
+		if (m_pos > size) m_pos = size;
+		return true;
+	}
+
+
+	size_t pos() override
+	{
+		if (!m_is_bundled) return m_child ? m_child->pos() : 0;
+		return m_pos;
+	}
+
+
+	JSBundleDevice& m_device;
+	FS::IFile* m_child;
+	Array<u8> m_data;
+	size_t m_pos;
+	bool m_is_bundled;
+};
+
+
+JSBundleDevice::JSBundleDevice(JSBundle& bundle, IAllocator& allocator)
+	: m_bundle(bundle)
+	, m_allocator(allocator)
+{
+}
+
+
+FS::IFile* JSBundleDevice::createFile(FS::IFile* child)
+{
+	return LUMIX_NEW(m_allocator, File)(*this, child, m_allocator);
+}
+
+
+void JSBundleDevice::destroyFile(FS::IFile* file)
+{
+	LUMIX_DELETE(m_allocator, file);
+}
+
+
+} // namespace Lumix
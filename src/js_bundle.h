@@ -0,0 +1,135 @@
+#pragma once
+
+
+#include "engine/array.h"
+#include "engine/fs/ifile_device.h"
+#include "engine/hash_map.h"
+#include "engine/lumix.h"
+#include "duktape/duktape.h"
+
+
+namespace Lumix
+{
+
+
+class OutputBlob;
+class Path;
+struct IAllocator;
+
+
+// loaded at startup if it exists, see JSScriptScene::setBundleEnabled
+static const char* const JS_BUNDLE_PATH = "scripts.jsbundle";
+// require() compiles a module as a function with this header and footer
+static const char* const JS_MODULE_HEADER = "function (exports, require, module) {";
+static const char* const JS_MODULE_FOOTER = "\n}";
+
+
+// Archive of precompiled scripts and modules - an index followed by LZ4 compressed entries,
+// read with a single file open. An entry is decompressed when it is opened, to a script
+// record which JSScript::load accepts in place of the source.
+class JSBundle
+{
+public:
+	struct Record
+	{
+		u32 source_hash;
+		const u8* bytecode; // eval code, see JSCompiler
+		int bytecode_size;
+		const u8* module_bytecode; // function (exports, require, module)
+		int module_bytecode_size;
+		const char* source; // optional
+		int source_size;
+		const char* requires; // resolved paths, each NUL terminated
+		int require_count;
+	};
+
+	class Builder
+	{
+	public:
+		explicit Builder(IAllocator& allocator);
+		~Builder();
+
+		// returns false if the source does not compile, the error is logged
+		bool add(const char* path, const char* source, int size, bool with_source);
+		int getEntryCount() const { return m_entries.size(); }
+		void write(OutputBlob& blob) const;
+		bool save(const char* path) const;
+
+	private:
+		struct Entry
+		{
+			char path[MAX_PATH_LENGTH];
+			u32 path_hash;
+			int offset;
+			int compressed_size;
+			int size;
+		};
+
+	private:
+		bool dump(const char* path, const char* source, int size, bool is_module, OutputBlob& out);
+
+	private:
+		IAllocator& m_allocator;
+		duk_context* m_context;
+		Array<Entry> m_entries;
+		Array<u8> m_data;
+	};
+
+public:
+	explicit JSBundle(IAllocator& allocator);
+
+	bool open(const char* path);
+	bool open(const void* data, int size);
+	void close();
+	bool isOpen() const { return !m_entries.empty(); }
+
+	int find(const Path& path);
+	int getEntryCount() const { return m_entries.size(); }
+	const char* getEntryPath(int entry) const { return (const char*)&m_data[m_entries[entry].path_offset]; }
+	int getRecordSize(int entry) const { return m_entries[entry].size; }
+	// decompresses the entry to out, which has getRecordSize bytes
+	bool read(int entry, void* out) const;
+
+	static bool parseRecord(const void* data, int size, Record& record);
+
+private:
+	bool parseIndex();
+
+private:
+	struct Entry
+	{
+		int path_offset;
+		int offset;
+		int compressed_size;
+		int size;
+	};
+
+private:
+	IAllocator& m_allocator;
+	Array<u8> m_data;
+	Array<Entry> m_entries;
+	HashMap<u32, int> m_map;
+};
+
+
+// Serves the scripts of the bundle to the resource manager, other paths are passed to the
+// next device. It is put in front of the default devices, e.g. "jsbundle:memory:disk".
+class JSBundleDevice LUMIX_FINAL : public FS::IFileDevice
+{
+public:
+	JSBundleDevice(JSBundle& bundle, IAllocator& allocator);
+
+	FS::IFile* createFile(FS::IFile* child) override;
+	void destroyFile(FS::IFile* file) override;
+	const char* name() const override { return "jsbundle"; }
+
+private:
+	struct File;
+
+private:
+	JSBundle& m_bundle;
+	IAllocator& m_allocator;
+};
+
+
+} // namespace Lumix
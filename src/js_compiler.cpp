@@ -0,0 +1,280 @@
+#include "js_compiler.h"
+#include "engine/array.h"
+#include "engine/iallocator.h"
+#include "engine/log.h"
+#include "engine/mt/sync.h"
+#include "engine/mt/task.h"
+#include "engine/path.h"
+#include "engine/string.h"
+
+
+namespace Lumix
+{
+
+
+struct JSCompiler::Job
+{
+	explicit Job(IAllocator& allocator)
+		: data(allocator)
+		, is_compiled(false)
+		, is_dropped(false)
+	{
+	}
+
+	Path path;
+	u32 source_hash;
+	Array<u8> data; // source, bytecode once compiled
+	bool is_compiled;
+	bool is_dropped; // see JSCompiler::drop
+};
+
+
+struct JSCompiler::Worker LUMIX_FINAL : public MT::Task
+{
+	explicit Worker(IAllocator& allocator)
+		: MT::Task(allocator)
+		, m_allocator(allocator)
+		, m_queue(allocator)
+		, m_finished(allocator)
+		, m_semaphore(0, 0x7fffFFFF)
+		, m_mutex(false)
+		, m_current(nullptr)
+		, m_finished_count(0)
+		, m_is_finishing(false)
+	{
+	}
+
+
+	~Worker()
+	{
+		for (Job* job : m_queue) LUMIX_DELETE(m_allocator, job);
+		for (Job* job : m_finished) LUMIX_DELETE(m_allocator, job);
+	}
+
+
+	void push(Job* job)
+	{
+		{
+			MT::SpinLock lock(m_mutex);
+			m_queue.push(job);
+		}
+		m_semaphore.signal();
+	}
+
+
+	void finish()
+	{
+		{
+			MT::SpinLock lock(m_mutex);
+			for (Job* job : m_queue) LUMIX_DELETE(m_allocator, job);
+			m_queue.clear();
+			m_is_finishing = true;
+		}
+		m_semaphore.signal();
+	}
+
+
+	void drop(Array<Job*>& jobs, const Path& path)
+	{
+		for (int i = jobs.size() - 1; i >= 0; --i)
+		{
+			if (!(jobs[i]->path == path)) continue;
+			LUMIX_DELETE(m_allocator, jobs[i]);
+			jobs.erase(i);
+		}
+	}
+
+
+	static void compile(duk_context* ctx, Job& job)
+	{
+		duk_push_string(ctx, job.path.c_str());
+		if (duk_pcompile_lstring_filename(ctx, DUK_COMPILE_EVAL, (const char*)&job.data[0], job.data.size()) != 0)
+		{
+			job.data.clear();
+			duk_pop(ctx);
+			return;
+		}
+
+		duk_dump_function(ctx);
+		duk_size_t size;
+		void* bytecode = duk_get_buffer(ctx, -1, &size);
+		job.data.resize((int)size);
+		copyMemory(&job.data[0], bytecode, size);
+		job.is_compiled = true;
+		duk_pop(ctx);
+	}
+
+
+	int task() override
+	{
+		// not the engine's heap, the udata tells duk_config.h hooks there is no system
+		duk_context* ctx = duk_create_heap(nullptr, nullptr, nullptr, nullptr, nullptr);
+		for (;;)
+		{
+			m_semaphore.wait();
+
+			{
+				MT::SpinLock lock(m_mutex);
+				if (m_queue.empty())
+				{
+					if (m_is_finishing) break;
+					continue;
+				}
+				m_current = m_queue[0];
+				m_queue.erase(0);
+			}
+
+			if (!m_current->data.empty()) compile(ctx, *m_current);
+
+			MT::SpinLock lock(m_mutex);
+			if (m_current->is_dropped)
+			{
+				LUMIX_DELETE(m_allocator, m_current);
+				m_current = nullptr;
+				continue;
+			}
+			// only the last result of a path is kept
+			for (int i = 0; i < m_finished.size(); ++i)
+			{
+				if (!(m_finished[i]->path == m_current->path)) continue;
+				LUMIX_DELETE(m_allocator, m_finished[i]);
+				m_finished.eraseFast(i);
+				break;
+			}
+			m_finished.push(m_current);
+			m_current = nullptr;
+			++m_finished_count;
+		}
+		duk_destroy_heap(ctx);
+		return 0;
+	}
+
+
+	IAllocator& m_allocator;
+	Array<Job*> m_queue;
+	Array<Job*> m_finished;
+	MT::Semaphore m_semaphore;
+	MT::SpinMutex m_mutex;
+	Job* m_current;
+	u32 m_finished_count;
+	bool m_is_finishing;
+};
+
+
+JSCompiler::JSCompiler(IAllocator& allocator)
+	: m_allocator(allocator)
+	, m_worker(nullptr)
+{
+}
+
+
+JSCompiler::~JSCompiler()
+{
+	stop();
+}
+
+
+void JSCompiler::start()
+{
+	if (m_worker) return;
+
+	m_worker = LUMIX_NEW(m_allocator, Worker)(m_allocator);
+	if (!m_worker->create("js_compiler"))
+	{
+		g_log_error.log("JS Script") << "Failed to create the compiler thread";
+		LUMIX_DELETE(m_allocator, m_worker);
+		m_worker = nullptr;
+	}
+}
+
+
+void JSCompiler::stop()
+{
+	if (!m_worker) return;
+
+	m_worker->finish();
+	m_worker->destroy();
+	LUMIX_DELETE(m_allocator, m_worker);
+	m_worker = nullptr;
+}
+
+
+void JSCompiler::compile(const Path& path, const char* source, int size, u32 source_hash)
+{
+	if (!m_worker) return;
+
+	Job* job = LUMIX_NEW(m_allocator, Job)(m_allocator);
+	job->path = path;
+	job->source_hash = source_hash;
+	job->data.resize(size);
+	if (size > 0) copyMemory(&job->data[0], source, size);
+	m_worker->push(job);
+}
+
+
+bool JSCompiler::isPending(const Path& path)
+{
+	if (!m_worker) return false;
+
+	MT::SpinLock lock(m_worker->m_mutex);
+	if (m_worker->m_current && m_worker->m_current->path == path) return true;
+	for (Job* job : m_worker->m_queue)
+	{
+		if (job->path == path) return true;
+	}
+	return false;
+}
+
+
+// the job being compiled is not waited for, the worker deletes it when it is done
+void JSCompiler::drop(const Path& path)
+{
+	if (!m_worker) return;
+
+	MT::SpinLock lock(m_worker->m_mutex);
+	if (m_worker->m_current && m_worker->m_current->path == path) m_worker->m_current->is_dropped = true;
+	m_worker->drop(m_worker->m_queue, path);
+	m_worker->drop(m_worker->m_finished, path);
+}
+
+
+u32 JSCompiler::getFinishedCount()
+{
+	if (!m_worker) return 0;
+
+	MT::SpinLock lock(m_worker->m_mutex);
+	return m_worker->m_finished_count;
+}
+
+
+bool JSCompiler::load(duk_context* ctx, const Path& path, u32 source_hash)
+{
+	if (!m_worker) return false;
+
+	Job* job = nullptr;
+	{
+		MT::SpinLock lock(m_worker->m_mutex);
+		Array<Job*>& finished = m_worker->m_finished;
+		for (int i = 0; i < finished.size(); ++i)
+		{
+			if (!(finished[i]->path == path)) continue;
+			job = finished[i];
+			finished.eraseFast(i);
+			break;
+		}
+	}
+	if (!job) return false;
+
+	bool is_loaded = job->is_compiled && job->source_hash == source_hash;
+	if (is_loaded)
+	{
+		void* buffer = duk_push_fixed_buffer(ctx, job->data.size());
+		copyMemory(buffer, &job->data[0], job->data.size());
+		duk_load_function(ctx);
+	}
+	LUMIX_DELETE(m_allocator, job);
+	return is_loaded;
+}
+
+
+} // namespace Lumix
@@ -0,0 +1,52 @@
+#pragma once
+
+
+#include "engine/lumix.h"
+#include "duktape/duktape.h"
+
+
+namespace Lumix
+{
+
+
+class Path;
+struct IAllocator;
+
+
+// Compiles script sources to bytecode on a worker thread, which owns a compile-only duktape
+// heap, so the main thread only loads the function (duk_load_function). Bytecode is
+// matched by path and source hash, stale results are never loaded.
+class JSCompiler
+{
+public:
+	explicit JSCompiler(IAllocator& allocator);
+	~JSCompiler();
+
+	void start();
+	// drops queued jobs, load falls back to compiling on the calling thread
+	void stop();
+	bool isRunning() const { return m_worker != nullptr; }
+
+	// copies the source, it does not have to be NUL terminated
+	void compile(const Path& path, const char* source, int size, u32 source_hash);
+	// true while the source is queued or being compiled
+	bool isPending(const Path& path);
+	// drops the queued source and the bytecode of the path, e.g. once it is not needed
+	void drop(const Path& path);
+	// changes whenever a job finishes, so waiting scripts know when to try again
+	u32 getFinishedCount();
+	// [] -> [function], returns false if there is no bytecode for the source, e.g. it has
+	// failed to compile, the error is reported by the fallback compile
+	bool load(duk_context* ctx, const Path& path, u32 source_hash);
+
+private:
+	struct Job;
+	struct Worker;
+
+private:
+	IAllocator& m_allocator;
+	Worker* m_worker;
+};
+
+
+} // namespace Lumix
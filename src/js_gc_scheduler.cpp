@@ -0,0 +1,117 @@
+#include "js_gc_scheduler.h"
+#include "engine/string.h"
+
+
+namespace Lumix
+{
+
+
+JSGCScheduler::JSGCScheduler()
+	: m_context(nullptr)
+	, m_policy(Policy::FRAME_END)
+	, m_budget(1)
+	, m_max_pending_frames(30)
+	, m_callback_depth(0)
+	, m_is_pending(false)
+	, m_pending_frames(0)
+	, m_credit(0)
+	, m_last_gc_time(0)
+	, m_next_trigger(Trigger::OTHER)
+	, m_trigger(Trigger::OTHER)
+{
+	resetStats();
+}
+
+
+void JSGCScheduler::resetStats()
+{
+	setMemory(&m_stats, 0, sizeof(m_stats));
+}
+
+
+// called from the allocator, must not call back into duktape
+bool JSGCScheduler::onVoluntaryGC()
+{
+	bool in_callback = m_callback_depth > 0;
+	if (in_callback && m_policy != Policy::IMMEDIATE)
+	{
+		if (!m_is_pending) ++m_stats.deferred_count;
+		m_is_pending = true;
+		return false;
+	}
+
+	m_next_trigger = in_callback ? Trigger::CALLBACK : Trigger::VOLUNTARY;
+	return true;
+}
+
+
+void JSGCScheduler::onGCBegin()
+{
+	m_trigger = m_next_trigger;
+	m_next_trigger = Trigger::OTHER;
+}
+
+
+void JSGCScheduler::onGCEnd(float time)
+{
+	m_stats.count[(int)m_trigger] += 1;
+	m_stats.time[(int)m_trigger] += time;
+	m_last_gc_time = time;
+	m_trigger = Trigger::OTHER;
+
+	// any full collection satisfies the pending one
+	m_is_pending = false;
+	m_pending_frames = 0;
+	m_credit = m_credit > time ? m_credit - time : 0;
+}
+
+
+void JSGCScheduler::endFrame()
+{
+	if (!m_is_pending || !m_context) return;
+
+	++m_pending_frames;
+	Trigger trigger = Trigger::FRAME_END;
+	if (m_policy == Policy::BUDGETED)
+	{
+		m_credit += m_budget;
+		if (m_credit < m_last_gc_time)
+		{
+			if (m_pending_frames < m_max_pending_frames) return;
+			trigger = Trigger::FORCED;
+		}
+	}
+
+	m_next_trigger = trigger;
+	duk_gc(m_context, 0);
+	m_next_trigger = Trigger::OTHER;
+}
+
+
+const char* JSGCScheduler::getPolicyName(Policy policy)
+{
+	switch (policy)
+	{
+		case Policy::IMMEDIATE: return "immediate";
+		case Policy::FRAME_END: return "frame_end";
+		case Policy::BUDGETED: return "budgeted";
+		default: return "unknown";
+	}
+}
+
+
+const char* JSGCScheduler::getTriggerName(Trigger trigger)
+{
+	switch (trigger)
+	{
+		case Trigger::CALLBACK: return "in callback";
+		case Trigger::VOLUNTARY: return "voluntary";
+		case Trigger::FRAME_END: return "frame end";
+		case Trigger::FORCED: return "forced";
+		case Trigger::OTHER: return "emergency or explicit";
+		default: return "unknown";
+	}
+}
+
+
+} // namespace Lumix
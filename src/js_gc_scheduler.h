@@ -0,0 +1,91 @@
+#pragma once
+
+
+#include "engine/lumix.h"
+#include "duktape/duktape.h"
+
+
+namespace Lumix
+{
+
+
+// Decides when the script heap is collected. Voluntary mark-and-sweep which becomes due
+// during a script callback is deferred and run between frames instead, see
+// DUK_USE_LUMIX_GC_VOLUNTARY in duk_config.h. Duktape's mark-and-sweep can not be split,
+// so the budgeted policy amortizes whole collections: every frame with a pending
+// collection earns the budget and the collection runs once it has earned its cost.
+class JSGCScheduler
+{
+public:
+	enum class Policy
+	{
+		IMMEDIATE, // collect whenever due, duktape's default
+		FRAME_END, // defer collections due in callbacks to the end of the frame
+		BUDGETED, // like FRAME_END, but at most the budget per frame on average
+
+		COUNT
+	};
+
+	enum class Trigger
+	{
+		CALLBACK, // voluntary, inside a callback, IMMEDIATE only
+		VOLUNTARY, // voluntary, outside of callbacks
+		FRAME_END, // deferred
+		FORCED, // deferred for the maximum number of frames
+		OTHER, // emergency or explicit, e.g. Duktape.gc()
+
+		COUNT
+	};
+
+	struct Stats
+	{
+		u32 count[(int)Trigger::COUNT];
+		float time[(int)Trigger::COUNT]; // ms
+		u32 deferred_count; // voluntary collections refused in callbacks
+	};
+
+public:
+	JSGCScheduler();
+
+	void setContext(duk_context* ctx) { m_context = ctx; }
+	void setPolicy(Policy policy) { m_policy = policy; }
+	Policy getPolicy() const { return m_policy; }
+	void setBudget(float ms) { m_budget = ms < 0 ? 0 : ms; }
+	float getBudget() const { return m_budget; }
+	void setMaxPendingFrames(int frames) { m_max_pending_frames = frames < 1 ? 1 : frames; }
+	int getMaxPendingFrames() const { return m_max_pending_frames; }
+
+	void beginCallback() { ++m_callback_depth; }
+	void endCallback() { --m_callback_depth; }
+	// returns false to defer the collection
+	bool onVoluntaryGC();
+	void onGCBegin();
+	void onGCEnd(float time);
+	// runs the deferred collection if the policy allows it
+	void endFrame();
+
+	bool isPending() const { return m_is_pending; }
+	int getPendingFrames() const { return m_pending_frames; }
+	const Stats& getStats() const { return m_stats; }
+	void resetStats();
+
+	static const char* getPolicyName(Policy policy);
+	static const char* getTriggerName(Trigger trigger);
+
+private:
+	duk_context* m_context;
+	Policy m_policy;
+	float m_budget;
+	int m_max_pending_frames;
+	int m_callback_depth;
+	bool m_is_pending;
+	int m_pending_frames;
+	float m_credit;
+	float m_last_gc_time;
+	Trigger m_next_trigger;
+	Trigger m_trigger;
+	Stats m_stats;
+};
+
+
+} // namespace Lumix
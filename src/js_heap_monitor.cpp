@@ -0,0 +1,130 @@
+#include "js_heap_monitor.h"
+#include "engine/iallocator.h"
+#include "engine/string.h"
+#include "engine/timer.h"
+
+
+namespace Lumix
+{
+
+
+// keeps the returned pointer aligned for doubles
+static const size_t HEADER_SIZE = 16;
+
+
+static size_t getSize(void* ptr)
+{
+	return *(size_t*)((u8*)ptr - HEADER_SIZE);
+}
+
+
+JSHeapMonitor::JSHeapMonitor(IAllocator& allocator)
+	: m_allocator(allocator)
+	, m_gc_start(0)
+	, m_history_offset(0)
+{
+	m_timer = Timer::create(allocator);
+	setMemory(&m_stats, 0, sizeof(m_stats));
+	setMemory(&m_frame, 0, sizeof(m_frame));
+	setMemory(&m_last_frame, 0, sizeof(m_last_frame));
+	setMemory(m_gc_time_history, 0, sizeof(m_gc_time_history));
+	setMemory(m_live_bytes_history, 0, sizeof(m_live_bytes_history));
+}
+
+
+JSHeapMonitor::~JSHeapMonitor()
+{
+	Timer::destroy(m_timer);
+}
+
+
+void* JSHeapMonitor::allocate(duk_size_t size)
+{
+	if (size == 0) return nullptr;
+
+	u8* mem = (u8*)m_allocator.allocate(size + HEADER_SIZE);
+	if (!mem) return nullptr;
+	*(size_t*)mem = size;
+
+	m_stats.live_bytes += size;
+	if (m_stats.live_bytes > m_stats.peak_bytes) m_stats.peak_bytes = m_stats.live_bytes;
+	++m_stats.alloc_count;
+	m_stats.alloc_bytes += size;
+	++m_stats.live_allocations;
+	++m_frame.alloc_count;
+	m_frame.alloc_bytes += size;
+	return mem + HEADER_SIZE;
+}
+
+
+void* JSHeapMonitor::reallocate(void* ptr, duk_size_t size)
+{
+	if (!ptr) return allocate(size);
+	if (size == 0)
+	{
+		deallocate(ptr);
+		return nullptr;
+	}
+
+	size_t old_size = getSize(ptr);
+	u8* mem = (u8*)m_allocator.reallocate((u8*)ptr - HEADER_SIZE, size + HEADER_SIZE);
+	if (!mem) return nullptr;
+	*(size_t*)mem = size;
+
+	m_stats.live_bytes = m_stats.live_bytes - old_size + size;
+	if (m_stats.live_bytes > m_stats.peak_bytes) m_stats.peak_bytes = m_stats.live_bytes;
+	if (size > old_size)
+	{
+		++m_stats.alloc_count;
+		m_stats.alloc_bytes += size - old_size;
+		++m_frame.alloc_count;
+		m_frame.alloc_bytes += size - old_size;
+	}
+	return mem + HEADER_SIZE;
+}
+
+
+void JSHeapMonitor::deallocate(void* ptr)
+{
+	if (!ptr) return;
+
+	m_stats.live_bytes -= getSize(ptr);
+	--m_stats.live_allocations;
+	m_allocator.deallocate((u8*)ptr - HEADER_SIZE);
+}
+
+
+void JSHeapMonitor::beginGC()
+{
+	m_gc_start = m_timer->getRawTimeSinceStart();
+}
+
+
+void JSHeapMonitor::endGC(duk_size_t object_count, duk_size_t string_count)
+{
+	u64 ticks = m_timer->getRawTimeSinceStart() - m_gc_start;
+	float time = float(ticks * 1000.0 / m_timer->getFrequency());
+
+	++m_stats.gc_count;
+	m_stats.last_gc_time = time;
+	if (time > m_stats.max_gc_time) m_stats.max_gc_time = time;
+	m_stats.object_count = (u32)object_count;
+	m_stats.string_count = (u32)string_count;
+	++m_frame.gc_count;
+	m_frame.gc_time += time;
+}
+
+
+void JSHeapMonitor::endFrame(float time_delta)
+{
+	m_frame.alloc_rate = time_delta > 0 ? m_frame.alloc_bytes / time_delta : 0;
+	m_last_frame = m_frame;
+	setMemory(&m_frame, 0, sizeof(m_frame));
+
+	m_gc_time_history[m_history_offset] = m_last_frame.gc_time;
+	m_live_bytes_history[m_history_offset] = (float)m_stats.live_bytes;
+	m_history_offset = (m_history_offset + 1) % HISTORY_SIZE;
+}
+
+
+} // namespace Lumix
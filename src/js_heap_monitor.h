@@ -0,0 +1,78 @@
+#pragma once
+
+
+#include "engine/lumix.h"
+#include "duktape/duktape.h"
+
+
+namespace Lumix
+{
+
+
+class Timer;
+struct IAllocator;
+
+
+// Tracks the script heap, it provides the heap allocation functions and is notified
+// by the mark-and-sweep hooks, see DUK_USE_LUMIX_GC_BEGIN in duk_config.h.
+class JSHeapMonitor
+{
+public:
+	static const int HISTORY_SIZE = 128;
+
+	struct Stats
+	{
+		u64 live_bytes;
+		u64 peak_bytes;
+		u64 alloc_count;
+		u64 alloc_bytes;
+		u32 live_allocations;
+		u32 object_count; // after the last mark-and-sweep
+		u32 string_count;
+		u32 gc_count;
+		float last_gc_time; // ms
+		float max_gc_time;
+	};
+
+	struct FrameStats
+	{
+		u32 alloc_count;
+		u64 alloc_bytes;
+		float alloc_rate; // bytes per second
+		u32 gc_count;
+		float gc_time; // ms
+	};
+
+public:
+	explicit JSHeapMonitor(IAllocator& allocator);
+	~JSHeapMonitor();
+
+	void* allocate(duk_size_t size);
+	void* reallocate(void* ptr, duk_size_t size);
+	void deallocate(void* ptr);
+	void beginGC();
+	void endGC(duk_size_t object_count, duk_size_t string_count);
+	void endFrame(float time_delta);
+
+	const Stats& getStats() const { return m_stats; }
+	// stats of the last finished frame
+	const FrameStats& getFrameStats() const { return m_last_frame; }
+	// ring buffers, oldest sample at getHistoryOffset()
+	const float* getGCTimeHistory() const { return m_gc_time_history; }
+	const float* getLiveBytesHistory() const { return m_live_bytes_history; }
+	int getHistoryOffset() const { return m_history_offset; }
+
+private:
+	IAllocator& m_allocator;
+	Timer* m_timer;
+	Stats m_stats;
+	FrameStats m_frame;
+	FrameStats m_last_frame;
+	u64 m_gc_start;
+	float m_gc_time_history[HISTORY_SIZE];
+	float m_live_bytes_history[HISTORY_SIZE];
+	int m_history_offset;
+};
+
+
+} // namespace Lumix
@@ -0,0 +1,77 @@
+#include "js_hot_reload.h"
+
+
+namespace Lumix
+{
+namespace JSHotReload
+{
+
+
+// called by the scene, see JSScriptSceneImpl::getCallbackName and beginFunctionCall
+static const char* const CALLBACKS[] = { "update", "onStartGame", "onDestroy", "onGUI", "onDrawGizmo", "onReuse" };
+
+
+static bool isShared(duk_context* ctx, duk_idx_t idx)
+{
+	return !duk_is_object(ctx, idx) || duk_is_function(ctx, idx);
+}
+
+
+Result apply(duk_context* ctx, duk_idx_t instance_idx, duk_idx_t script_idx)
+{
+	instance_idx = duk_normalize_index(ctx, instance_idx);
+	script_idx = duk_normalize_index(ctx, script_idx);
+
+	// fields the instance does not have would be shared by all instances if they are objects
+	duk_enum(ctx, script_idx, DUK_ENUM_OWN_PROPERTIES_ONLY);
+	while (duk_next(ctx, -1, 1))
+	{
+		// [enum key value]
+		if (isShared(ctx, -1))
+		{
+			duk_pop_2(ctx);
+			continue;
+		}
+		duk_dup(ctx, -2);
+		if (!duk_has_prop(ctx, instance_idx))
+		{
+			duk_pop_3(ctx);
+			return Result::RESTART;
+		}
+		duk_pop_2(ctx);
+	}
+	duk_pop(ctx);
+
+	duk_enum(ctx, script_idx, DUK_ENUM_OWN_PROPERTIES_ONLY);
+	while (duk_next(ctx, -1, 1))
+	{
+		// [enum key value]
+		if (duk_is_function(ctx, -1))
+		{
+			duk_put_prop(ctx, instance_idx);
+			continue;
+		}
+		duk_dup(ctx, -2);
+		if (duk_has_prop(ctx, instance_idx))
+		{
+			duk_pop_2(ctx);
+			continue;
+		}
+		duk_put_prop(ctx, instance_idx);
+	}
+	duk_pop(ctx);
+
+	for (const char* callback : CALLBACKS)
+	{
+		if (duk_has_prop_string(ctx, script_idx, callback)) continue;
+		duk_get_prop_string(ctx, instance_idx, callback);
+		bool is_function = duk_is_function(ctx, -1);
+		duk_pop(ctx);
+		if (is_function) duk_del_prop_string(ctx, instance_idx, callback);
+	}
+	return Result::SWAPPED;
+}
+
+
+} // namespace JSHotReload
+} // namespace Lumix
@@ -0,0 +1,33 @@
+#pragma once
+
+
+#include "engine/lumix.h"
+#include "duktape/duktape.h"
+
+
+namespace Lumix
+{
+namespace JSHotReload
+{
+
+
+enum class Result
+{
+	SWAPPED, // instance runs the new functions and keeps its data
+	RESTART // the new script adds fields which can not be shared, start the instance again
+};
+
+
+// Moves the functions of a freshly evaluated script object (script_idx) to a running
+// instance (instance_idx), so a reload evaluates the source once instead of once per
+// instance. Data fields of the instance are kept, missing primitive fields are added.
+// Callbacks removed from the script are deleted, other functions may have been set at runtime.
+// The functions are shared as they are: a function which closes over variables of the script,
+// e.g. (function() { var e = _entity; return { update : function() { e... } }; })(), sees the
+// variables of the reload evaluation in all instances, where _entity is undefined. Such scripts
+// must keep their state in this.
+Result apply(duk_context* ctx, duk_idx_t instance_idx, duk_idx_t script_idx);
+
+
+} // namespace JSHotReload
+} // namespace Lumix
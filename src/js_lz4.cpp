@@ -0,0 +1,151 @@
+#include "js_lz4.h"
+#include "engine/string.h"
+
+
+namespace Lumix
+{
+namespace JSLZ4
+{
+
+
+static const int MIN_MATCH = 4;
+static const int LAST_LITERALS = 5; // the block ends with at least this many literals
+static const int MF_LIMIT = 12; // no match starts in the last MF_LIMIT bytes
+static const int MAX_OFFSET = 0xffff;
+static const int HASH_BITS = 12;
+
+
+static u32 read32(const u8* p)
+{
+	return u32(p[0]) | (u32(p[1]) << 8) | (u32(p[2]) << 16) | (u32(p[3]) << 24);
+}
+
+
+static u32 hash(u32 value)
+{
+	return (value * 2654435761U) >> (32 - HASH_BITS);
+}
+
+
+static u8* writeLength(u8* dst, int length)
+{
+	for (; length >= 255; length -= 255) *dst++ = 255;
+	*dst++ = (u8)length;
+	return dst;
+}
+
+
+int compressBound(int size)
+{
+	return size + size / 255 + 16;
+}
+
+
+static u8* writeSequence(u8* dst, const u8* literals, int literal_count, int offset, int match_length)
+{
+	u8* token = dst++;
+	int match_code = match_length - MIN_MATCH;
+	*token = u8((literal_count < 15 ? literal_count : 15) << 4);
+	if (literal_count >= 15) dst = writeLength(dst, literal_count - 15);
+	copyMemory(dst, literals, literal_count);
+	dst += literal_count;
+	if (match_length == 0) return dst; // last literals
+
+	*dst++ = u8(offset);
+	*dst++ = u8(offset >> 8);
+	*token |= u8(match_code < 15 ? match_code : 15);
+	if (match_code >= 15) dst = writeLength(dst, match_code - 15);
+	return dst;
+}
+
+
+int compress(const u8* src, int size, u8* dst, int capacity)
+{
+	if (capacity < compressBound(size)) return 0;
+
+	int table[1 << HASH_BITS];
+	for (int& i : table) i = -1;
+
+	u8* out = dst;
+	int anchor = 0;
+	int pos = 0;
+	int match_limit = size - MF_LIMIT;
+	while (pos < match_limit)
+	{
+		u32 sequence = read32(src + pos);
+		u32 h = hash(sequence);
+		int candidate = table[h];
+		table[h] = pos;
+		if (candidate < 0 || pos - candidate > MAX_OFFSET || read32(src + candidate) != sequence)
+		{
+			++pos;
+			continue;
+		}
+
+		int length = MIN_MATCH;
+		int end = size - LAST_LITERALS;
+		while (pos + length < end && src[candidate + length] == src[pos + length]) ++length;
+
+		out = writeSequence(out, src + anchor, pos - anchor, pos - candidate, length);
+		pos += length;
+		anchor = pos;
+	}
+	out = writeSequence(out, src + anchor, size - anchor, 0, 0);
+	return int(out - dst);
+}
+
+
+bool decompress(const u8* src, int src_size, u8* dst, int size)
+{
+	const u8* in = src;
+	const u8* in_end = src + src_size;
+	u8* out = dst;
+	u8* out_end = dst + size;
+	while (in < in_end)
+	{
+		u8 token = *in++;
+		int literal_count = token >> 4;
+		if (literal_count == 15)
+		{
+			u8 b;
+			do
+			{
+				if (in >= in_end) return false;
+				b = *in++;
+				literal_count += b;
+			} while (b == 255);
+		}
+		if (literal_count > in_end - in || literal_count > out_end - out) return false;
+		copyMemory(out, in, literal_count);
+		in += literal_count;
+		out += literal_count;
+		if (in == in_end) break; // last literals
+
+		if (in_end - in < 2) return false;
+		int offset = in[0] | (in[1] << 8);
+		in += 2;
+		if (offset == 0 || offset > out - dst) return false;
+
+		int match_length = (token & 15) + MIN_MATCH;
+		if ((token & 15) == 15)
+		{
+			u8 b;
+			do
+			{
+				if (in >= in_end) return false;
+				b = *in++;
+				match_length += b;
+			} while (b == 255);
+		}
+		if (match_length > out_end - out) return false;
+		// overlapping copy, byte by byte
+		const u8* match = out - offset;
+		for (int i = 0; i < match_length; ++i) out[i] = match[i];
+		out += match_length;
+	}
+	return out == out_end;
+}
+
+
+} // namespace JSLZ4
+} // namespace Lumix
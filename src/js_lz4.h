@@ -0,0 +1,23 @@
+#pragma once
+
+
+#include "engine/lumix.h"
+
+
+namespace Lumix
+{
+namespace JSLZ4
+{
+
+
+// LZ4 block format, no frame header, compatible with LZ4_decompress_safe.
+// The compressor is a simple greedy one, scripts are packed offline.
+int compressBound(int size);
+// returns the compressed size or 0 if dst is too small
+int compress(const u8* src, int size, u8* dst, int capacity);
+// returns false if the data is corrupted or does not decompress to exactly size bytes
+bool decompress(const u8* src, int src_size, u8* dst, int size);
+
+
+} // namespace JSLZ4
+} // namespace Lumix
@@ -0,0 +1,339 @@
+#include "js_profiler.h"
+#include "engine/blob.h"
+#include "engine/crc32.h"
+#include "engine/fs/os_file.h"
+#include "engine/iallocator.h"
+#include "engine/log.h"
+#include "engine/timer.h"
+
+
+namespace Lumix
+{
+
+
+static const int MAX_STACK_DEPTH = 64;
+// reserved when the profiler starts, samples do not allocate until these are exceeded
+static const int RESERVED_FRAMES = 1024;
+static const int RESERVED_STACKS = 4096;
+static const int RESERVED_STACK_FRAMES = 64 * 1024;
+static const int RESERVED_STRINGS = 64 * 1024;
+
+
+static void writeString(OutputBlob& blob, const char* str)
+{
+	blob.write(str, stringLength(str));
+}
+
+
+static void writeInt(OutputBlob& blob, int value)
+{
+	char tmp[32];
+	toCString(value, tmp, lengthOf(tmp));
+	writeString(blob, tmp);
+}
+
+
+static void writeJSONString(OutputBlob& blob, const char* str)
+{
+	blob.write('"');
+	for (const char* c = str; *c; ++c)
+	{
+		switch (*c)
+		{
+			case '"': writeString(blob, "\\\""); break;
+			case '\\': writeString(blob, "\\\\"); break;
+			case '\n': writeString(blob, "\\n"); break;
+			case '\r': writeString(blob, "\\r"); break;
+			case '\t': writeString(blob, "\\t"); break;
+			default:
+				if ((u8)*c >= 0x20) blob.write(*c);
+				break;
+		}
+	}
+	blob.write('"');
+}
+
+
+JSProfiler::JSProfiler(IAllocator& allocator)
+	: m_allocator(allocator)
+	, m_context(nullptr)
+	, m_frames(allocator)
+	, m_frame_map(allocator)
+	, m_stacks(allocator)
+	, m_stack_map(allocator)
+	, m_stack_frames(allocator)
+	, m_strings(allocator)
+	, m_is_running(false)
+	, m_interrupt_instructions(1000)
+	, m_next_sample(0)
+	, m_sample_count(0)
+{
+	m_timer = Timer::create(allocator);
+	setSampleInterval(1);
+}
+
+
+JSProfiler::~JSProfiler()
+{
+	Timer::destroy(m_timer);
+}
+
+
+void JSProfiler::start()
+{
+	if (m_frames.capacity() < RESERVED_FRAMES)
+	{
+		m_frames.reserve(RESERVED_FRAMES);
+		m_frame_map.rehash(RESERVED_FRAMES * 2);
+	}
+	if (m_stacks.capacity() < RESERVED_STACKS)
+	{
+		m_stacks.reserve(RESERVED_STACKS);
+		m_stack_map.rehash(RESERVED_STACKS * 2);
+	}
+	m_stack_frames.reserve(RESERVED_STACK_FRAMES);
+	m_strings.reserve(RESERVED_STRINGS);
+
+	// the interrupt interval is lowered from the next interrupt on, see lumix_duk_interrupt_interval
+	m_is_running = true;
+	m_next_sample = 0;
+}
+
+
+void JSProfiler::stop()
+{
+	m_is_running = false;
+}
+
+
+void JSProfiler::clear()
+{
+	m_frames.clear();
+	m_frame_map.clear();
+	m_stacks.clear();
+	m_stack_map.clear();
+	m_stack_frames.clear();
+	m_strings.clear();
+	m_sample_count = 0;
+}
+
+
+void JSProfiler::setSampleInterval(float ms)
+{
+	m_sample_interval = ms < 0.01f ? 0.01f : ms;
+	m_sample_ticks = u64(m_sample_interval * 0.001f * m_timer->getFrequency());
+}
+
+
+// fewer instructions honor shorter intervals, at the cost of reading the timer more often
+void JSProfiler::setInterruptInstructions(int count)
+{
+	m_interrupt_instructions = count < 100 ? 100 : count;
+}
+
+
+// called every getInterruptInterval bytecode instructions from inside the executor,
+// keep the early out cheap and do not call duktape API
+void JSProfiler::onInterrupt()
+{
+	if (!m_is_running || !m_context) return;
+
+	u64 now = m_timer->getRawTimeSinceStart();
+	if (now < m_next_sample) return;
+	m_next_sample = now + m_sample_ticks;
+
+	sample();
+}
+
+
+void JSProfiler::sample()
+{
+	lumix_duk_frame duk_frames[MAX_STACK_DEPTH];
+	int depth = lumix_duk_get_callstack(m_context, duk_frames, MAX_STACK_DEPTH);
+	if (depth == 0) return;
+
+	int frames[MAX_STACK_DEPTH];
+	for (int i = 0; i < depth; ++i)
+	{
+		const lumix_duk_frame& frame = duk_frames[i];
+		const char* name = frame.name && frame.name[0] ? frame.name : "(anonymous)";
+		frames[i] = getFrame(name, frame.file_name ? frame.file_name : "", (int)frame.line);
+	}
+
+	// root first
+	for (int i = 0, j = depth - 1; i < j; ++i, --j)
+	{
+		int tmp = frames[i];
+		frames[i] = frames[j];
+		frames[j] = tmp;
+	}
+	++m_stacks[getStack(frames, depth)].sample_count;
+	++m_sample_count;
+}
+
+
+int JSProfiler::getFrame(const char* name, const char* file, int line)
+{
+	u32 hash = continueCrc32(continueCrc32(crc32(&line, sizeof(line)), name), file);
+	auto iter = m_frame_map.find(hash);
+	if (iter != m_frame_map.end())
+	{
+		if (isFrame(m_frames[iter.value()], name, file, line)) return iter.value();
+
+		// hash collision
+		for (int i = 0, c = m_frames.size(); i < c; ++i)
+		{
+			const Frame& frame = m_frames[i];
+			if (frame.hash == hash && isFrame(frame, name, file, line)) return i;
+		}
+	}
+
+	Frame& frame = m_frames.emplace();
+	frame.hash = hash;
+	frame.line = line;
+	frame.name = addString(name);
+	frame.file = addString(file);
+	if (iter == m_frame_map.end()) m_frame_map.insert(hash, m_frames.size() - 1);
+	return m_frames.size() - 1;
+}
+
+
+bool JSProfiler::isFrame(const Frame& frame, const char* name, const char* file, int line) const
+{
+	return frame.line == line && equalStrings(getString(frame.name), name) && equalStrings(getString(frame.file), file);
+}
+
+
+int JSProfiler::addString(const char* str)
+{
+	int offset = m_strings.size();
+	for (const char* c = str; *c; ++c) m_strings.push(*c);
+	m_strings.push('\0');
+	return offset;
+}
+
+
+int JSProfiler::getStack(const int* frames, int count)
+{
+	auto isSame = [&](const Stack& stack) {
+		if (stack.frame_count != count) return false;
+		return compareMemory(&m_stack_frames[stack.first_frame], frames, sizeof(frames[0]) * count) == 0;
+	};
+
+	u32 hash = crc32(frames, sizeof(frames[0]) * count);
+	auto iter = m_stack_map.find(hash);
+	if (iter != m_stack_map.end())
+	{
+		if (isSame(m_stacks[iter.value()])) return iter.value();
+
+		// hash collision
+		for (int i = 0, c = m_stacks.size(); i < c; ++i)
+		{
+			if (m_stacks[i].hash == hash && isSame(m_stacks[i])) return i;
+		}
+	}
+
+	Stack& stack = m_stacks.emplace();
+	stack.hash = hash;
+	stack.first_frame = m_stack_frames.size();
+	stack.frame_count = count;
+	stack.sample_count = 0;
+	for (int i = 0; i < count; ++i) m_stack_frames.push(frames[i]);
+	if (iter == m_stack_map.end()) m_stack_map.insert(hash, m_stacks.size() - 1);
+	return m_stacks.size() - 1;
+}
+
+
+// one line per stack: "root;caller;callee count", as consumed by flamegraph.pl
+void JSProfiler::writeCollapsed(OutputBlob& blob)
+{
+	for (const Stack& stack : m_stacks)
+	{
+		for (int i = 0; i < stack.frame_count; ++i)
+		{
+			const Frame& frame = m_frames[m_stack_frames[stack.first_frame + i]];
+			if (i > 0) blob.write(';');
+			writeString(blob, getString(frame.name));
+			writeString(blob, " (");
+			writeString(blob, getString(frame.file));
+			blob.write(':');
+			writeInt(blob, frame.line);
+			blob.write(')');
+		}
+		blob.write(' ');
+		writeInt(blob, stack.sample_count);
+		blob.write('\n');
+	}
+}
+
+
+// https://www.speedscope.app/file-format-schema.json, one sampled profile weighted by sample count
+void JSProfiler::writeSpeedscope(OutputBlob& blob)
+{
+	writeString(blob, "{\"$schema\":\"https://www.speedscope.app/file-format-schema.json\",\"shared\":{\"frames\":[");
+	for (int i = 0, c = m_frames.size(); i < c; ++i)
+	{
+		const Frame& frame = m_frames[i];
+		if (i > 0) blob.write(',');
+		writeString(blob, "{\"name\":");
+		writeJSONString(blob, getString(frame.name));
+		writeString(blob, ",\"file\":");
+		writeJSONString(blob, getString(frame.file));
+		writeString(blob, ",\"line\":");
+		writeInt(blob, frame.line);
+		blob.write('}');
+	}
+	writeString(blob, "]},\"profiles\":[{\"type\":\"sampled\",\"name\":\"JS Script\",\"unit\":\"none\",\"startValue\":0,\"endValue\":");
+	writeInt(blob, m_sample_count);
+	writeString(blob, ",\"samples\":[");
+	for (int i = 0, c = m_stacks.size(); i < c; ++i)
+	{
+		const Stack& stack = m_stacks[i];
+		if (i > 0) blob.write(',');
+		blob.write('[');
+		for (int j = 0; j < stack.frame_count; ++j)
+		{
+			if (j > 0) blob.write(',');
+			writeInt(blob, m_stack_frames[stack.first_frame + j]);
+		}
+		blob.write(']');
+	}
+	writeString(blob, "],\"weights\":[");
+	for (int i = 0, c = m_stacks.size(); i < c; ++i)
+	{
+		if (i > 0) blob.write(',');
+		writeInt(blob, m_stacks[i].sample_count);
+	}
+	writeString(blob, "]}]}");
+}
+
+
+void JSProfiler::write(OutputBlob& blob, Format format)
+{
+	switch (format)
+	{
+		case Format::COLLAPSED: writeCollapsed(blob); break;
+		case Format::SPEEDSCOPE: writeSpeedscope(blob); break;
+		default: ASSERT(false); break;
+	}
+}
+
+
+bool JSProfiler::save(const char* path, Format format)
+{
+	OutputBlob blob(m_allocator);
+	write(blob, format);
+
+	FS::OsFile file;
+	if (!file.open(path, FS::Mode::CREATE_AND_WRITE, m_allocator))
+	{
+		g_log_error.log("JS Script") << "Failed to create " << path;
+		return false;
+	}
+	bool success = file.write(blob.getData(), blob.getPos());
+	file.close();
+	return success;
+}
+
+
+} // namespace Lumix
@@ -0,0 +1,102 @@
+#pragma once
+
+
+#include "engine/array.h"
+#include "engine/hash_map.h"
+#include "engine/lumix.h"
+#include "engine/string.h"
+#include "duktape/duktape.h"
+
+
+namespace Lumix
+{
+
+
+class OutputBlob;
+class Timer;
+struct IAllocator;
+
+
+// Sampling profiler driven by duktape's interrupt counter, see DUK_USE_EXEC_TIMEOUT_CHECK in duk_config.h.
+// A sample is taken at the first interrupt after the interval, the call stack is read natively.
+// While running, the interrupt is taken every getInterruptInstructions bytecode instructions,
+// which bounds how short an interval can be honored.
+// Samples are aggregated per call stack, frames are identified by function, file and line.
+class JSProfiler
+{
+public:
+	enum class Format
+	{
+		COLLAPSED,
+		SPEEDSCOPE
+	};
+
+public:
+	explicit JSProfiler(IAllocator& allocator);
+	~JSProfiler();
+
+	void setContext(duk_context* ctx) { m_context = ctx; }
+	void start();
+	void stop();
+	void clear();
+	bool isRunning() const { return m_is_running; }
+	void setSampleInterval(float ms);
+	float getSampleInterval() const { return m_sample_interval; }
+	void setInterruptInstructions(int count);
+	int getInterruptInstructions() const { return m_interrupt_instructions; }
+	// instructions until the next interrupt, 0 for duktape's default when not running
+	int getInterruptInterval() const { return m_is_running ? m_interrupt_instructions : 0; }
+	int getSampleCount() const { return m_sample_count; }
+	void onInterrupt();
+	void write(OutputBlob& blob, Format format);
+	bool save(const char* path, Format format);
+
+private:
+	// name and file are offsets into m_strings, so a new frame does not allocate
+	// until the buffers reserved in start are full
+	struct Frame
+	{
+		u32 hash;
+		int line;
+		int name;
+		int file;
+	};
+
+	struct Stack
+	{
+		u32 hash;
+		int first_frame;
+		int frame_count;
+		int sample_count;
+	};
+
+private:
+	void sample();
+	int getFrame(const char* name, const char* file, int line);
+	bool isFrame(const Frame& frame, const char* name, const char* file, int line) const;
+	int addString(const char* str);
+	const char* getString(int offset) const { return &m_strings[offset]; }
+	int getStack(const int* frames, int count);
+	void writeCollapsed(OutputBlob& blob);
+	void writeSpeedscope(OutputBlob& blob);
+
+private:
+	IAllocator& m_allocator;
+	duk_context* m_context;
+	Timer* m_timer;
+	Array<Frame> m_frames;
+	HashMap<u32, int> m_frame_map;
+	Array<Stack> m_stacks;
+	HashMap<u32, int> m_stack_map;
+	Array<int> m_stack_frames;
+	Array<char> m_strings;
+	bool m_is_running;
+	int m_interrupt_instructions;
+	float m_sample_interval;
+	u64 m_sample_ticks;
+	u64 m_next_sample;
+	int m_sample_count;
+};
+
+
+} // namespace Lumix
@@ -1,8 +1,11 @@
-#include "JS_script_manager.h"
+#include "js_script_manager.h"
 
 #include "engine/crc32.h"
 #include "engine/log.h"
 #include "engine/fs/file_system.h"
+#include "js_bundle.h"
+#include "js_compiler.h"
+#include "js_tracer.h"
 
 
 namespace Lumix
@@ -11,7 +14,18 @@ namespace Lumix
 
 JSScript::JSScript(const Path& path, ResourceManagerBase& resource_manager, IAllocator& allocator)
 	: Resource(path, resource_manager, allocator)
+	, m_allocator(allocator)
 	, m_source_code(allocator)
+	, m_source_hash(0)
+	, m_is_source_released(false)
+	, m_is_loading_modules(false)
+	, m_is_function_cached(false)
+	, m_is_module_cached(false)
+	, m_is_used_as_script(false)
+	, m_requiring_count(0)
+	, m_modules(allocator)
+	, m_bytecode(allocator)
+	, m_module_bytecode(allocator)
 {
 }
 
@@ -24,7 +38,87 @@ JSScript::~JSScript()
 
 void JSScript::unload()
 {
+	for (JSScript* module : m_modules)
+	{
+		--module->m_requiring_count;
+		removeDependency(*module);
+		m_resource_manager.unload(*module);
+	}
+	m_modules.clear();
 	m_source_code = "";
+	m_is_source_released = false;
+	releaseBytecode();
+	// the bytecode of a modified source is useless
+	JSCompiler* compiler = static_cast<JSScriptManager&>(m_resource_manager).getCompiler();
+	if (compiler) compiler->drop(getPath());
+}
+
+
+void JSScript::releaseBytecode()
+{
+	Array<u8> empty(m_allocator);
+	m_bytecode.swap(empty);
+	Array<u8> empty_module(m_allocator);
+	m_module_bytecode.swap(empty_module);
+}
+
+
+void JSScript::releaseSource()
+{
+	m_source_code = "";
+	m_is_source_released = true;
+	releaseBytecode();
+	// a module is never loaded through the compiler, nor is a cached function loaded again
+	JSCompiler* compiler = static_cast<JSScriptManager&>(m_resource_manager).getCompiler();
+	if (compiler) compiler->drop(getPath());
+}
+
+
+// the caches are keyed by the hash, they stay valid if a reload does not change the source
+void JSScript::setSourceHash(u32 hash)
+{
+	if (hash == m_source_hash) return;
+
+	m_source_hash = hash;
+	m_is_function_cached = false;
+	m_is_module_cached = false;
+}
+
+
+// the same file can be both a script and a module, each compiled from the source. The function
+// is needed by entities, the module by the scripts which require it and by bundles which
+// precompiled it, the source is released once the needed caches are filled
+void JSScript::releaseCachedSource()
+{
+	bool is_module_needed = m_requiring_count > 0 || !m_module_bytecode.empty();
+	if (m_is_used_as_script && !m_is_function_cached) return;
+	if (is_module_needed && !m_is_module_cached) return;
+	releaseSource();
+}
+
+
+void JSScript::setFunctionCached()
+{
+	m_is_function_cached = true;
+	releaseCachedSource();
+}
+
+
+void JSScript::setModuleCached()
+{
+	m_is_module_cached = true;
+	releaseCachedSource();
+}
+
+
+// a module released before an entity used it is read again, the scripts requiring it reload too
+void JSScript::setUsedAsScript()
+{
+	m_is_used_as_script = true;
+	if (isReady() && m_is_source_released && m_is_module_cached && !m_is_function_cached)
+	{
+		m_resource_manager.reload(*this);
+	}
 }
 
 
@@ -56,10 +150,231 @@ static const char* getToken(const char* src, char* dest, int size)
 }
 
 
+void resolveJSModulePath(const char* base_path, const char* request, char* out, int max_size)
+{
+	char tmp[MAX_PATH_LENGTH];
+	tmp[0] = '\0';
+	if (request[0] == '.')
+	{
+		// directory of the requiring file, with the trailing slash
+		copyString(tmp, base_path);
+		char* last_slash = nullptr;
+		for (char* c = tmp; *c; ++c)
+		{
+			if (*c == '/' || *c == '\\') last_slash = c;
+		}
+		if (last_slash) last_slash[1] = '\0';
+		else tmp[0] = '\0';
+
+		while (request[0] == '.')
+		{
+			if (request[1] == '/')
+			{
+				request += 2;
+			}
+			else if (request[1] == '.' && request[2] == '/')
+			{
+				request += 3;
+				int len = stringLength(tmp);
+				if (len > 0) tmp[len - 1] = '\0';
+				char* c = tmp + stringLength(tmp);
+				while (c > tmp && c[-1] != '/' && c[-1] != '\\') --c;
+				*c = '\0';
+			}
+			else
+			{
+				break;
+			}
+		}
+	}
+	catString(tmp, request);
+
+	const char* last_dot = nullptr;
+	for (const char* c = tmp; *c; ++c)
+	{
+		if (*c == '.') last_dot = c;
+		if (*c == '/') last_dot = nullptr;
+	}
+	if (!last_dot) catString(tmp, ".js");
+	copyString(out, max_size, tmp);
+}
+
+
+static const char* skipComment(const char* c)
+{
+	if (c[0] != '/') return c;
+	if (c[1] == '/')
+	{
+		while (*c && *c != '\n') ++c;
+	}
+	else if (c[1] == '*')
+	{
+		c += 2;
+		while (*c && !(c[0] == '*' && c[1] == '/')) ++c;
+		if (*c) c += 2;
+	}
+	return c;
+}
+
+
+// require("x") in a string is not a require, an unterminated string ends with the line
+static const char* skipString(const char* c)
+{
+	char quote = c[0];
+	if (quote != '"' && quote != '\'' && quote != '`') return c;
+	++c;
+	while (*c && *c != quote)
+	{
+		if (*c == '\n' && quote != '`') return c;
+		if (*c == '\\' && c[1]) ++c;
+		++c;
+	}
+	return *c ? c + 1 : c;
+}
+
+
+void getJSRequires(const char* source, const char* base_path, Array<Path>& out)
+{
+	static const char REQUIRE[] = "require";
+	const char* c = source;
+	while (*c)
+	{
+		const char* next = skipString(skipComment(c));
+		if (next != c)
+		{
+			c = next;
+			continue;
+		}
+		if (!startsWith(c, REQUIRE) || (c > source && (isLetter(c[-1]) || c[-1] == '_' || c[-1] == '.')))
+		{
+			++c;
+			continue;
+		}
+
+		c += sizeof(REQUIRE) - 1;
+		while (isWhitespace(*c)) ++c;
+		if (*c != '(') continue;
+		++c;
+		while (isWhitespace(*c)) ++c;
+		char quote = *c;
+		if (quote != '"' && quote != '\'') continue;
+		++c;
+
+		char request[MAX_PATH_LENGTH];
+		int len = 0;
+		while (*c && *c != quote && *c != '\n' && len < lengthOf(request) - 1)
+		{
+			request[len] = *c;
+			++len;
+			++c;
+		}
+		request[len] = '\0';
+		if (*c != quote) continue;
+		++c;
+
+		char path[MAX_PATH_LENGTH];
+		resolveJSModulePath(base_path, request, path, lengthOf(path));
+		Path module_path(path);
+		bool is_listed = false;
+		for (const Path& listed : out) is_listed = is_listed || listed == module_path;
+		if (!is_listed) out.push(module_path);
+	}
+}
+
+
+// true if this requires the module, directly or through its modules. A script still loading
+// its modules is the one which, through the files loaded meanwhile, requires the module
+bool JSScript::isRequiring(const JSScript& module) const
+{
+	if (m_is_loading_modules) return true;
+	for (const JSScript* required : m_modules)
+	{
+		if (required == &module || required->isRequiring(module)) return true;
+	}
+	return false;
+}
+
+
+void JSScript::loadModule(const Path& path)
+{
+	// circular requires would never become ready
+	if (path == getPath()) return;
+
+	// whichever of the two is loaded second sees the cycle
+	auto* loaded = static_cast<JSScript*>(m_resource_manager.get(path));
+	if (loaded && loaded->isRequiring(*this))
+	{
+		g_log_error.log("JS Script") << "Circular require of " << path << " in " << getPath()
+									 << ", the script does not wait for it";
+		return;
+	}
+
+	JSScript* module = static_cast<JSScript*>(m_resource_manager.load(path));
+	++module->m_requiring_count;
+	addDependency(*module);
+	m_modules.push(module);
+}
+
+
+// require("path") with a string literal, dynamic requires must be loaded by someone else
+void JSScript::loadModules()
+{
+	Array<Path> paths(m_allocator);
+	getJSRequires(m_source_code.c_str(), getPath().c_str(), paths);
+	m_is_loading_modules = true;
+	for (const Path& path : paths) loadModule(path);
+	m_is_loading_modules = false;
+}
+
+
+bool JSScript::loadRecord(const JSBundle::Record& record)
+{
+	setSourceHash(record.source_hash);
+	m_source_code.set(record.source, record.source_size);
+	m_is_source_released = record.source_size == 0;
+	m_bytecode.resize(record.bytecode_size);
+	if (record.bytecode_size > 0) copyMemory(&m_bytecode[0], record.bytecode, record.bytecode_size);
+	m_module_bytecode.resize(record.module_bytecode_size);
+	if (record.module_bytecode_size > 0)
+	{
+		copyMemory(&m_module_bytecode[0], record.module_bytecode, record.module_bytecode_size);
+	}
+
+	const char* path = record.requires;
+	m_is_loading_modules = true;
+	for (int i = 0; i < record.require_count; ++i)
+	{
+		loadModule(Path(path));
+		path += stringLength(path) + 1;
+	}
+	m_is_loading_modules = false;
+	return true;
+}
+
+
 bool JSScript::load(FS::IFile& file)
 {
+	auto& manager = static_cast<JSScriptManager&>(m_resource_manager);
+	JSTracer* tracer = manager.getTracer();
+	if (tracer) tracer->begin("resource", "load", getPath().c_str());
+
+	// precompiled, from a bundle
+	JSBundle::Record record;
+	if (JSBundle::parseRecord(file.getBuffer(), (int)file.size(), record))
+	{
+		m_size = file.size();
+		bool is_loaded = loadRecord(record);
+		if (tracer) tracer->end();
+		return is_loaded;
+	}
 	m_source_code.set((const char*)file.getBuffer(), (int)file.size());
+	m_is_source_released = false;
 	m_size = file.size();
+	setSourceHash(crc32(file.getBuffer(), (int)file.size()));
+	JSCompiler* compiler = manager.getCompiler();
+	if (compiler) compiler->compile(getPath(), getSourceCode(), getSourceSize(), m_source_hash);
+	loadModules();
+	if (tracer) tracer->end();
 	return true;
 }
 
@@ -67,6 +382,8 @@ bool JSScript::load(FS::IFile& file)
 JSScriptManager::JSScriptManager(IAllocator& allocator)
 	: ResourceManagerBase(allocator)
 	, m_allocator(allocator)
+	, m_tracer(nullptr)
+	, m_compiler(nullptr)
 {
 }
 
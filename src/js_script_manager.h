@@ -5,12 +5,24 @@
 #include "engine/resource.h"
 #include "engine/resource_manager_base.h"
 #include "engine/string.h"
+#include "js_bundle.h"
 
 
 namespace Lumix
 {
 
 
+class JSCompiler;
+class JSTracer;
+
+
+// Resolves a require() request, "./" and "../" are relative to the requiring file,
+// other paths to the project. ".js" is appended if there is no extension.
+void resolveJSModulePath(const char* base_path, const char* request, char* out, int max_size);
+// Resolved paths of require("literal") calls in the source, each path once.
+void getJSRequires(const char* source, const char* base_path, Array<Path>& out);
+
+
 class JSScript LUMIX_FINAL : public Resource
 {
 public:
@@ -19,10 +31,48 @@ public:
 
 	void unload() override;
 	bool load(FS::IFile& file) override;
+	// the source is one buffer of getSourceSize bytes, empty once it is released
 	const char* getSourceCode() const { return m_source_code.c_str(); }
+	int getSourceSize() const { return m_source_code.length(); }
+	bool hasSource() const { return !m_is_source_released; }
+	// precompiled eval code and module function, empty unless loaded from a bundle
+	const Array<u8>& getBytecode() const { return m_bytecode; }
+	const Array<u8>& getModuleBytecode() const { return m_module_bytecode; }
+	// called when the script function or the evaluated module is cached, the source and the
+	// bytecode are released once every cache the file is used for is, a reload reads the file again
+	void setFunctionCached();
+	void setModuleCached();
+	// the file is a script of an entity and needs the function cache, see releaseCachedSource
+	void setUsedAsScript();
+	// changes when a reload changes the source
+	u32 getSourceHash() const { return m_source_hash; }
+	// modules required with a string literal, loaded before the script is ready
+	int getModuleCount() const { return m_modules.size(); }
+	JSScript* getModule(int idx) const { return m_modules[idx]; }
 
 private:
+	bool isRequiring(const JSScript& module) const;
+	void loadModule(const Path& path);
+	void loadModules();
+	bool loadRecord(const JSBundle::Record& record);
+	void releaseBytecode();
+	void releaseSource();
+	void releaseCachedSource();
+	void setSourceHash(u32 hash);
+
+private:
+	IAllocator& m_allocator;
 	string m_source_code;
+	u32 m_source_hash;
+	bool m_is_source_released;
+	bool m_is_loading_modules;
+	bool m_is_function_cached;
+	bool m_is_module_cached;
+	bool m_is_used_as_script;
+	int m_requiring_count; // loaded scripts which have this in m_modules
+	Array<JSScript*> m_modules;
+	Array<u8> m_bytecode;
+	Array<u8> m_module_bytecode;
 };
 
 
@@ -32,12 +82,20 @@ public:
 	explicit JSScriptManager(IAllocator& allocator);
 	~JSScriptManager();
 
+	void setTracer(JSTracer* tracer) { m_tracer = tracer; }
+	JSTracer* getTracer() const { return m_tracer; }
+	// loaded scripts are queued for the background compile
+	void setCompiler(JSCompiler* compiler) { m_compiler = compiler; }
+	JSCompiler* getCompiler() const { return m_compiler; }
+
 protected:
 	Resource* createResource(const Path& path) override;
 	void destroyResource(Resource& resource) override;
 
 private:
 	IAllocator& m_allocator;
+	JSTracer* m_tracer;
+	JSCompiler* m_compiler;
 };
 
 
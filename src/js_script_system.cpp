@@ -1,4 +1,4 @@
-#include "JS_script_system.h"
+#include "js_script_system.h"
 #include "engine/array.h"
 #include "engine/base_proxy_allocator.h"
 #include "engine/binary_array.h"
@@ -19,9 +19,21 @@
 #include "engine/resource_manager.h"
 #include "engine/serializer.h"
 #include "engine/string.h"
+#include "engine/timer.h"
 #include "engine/universe/universe.h"
 #include "imgui/imgui.h"
+#include "js_alloc_tracker.h"
+#include "js_binding_stats.h"
+#include "js_bundle.h"
+#include "js_compiler.h"
+#include "js_gc_scheduler.h"
+#include "js_heap_monitor.h"
+#include "js_hot_reload.h"
+#include "js_profiler.h"
 #include "js_script_manager.h"
+#include "js_timer_queue.h"
+#include "js_tracer.h"
+#include "js_snapshot.h"
 #include "js_wrapper.h"
 
 
@@ -29,6 +41,10 @@ namespace Lumix
 {
 	static const ComponentType JS_SCRIPT_TYPE = PropertyRegister::getComponentType("js_script");
 	static const ResourceType JS_SCRIPT_RESOURCE_TYPE("js_script");
+	// allocation site of the plugin code between update callbacks
+	static const char* const DISPATCH_SITE = "update dispatch";
+	// per script, destroyed instances above the limit are collected
+	static const duk_size_t MAX_POOLED_INSTANCES = 1024;
 
 	namespace JSImGui
 	{
@@ -152,6 +168,8 @@ namespace Lumix
 	enum class JSSceneVersion : int
 	{
 		PROPERTY_TYPE,
+		SNAPSHOT,
+		TEXT_SNAPSHOT,
 
 		LATEST
 	};
@@ -207,9 +225,57 @@ namespace Lumix
 		return 0;
 	}
 
+	static JSAllocTracker& getAllocTracker(duk_context* ctx);
+	static JSTracer& getTracer(duk_context* ctx);
+	static JSBindingStats& getBindingStats(duk_context* ctx);
+
+
+	// set when the binding is registered, see instrumented()
+	template <duk_c_function F> struct BindingIndex
+	{
+		static int value;
+	};
+	template <duk_c_function F> int BindingIndex<F>::value = -1;
+
+
+	template <duk_c_function F> static int instrumentedBinding(duk_context* ctx)
+	{
+		JSTracer& tracer = getTracer(ctx);
+		JSBindingStats& stats = getBindingStats(ctx);
+		if (!tracer.isRunning() && !stats.isEnabled()) return F(ctx);
+
+		// not recorded if F throws, the enclosing callback restores the state, see endScript
+		int prev_binding = stats.beginCall(BindingIndex<F>::value);
+		u64 start_time = stats.getTime();
+		int ret = F(ctx);
+		u64 duration = stats.getTime() - start_time;
+		int binding = stats.endCall(prev_binding, duration);
+		if (binding >= 0) tracer.binding(stats.getBindingName(binding), duration);
+		return ret;
+	}
+
+
+	template <duk_c_function F> static duk_c_function instrumented(JSBindingStats& stats, const char* name)
+	{
+		BindingIndex<F>::value = stats.addBinding(name);
+		return &instrumentedBinding<F>;
+	}
+
 	
 	static int entityProxyGetter(duk_context* ctx)
 	{
+		JSAllocTracker::Scope alloc_scope(getAllocTracker(ctx), "entityProxyGetter");
+
+		// c_universe and c_entity of the target are visible through the proxy, any other
+		// name is a component, inherited members like toString are not looked up
+		const char* cmp_type_name = duk_get_string(ctx, 1);
+		if (!cmp_type_name) return 0;
+		if (equalStrings(cmp_type_name, "c_universe") || equalStrings(cmp_type_name, "c_entity"))
+		{
+			duk_get_prop_string(ctx, 0, cmp_type_name);
+			return 1;
+		}
+
 		duk_get_prop_string(ctx, 0, "c_universe");
 		Universe* universe = (Universe*)duk_get_pointer(ctx, -1);
 
@@ -218,7 +284,6 @@ namespace Lumix
 
 		duk_pop_2(ctx);
 
-		const char* cmp_type_name = duk_get_string(ctx, 1);
 		ComponentType cmp_type = PropertyRegister::getComponentType(cmp_type_name);
 
 		IScene* scene = universe->getScene(cmp_type);
@@ -227,11 +292,36 @@ namespace Lumix
 		ComponentHandle cmp = scene->getComponent(entity, cmp_type);
 		if (!cmp.isValid()) return 0;
 
+		// component objects are cached in a hidden object on the target,
+		// so repeated lookups do not allocate
+		if (!duk_get_prop_string(ctx, 0, "\xff" "components"))
+		{
+			duk_pop(ctx);
+			duk_push_object(ctx);
+			duk_dup(ctx, -1);
+			duk_put_prop_string(ctx, 0, "\xff" "components");
+		}
+		duk_dup(ctx, 1);
+		if (duk_get_prop(ctx, -2)) // [cache, cmp_obj]
+		{
+			duk_get_prop_string(ctx, -1, "c_cmphandle");
+			bool is_valid = duk_get_int(ctx, -1) == cmp.index;
+			duk_pop(ctx);
+			if (is_valid) return 1;
+		}
+		duk_pop(ctx);
+
+		// the new object is attributed to the script, the constructor can throw
+		alloc_scope.end();
 		duk_get_global_string(ctx, cmp_type_name);
 		JSWrapper::push(ctx, scene);
 		JSWrapper::push(ctx, cmp);
 		duk_new(ctx, 2);
 
+		duk_dup(ctx, 1);
+		duk_dup(ctx, -2);
+		duk_put_prop(ctx, -4); // cache[name] = cmp_obj
+
 		return 1;
 	}
 
@@ -250,9 +340,10 @@ namespace Lumix
 		duk_dup(ctx, 1);
 		duk_put_prop_string(ctx, -2, "c_entity");
 
-		duk_push_object(ctx); //proxy handler
-		duk_push_c_function(ctx, entityProxyGetter, 3);
-		duk_put_prop_string(ctx, -2, "get");
+		// the proxy handler is shared by all entities, see registerGlobalAPI
+		duk_push_current_function(ctx);
+		duk_get_prop_string(ctx, -1, "\xff" "handler");
+		duk_remove(ctx, -2);
 
 		duk_new(ctx, 2);
 
@@ -350,21 +441,41 @@ namespace Lumix
 	}
 
 
+	struct JSScriptSceneImpl;
+
+
 	struct JSScriptSystemImpl LUMIX_FINAL : public IPlugin
 	{
 		explicit JSScriptSystemImpl(Engine& engine);
 		virtual ~JSScriptSystemImpl();
 
+		void update(float time_delta) override;
 		void createScenes(Universe& universe) override;
 		void destroyScene(IScene* scene) override;
 		const char* getName() const override { return "js_script"; }
 		JSScriptManager& getScriptManager() { return m_script_manager; }
+		bool mountBundle();
+		void unmountBundle();
 		void registerGlobalAPI();
 		void registerImGuiAPI();
 
 		Engine& m_engine;
-		Debug::Allocator m_allocator;
+		Debug::Allocator m_debug_allocator;
+		JSAllocTracker m_allocator;
 		JSScriptManager m_script_manager;
+		JSProfiler m_profiler;
+		JSHeapMonitor m_heap_monitor;
+		JSTracer m_tracer;
+		JSBindingStats m_binding_stats;
+		JSGCScheduler m_gc_scheduler;
+		JSCompiler m_compiler;
+		JSBundle m_bundle;
+		JSBundleDevice m_bundle_device;
+		bool m_is_bundle_mounted = false;
+		// scripts being evaluated or called, base of their relative requires
+		Array<Path> m_script_path_stack;
+		// scene of the running script instance, see JSScriptSceneImpl::setRunningInstance
+		JSScriptSceneImpl* m_running_scene = nullptr;
 		duk_context* m_global_context;
 	};
 
@@ -375,33 +486,137 @@ namespace Lumix
 		{
 			duk_context* context;
 			uintptr id;
+			int slot;
+			int stats_index;
+			Entity entity;
+		};
+
+
+		struct ScriptResource
+		{
+			JSScript* script;
+			int ref_count;
+			bool is_started;
+			int stats_index;
+		};
+
+
+		// kept after the resource is released, until resetCallbackStats
+		struct ScriptStats
+		{
+			Path path;
+			CallbackStats callbacks[(int)Callback::COUNT];
+		};
+
+
+		struct PendingStart
+		{
+			Entity entity;
+			uintptr id;
+		};
+
+
+		// instance of a component, see findInstance
+		struct InstanceRef
+		{
+			Entity entity;
+			uintptr id;
+		};
+
+
+		struct Subscription
+		{
+			u32 event; // crc32 of the name
+			int handler; // index in the handler table
+		};
+
+
+		// posted by the engine, the arguments are in m_event_args
+		struct Event
+		{
+			u32 name_hash;
+			Entity entity; // subscribers of the entity, all subscribers if invalid
+			int args_offset;
+			int arg_count;
+			int next; // next event of the same key, see dispatchEvents
+		};
+
+
+		// sent by sendMessage and broadcast, the name and the payload are in m_mailbox
+		struct Message
+		{
+			u32 name_hash;
+			Entity entity; // invalid if broadcast
+			int next; // next message of the same key, see deliverMessages
+		};
+
+
+		// lists of the messages of the instances in one array, most instances do not receive any
+		struct ReceiveItem
+		{
+			u32 name_hash;
+			int receivers; // index in m_receivers
+			int position; // of the instance in MessageReceivers::instances
+			int next;
+		};
+
+
+		// instances which have a method of the name
+		struct MessageReceivers
+		{
+			explicit MessageReceivers(IAllocator& allocator)
+				: name(allocator)
+				, instances(allocator)
+				, items(allocator)
+			{
+			}
+
+			string name;
+			Array<InstanceRef> instances;
+			Array<int> items; // receive item of each instance, so it is removed in O(1)
+		};
+
+
+		enum class EventArgType : u8
+		{
+			INT,
+			FLOAT,
+			POINTER
 		};
 
 
 		struct ScriptInstance
 		{
 			explicit ScriptInstance(IAllocator& allocator)
-				: m_properties(allocator)
-				, m_script(nullptr)
+				: m_script(nullptr)
+				, m_properties(allocator)
+				, m_subscriptions(allocator)
+				, m_timers(allocator)
+				, m_snapshot(allocator)
+				, m_slot(-1)
+				, m_is_dormant(false)
+				, m_event_frame(0)
+				, m_first_receive(-1)
 			{
 			}
 
 			JSScript* m_script;
 			Array<Property> m_properties;
+			Array<Subscription> m_subscriptions;
+			Array<int> m_timers; // ids in JSScriptSceneImpl::m_timer_queue
+			Array<u8> m_snapshot;
 			uintptr m_id;
+			int m_slot; // index in the instance table, -1 if not running
+			bool m_is_dormant; // ready but not instantiated yet, see setLazyStart
+			u32 m_event_frame; // last dispatchEvents or deliverMessages which visited the instance
+			int m_first_receive; // messages the instance has methods for, in m_receive_items
 		};
 
 
+		// instances of a component are stored contiguously in m_instances,
+		// in a block of m_capacity slots starting at m_first_instance
 		struct ScriptComponent
 		{
-			ScriptComponent(JSScriptSceneImpl& scene, IAllocator& allocator)
-				: m_scripts(allocator)
-				, m_scene(scene)
-				, m_entity(INVALID_ENTITY)
-			{
-			}
-
-
 			static int getProperty(ScriptInstance& inst, u32 hash)
 			{
 				for(int i = 0, c = inst.m_properties.size(); i < c; ++i)
@@ -412,23 +627,28 @@ namespace Lumix
 			}
 
 
-			void onScriptLoaded(Resource::State, Resource::State, Resource& resource)
-			{
-				duk_context* ctx = m_scene.m_system.m_global_context;
-				for (auto& script : m_scripts)
-				{
-					if (!script.m_script) continue;
-					if (!script.m_script->isReady()) continue;
-					if (script.m_script != &resource) continue;
+			Entity m_entity;
+			int m_first_instance;
+			int m_instance_count;
+			int m_capacity;
+		};
 
-					m_scene.startScript(m_entity, script, false);
-				}
-			}
 
+		struct InstanceBlock
+		{
+			int first;
+			int capacity;
+		};
 
-			Array<ScriptInstance> m_scripts;
-			JSScriptSceneImpl& m_scene;
-			Entity m_entity;
+
+		// see beginCallback
+		struct CallbackScope
+		{
+			u64 start_time;
+			int prev_script;
+			const char* prev_site;
+			bool prev_is_binding;
+			JSBindingStats::State prev_binding_state;
 		};
 
 
@@ -459,212 +679,1494 @@ namespace Lumix
 			int parameter_count;
 			duk_context* context;
 			bool is_in_progress;
-			ScriptComponent* cmp;
-			int scr_index;
+			int stats_index;
+			Callback callback;
+			Entity entity;
+			CallbackScope callback_scope;
+			InstanceRef prev_running;
+		};
+
+
+		// arguments of the last posted event
+		struct EventArgs : IFunctionCall
+		{
+			template <typename T> void write(EventArgType type, T value)
+			{
+				int offset = scene->m_event_args.size();
+				scene->m_event_args.resize(offset + 1 + sizeof(value));
+				scene->m_event_args[offset] = (u8)type;
+				copyMemory(&scene->m_event_args[offset + 1], &value, sizeof(value));
+				++scene->m_events.back().arg_count;
+			}
+
+			void add(int parameter) override { write(EventArgType::INT, parameter); }
+			void add(float parameter) override { write(EventArgType::FLOAT, parameter); }
+			void add(void* parameter) override { write(EventArgType::POINTER, parameter); }
+
+			JSScriptSceneImpl* scene;
 		};
 
 
 	public:
 		JSScriptSceneImpl(JSScriptSystemImpl& system, Universe& ctx)
 			: m_system(system)
+			, m_component_map(system.m_allocator)
+			, m_components(system.m_allocator)
+			, m_instances(system.m_allocator)
+			, m_free_blocks(system.m_allocator)
+			, m_free_handlers(system.m_allocator)
+			, m_subscribers(system.m_allocator)
+			, m_events(system.m_allocator)
+			, m_event_args(system.m_allocator)
+			, m_event_map(system.m_allocator)
+			, m_timer_queue(system.m_allocator)
+			, m_expired_timers(system.m_allocator)
+			, m_receivers(system.m_allocator)
+			, m_receiver_map(system.m_allocator)
+			, m_receive_items(system.m_allocator)
+			, m_messages(system.m_allocator)
+			, m_message_map(system.m_allocator)
+			, m_free_slots(system.m_allocator)
+			, m_script_stats(system.m_allocator)
+			, m_property_names(system.m_allocator)
 			, m_universe(ctx)
-			, m_scripts(system.m_allocator)
 			, m_updates(system.m_allocator)
-			, m_property_names(system.m_allocator)
-			, m_is_game_running(false)
+			, m_script_resources(system.m_allocator)
+			, m_pending_reloads(system.m_allocator)
+			, m_pending_starts(system.m_allocator)
+			, m_pending_start_index(system.m_allocator)
+			, m_snapshot_blob(system.m_allocator)
 			, m_is_api_registered(false)
+			, m_is_game_running(false)
 		{
 			m_function_call.is_in_progress = false;
+			m_event_args_call.scene = this;
+			m_running = {INVALID_ENTITY, 0};
+			m_timer = Timer::create(system.m_allocator);
 			
 			registerAPI();
+			createInstanceTable();
 			ctx.registerComponentType(JS_SCRIPT_TYPE, this, &JSScriptSceneImpl::serializeJSScript, &JSScriptSceneImpl::deserializeJSScript);
 		}
 
 
-		int getVersion() const override { return (int)JSSceneVersion::LATEST; }
+		~JSScriptSceneImpl()
+		{
+			Timer::destroy(m_timer);
+			if (m_system.m_running_scene == this) m_system.m_running_scene = nullptr;
+
+			duk_context* ctx = m_system.m_global_context;
+			duk_push_global_stash(ctx);
+			duk_push_pointer(ctx, this);
+			duk_del_prop(ctx, -2);
+			duk_pop(ctx);
+		}
 
 
-		ComponentHandle getComponent(Entity entity) override
+		// instances are kept in a dense array indexed by ScriptInstance::m_slot,
+		// the array itself is referenced from the stash so it is not collected
+		void createInstanceTable()
 		{
-			if (m_scripts.find(entity) == m_scripts.end()) return INVALID_COMPONENT;
-			return {entity.index};
+			duk_context* ctx = m_system.m_global_context;
+			duk_push_global_stash(ctx);
+			duk_push_pointer(ctx, this);
+			duk_push_array(ctx);
+			m_instance_table = duk_get_heapptr(ctx, -1);
+			duk_push_array(ctx);
+			m_handler_table = duk_get_heapptr(ctx, -1);
+			duk_put_prop_string(ctx, -2, "\xff" "handlers");
+			duk_push_array(ctx);
+			m_mailbox = duk_get_heapptr(ctx, -1);
+			duk_put_prop_string(ctx, -2, "\xff" "mailbox");
+			duk_put_prop(ctx, -3);
+			duk_pop(ctx);
+			clearPools();
 		}
 
 
-		IFunctionCall* beginFunctionCall(ComponentHandle cmp, int scr_index, const char* function) override
+		// the pools are referenced from the instance table
+		void clearPools()
 		{
-			ASSERT(!m_function_call.is_in_progress);
+			duk_context* ctx = m_system.m_global_context;
+			duk_push_heapptr(ctx, m_instance_table);
+			duk_push_object(ctx);
+			m_pool_table = duk_get_heapptr(ctx, -1);
+			duk_put_prop_string(ctx, -2, "\xff" "pools");
+			duk_pop(ctx);
+		}
 
-			auto* script_cmp = m_scripts[{cmp.index}];
-			auto& script = script_cmp->m_scripts[scr_index];
 
-			duk_context* ctx = m_system.m_global_context;
+		// on(), off() and timers are applied to the running instance, returns the previous one
+		InstanceRef setRunningInstance(Entity entity, uintptr id)
+		{
+			InstanceRef prev = m_running;
+			m_running = {entity, id};
+			m_system.m_running_scene = this;
+			return prev;
+		}
 
-			duk_push_global_stash(ctx);
-			duk_push_pointer(ctx, (void*)script.m_id);
-			duk_get_prop(ctx, -2);
-			if (duk_is_undefined(ctx, -1))
+
+		// stores the function at fn_idx in the handler table, returns its index
+		int addHandler(int fn_idx)
+		{
+			duk_context* ctx = m_system.m_global_context;
+			fn_idx = duk_normalize_index(ctx, fn_idx);
+			int handler = m_handler_count;
+			if (m_free_handlers.empty())
 			{
-				duk_pop_2(ctx);
-				return nullptr;
+				++m_handler_count;
 			}
-			duk_get_prop_string(ctx, -1, function);
+			else
+			{
+				handler = m_free_handlers.back();
+				m_free_handlers.pop();
+			}
+			duk_push_heapptr(ctx, m_handler_table);
+			duk_dup(ctx, fn_idx);
+			duk_put_prop_index(ctx, -2, (duk_uarridx_t)handler);
+			duk_pop(ctx);
+			return handler;
+		}
+
+
+		void removeHandler(int handler)
+		{
+			duk_context* ctx = m_system.m_global_context;
+			duk_push_heapptr(ctx, m_handler_table);
+			duk_push_undefined(ctx);
+			duk_put_prop_index(ctx, -2, (duk_uarridx_t)handler);
+			duk_pop(ctx);
+			m_free_handlers.push(handler);
+		}
+
+
+		// [obj] -> [obj, handler, obj], nothing is pushed if the handler was removed
+		bool pushHandler(int handler)
+		{
+			duk_context* ctx = m_system.m_global_context;
+			duk_push_heapptr(ctx, m_handler_table);
+			duk_get_prop_index(ctx, -1, (duk_uarridx_t)handler);
+			duk_remove(ctx, -2);
 			if (!duk_is_callable(ctx, -1))
 			{
-				duk_pop_3(ctx);
-				return nullptr;
+				duk_pop(ctx);
+				return false;
 			}
-			duk_dup(ctx, -2); // [this, func] -> [this, func, this]
+			duk_dup(ctx, -2);
+			return true;
+		}
 
-			m_function_call.context = ctx;
-			m_function_call.cmp = script_cmp;
-			m_function_call.is_in_progress = true;
-			m_function_call.parameter_count = 0;
-			m_function_call.scr_index = scr_index;
 
-			return &m_function_call;
+		// [obj, handler, obj, args...] -> [obj]
+		void callHandler(int arg_count)
+		{
+			duk_context* ctx = m_system.m_global_context;
+			if (duk_pcall_method(ctx, arg_count) != 0)
+			{
+				const char* error = duk_safe_to_string(ctx, -1);
+				g_log_error.log("JS Script") << error;
+			}
+			duk_pop(ctx);
 		}
 
 
-		void endFunctionCall() override
+		// the handler at fn_idx is called for the events of the name, see dispatchEvents
+		bool subscribe(const char* name, int fn_idx)
 		{
-			ASSERT(m_function_call.is_in_progress);
+			ScriptInstance* inst = findInstance(m_running.entity, m_running.id);
+			if (!inst) return false;
 
-			m_function_call.is_in_progress = false;
+			int handler = addHandler(fn_idx);
+			if (inst->m_subscriptions.empty()) m_subscribers.push(m_running);
+			inst->m_subscriptions.push({crc32(name), handler});
+			return true;
+		}
 
-			auto& script = m_function_call.cmp->m_scripts[m_function_call.scr_index];
 
-			if (duk_pcall_method(m_function_call.context, m_function_call.parameter_count) == DUK_EXEC_ERROR)
+		// event is the hash of the name, 0 unsubscribes from all events
+		void unsubscribe(ScriptInstance& inst, u32 event)
+		{
+			if (inst.m_subscriptions.empty()) return;
+
+			for (int i = inst.m_subscriptions.size() - 1; i >= 0; --i)
 			{
-				const char* error = duk_safe_to_string(m_function_call.context, -1);
-				g_log_error.log("JS Script") << error;
+				const Subscription& sub = inst.m_subscriptions[i];
+				if (event != 0 && sub.event != event) continue;
+
+				removeHandler(sub.handler);
+				inst.m_subscriptions.erase(i);
+			}
+
+			if (!inst.m_subscriptions.empty()) return;
+			for (int i = 0; i < m_subscribers.size(); ++i)
+			{
+				if (m_subscribers[i].id == inst.m_id)
+				{
+					m_subscribers.eraseFast(i);
+					break;
+				}
 			}
-			duk_pop_2(m_function_call.context);
 		}
 
 
-		int getPropertyCount(ComponentHandle cmp, int scr_index) override
+		bool unsubscribe(const char* name)
 		{
-			return m_scripts[{cmp.index}]->m_scripts[scr_index].m_properties.size();
+			ScriptInstance* inst = findInstance(m_running.entity, m_running.id);
+			if (!inst) return false;
+			unsubscribe(*inst, crc32(name));
+			return true;
 		}
 
 
-		const char* getPropertyName(ComponentHandle cmp, int scr_index, int prop_index) override
+		IFunctionCall& postEvent(const char* name, Entity entity) override
 		{
-			return getPropertyName(m_scripts[{cmp.index}]->m_scripts[scr_index].m_properties[prop_index].name_hash);
+			Event& event = m_events.emplace();
+			event.name_hash = crc32(name);
+			event.entity = entity;
+			event.args_offset = m_event_args.size();
+			event.arg_count = 0;
+			event.next = -1;
+			return m_event_args_call;
 		}
 
 
-		ResourceType getPropertyResourceType(ComponentHandle cmp, int scr_index, int prop_index) override
+		void clearEvents()
 		{
-			return m_scripts[{cmp.index}]->m_scripts[scr_index].m_properties[prop_index].resource_type;
+			m_events.clear();
+			m_event_args.clear();
 		}
 
 
-		Property::Type getPropertyType(ComponentHandle cmp, int scr_index, int prop_index) override
+		static u32 getEventKey(u32 name_hash, Entity entity)
 		{
-			return m_scripts[{cmp.index}]->m_scripts[scr_index].m_properties[prop_index].type;
+			return name_hash ^ ((u32)entity.index * 0x9E3779B9);
 		}
 
 
-		void getScriptData(ComponentHandle cmp, OutputBlob& blob) override
+		// chains of the first count items with the same key, in the order they were posted
+		template <typename T> static void linkByKey(Array<T>& items, int count, HashMap<u32, int>& map)
 		{
-			auto* scr = m_scripts[{cmp.index}];
-			blob.write(scr->m_scripts.size());
-			for (int i = 0; i < scr->m_scripts.size(); ++i)
+			map.clear();
+			for (int i = count - 1; i >= 0; --i)
 			{
-				auto& inst = scr->m_scripts[i];
-				blob.writeString(inst.m_script ? inst.m_script->getPath().c_str() : "");
-				blob.write(inst.m_properties.size());
-				for (auto& prop : inst.m_properties)
+				T& item = items[i];
+				u32 key = getEventKey(item.name_hash, item.entity);
+				auto iter = map.find(key);
+				if (iter == map.end())
 				{
-					blob.write(prop.name_hash);
-					blob.write(prop.type);
-					char tmp[1024];
-					tmp[0] = '\0';
-					const char* prop_name = getPropertyName(prop.name_hash);
-					if(prop_name) getPropertyValue(cmp, i, getPropertyName(prop.name_hash), tmp, lengthOf(tmp));
-					blob.writeString(prop_name ? tmp : prop.stored_value.c_str());
+					item.next = -1;
+					map.insert(key, i);
+				}
+				else
+				{
+					item.next = iter.value();
+					iter.value() = i;
 				}
 			}
 		}
 
 
-		duk_context* getGlobalContext() override
+		// [obj] -> [obj], calls the handler with the arguments of the event
+		void callHandler(int handler, const Event& event)
 		{
-			return m_system.m_global_context;
-		}
-
+			duk_context* ctx = m_system.m_global_context;
+			if (!pushHandler(handler)) return;
 
-		void setScriptData(ComponentHandle cmp, InputBlob& blob) override
-		{
-			ASSERT(false); // TODO
-			/*
-			auto* scr = m_scripts[{cmp.index}];
-			int count;
-			blob.read(count);
-			for (int i = 0; i < count; ++i)
+			const u8* arg = event.arg_count > 0 ? &m_event_args[event.args_offset] : nullptr;
+			for (int i = 0; i < event.arg_count; ++i)
 			{
-				int idx = addScript(cmp);
-				auto& inst = scr->m_scripts[idx];
-				char tmp[MAX_PATH_LENGTH];
-				blob.readString(tmp, lengthOf(tmp));
-				setScriptPath(cmp, idx, Path(tmp));
-				
-				int prop_count;
-				blob.read(prop_count);
-				for (int j = 0; j < prop_count; ++j)
+				switch ((EventArgType)*arg)
 				{
-					u32 hash;
-					blob.read(hash);
-					int prop_index = scr->getProperty(inst, hash);
-					if (prop_index < 0)
+					case EventArgType::INT:
 					{
-						scr->m_scripts[idx].m_properties.emplace(m_system.m_allocator);
-						prop_index = scr->m_scripts[idx].m_properties.size() - 1;
+						int value;
+						copyMemory(&value, arg + 1, sizeof(value));
+						duk_push_int(ctx, value);
+						arg += 1 + sizeof(value);
+						break;
+					}
+					case EventArgType::FLOAT:
+					{
+						float value;
+						copyMemory(&value, arg + 1, sizeof(value));
+						duk_push_number(ctx, value);
+						arg += 1 + sizeof(value);
+						break;
+					}
+					case EventArgType::POINTER:
+					{
+						void* value;
+						copyMemory(&value, arg + 1, sizeof(value));
+						duk_push_pointer(ctx, value);
+						arg += 1 + sizeof(value);
+						break;
 					}
-					auto& prop = scr->m_scripts[idx].m_properties[prop_index];
-					prop.name_hash = hash;
-					blob.read(prop.type);
-					char tmp[1024];
-					blob.readString(tmp, lengthOf(tmp));
-					prop.stored_value = tmp;
-					if (scr->m_scripts[idx].m_state) applyProperty(scr->m_scripts[idx], prop, tmp);
 				}
 			}
-			*/
+			callHandler(event.arg_count);
 		}
 
 
-		void clear() override
+		// dormant instances of the targeted entities are started, so they can subscribe or
+		// receive, broadcasts reach only the running instances. Events and messages the
+		// constructors post are handled in the next frame
+		template <typename T> void activateTargets(const Array<T>& items, int count)
 		{
-			Path invalid_path;
-			for (auto* script_cmp : m_scripts)
+			for (int i = 0; i < count; ++i)
 			{
-				if (!script_cmp) continue;
-
-				for (auto& script : script_cmp->m_scripts)
+				Entity entity = items[i].entity;
+				for (int j = 0;; ++j)
 				{
-					setScriptPath(*script_cmp, script, invalid_path);
+					// the constructors can add scripts and move the instances
+					ScriptComponent* script_cmp = findScriptComponent(entity);
+					if (!script_cmp || j >= script_cmp->m_instance_count) break;
+					ScriptInstance& inst = getInstance(*script_cmp, j);
+					if (inst.m_is_dormant) activateInstance(entity, inst);
 				}
-				LUMIX_DELETE(m_system.m_allocator, script_cmp);
 			}
-			m_scripts.clear();
 		}
 
 
-		Universe& getUniverse() override { return m_universe; }
-
-
-		void getInstanceName(IScene& scene, char* out_str, int size)
+		// every subscriber gets all its events of the frame in one batch, events posted
+		// by the handlers are dispatched in the next frame
+		void dispatchEvents()
 		{
-			copyString(out_str, size, "g_scene_");
-			catString(out_str, size, scene.getPlugin().getName());
-		}
+			int count = m_events.size();
+			if (count == 0) return;
+			PROFILE_FUNCTION();
 
+			activateTargets(m_events, count);
 
-		void registerAPI()
-		{
+			linkByKey(m_events, count, m_event_map);
+
+			// collected first, handlers can subscribe and unsubscribe; without global events
+			// only the instances of the targeted entities are visited
+			Array<InstanceRef> subscribers(m_system.m_allocator);
+			bool has_global_event = false;
+			for (int i = 0; i < count; ++i)
+			{
+				if (m_events[i].entity.index < 0) has_global_event = true;
+			}
+			if (has_global_event)
+			{
+				subscribers.reserve(m_subscribers.size());
+				for (const InstanceRef& subscriber : m_subscribers) subscribers.push(subscriber);
+			}
+			else
+			{
+				++m_event_frame;
+				for (int i = 0; i < count; ++i)
+				{
+					Entity entity = m_events[i].entity;
+					ScriptComponent* script_cmp = findScriptComponent(entity);
+					if (!script_cmp) continue;
+					for (int j = 0; j < script_cmp->m_instance_count; ++j)
+					{
+						ScriptInstance& inst = getInstance(*script_cmp, j);
+						if (inst.m_subscriptions.empty() || inst.m_event_frame == m_event_frame) continue;
+						inst.m_event_frame = m_event_frame;
+						subscribers.push({entity, inst.m_id});
+					}
+				}
+			}
+
+			duk_context* ctx = m_system.m_global_context;
+			for (const InstanceRef& subscriber : subscribers)
+			{
+				ScriptInstance* inst = findInstance(subscriber.entity, subscriber.id);
+				if (!inst || inst->m_slot < 0) continue;
+
+				int stats_index = getStatsIndex(*inst->m_script);
+				bool is_called = false;
+				CallbackScope callback_scope = {};
+				InstanceRef prev = setRunningInstance(subscriber.entity, subscriber.id);
+				pushInstance(ctx, inst->m_slot);
+				for (int i = 0; inst && i < inst->m_subscriptions.size(); ++i)
+				{
+					Subscription sub = inst->m_subscriptions[i];
+					Entity entities[] = {subscriber.entity, INVALID_ENTITY};
+					for (Entity entity : entities)
+					{
+						auto iter = m_event_map.find(getEventKey(sub.event, entity));
+						if (iter == m_event_map.end()) continue;
+						for (int idx = iter.value(); idx >= 0; idx = m_events[idx].next)
+						{
+							Event event = m_events[idx];
+							if (event.name_hash != sub.event || event.entity.index != entity.index) continue;
+
+							if (!is_called)
+							{
+								callback_scope = beginCallback(stats_index, Callback::EVENT, subscriber.entity);
+								is_called = true;
+							}
+							callHandler(sub.handler, event);
+						}
+					}
+					// the handlers can destroy the instance
+					inst = findInstance(subscriber.entity, subscriber.id);
+				}
+				if (is_called) endCallback(stats_index, Callback::EVENT, subscriber.entity, callback_scope);
+				m_running = prev;
+				duk_pop_2(ctx);
+			}
+
+			int args_size = count < m_events.size() ? m_events[count].args_offset : m_event_args.size();
+			for (int i = count; i < m_events.size(); ++i)
+			{
+				m_events[i - count] = m_events[i];
+				m_events[i - count].args_offset -= args_size;
+			}
+			m_events.resize(m_events.size() - count);
+			for (int i = args_size; i < m_event_args.size(); ++i)
+			{
+				m_event_args[i - args_size] = m_event_args[i];
+			}
+			m_event_args.resize(m_event_args.size() - args_size);
+		}
+
+
+		// the handler at fn_idx is called by the running instance after delay seconds,
+		// then every interval seconds if it is not negative, returns the id or 0
+		int addTimer(int fn_idx, float delay, float interval)
+		{
+			ScriptInstance* inst = findInstance(m_running.entity, m_running.id);
+			if (!inst) return 0;
+
+			int handler = addHandler(fn_idx);
+			int id = m_timer_queue.add(delay, interval, handler, m_running.entity, m_running.id);
+			inst->m_timers.push(id);
+			return id;
+		}
+
+
+		bool removeTimer(int id)
+		{
+			JSTimerQueue::Timer timer;
+			if (!m_timer_queue.remove(id, &timer)) return false;
+
+			removeHandler(timer.handler);
+			ScriptInstance* inst = findInstance(timer.entity, timer.owner);
+			if (!inst) return true;
+			for (int i = 0; i < inst->m_timers.size(); ++i)
+			{
+				if (inst->m_timers[i] == id)
+				{
+					inst->m_timers.eraseFast(i);
+					break;
+				}
+			}
+			return true;
+		}
+
+
+		void removeTimers(ScriptInstance& inst)
+		{
+			for (int id : inst.m_timers)
+			{
+				JSTimerQueue::Timer timer;
+				if (m_timer_queue.remove(id, &timer)) removeHandler(timer.handler);
+			}
+			inst.m_timers.clear();
+		}
+
+
+		// the timers which expired in the frame are called in one batch
+		void fireTimers(float time_delta)
+		{
+			m_expired_timers.clear();
+			m_timer_queue.update(time_delta, m_expired_timers);
+			if (m_expired_timers.empty()) return;
+			PROFILE_FUNCTION();
+
+			duk_context* ctx = m_system.m_global_context;
+			for (int id : m_expired_timers)
+			{
+				// removed by a previous handler
+				JSTimerQueue::Timer* timer_ptr = m_timer_queue.get(id);
+				if (!timer_ptr) continue;
+				JSTimerQueue::Timer timer = *timer_ptr;
+
+				ScriptInstance* inst = findInstance(timer.entity, timer.owner);
+				if (inst && inst->m_slot >= 0)
+				{
+					int stats_index = getStatsIndex(*inst->m_script);
+					InstanceRef prev = setRunningInstance(timer.entity, timer.owner);
+					pushInstance(ctx, inst->m_slot);
+					if (pushHandler(timer.handler))
+					{
+						CallbackScope callback_scope = beginCallback(stats_index, Callback::TIMER, timer.entity);
+						callHandler(0);
+						endCallback(stats_index, Callback::TIMER, timer.entity, callback_scope);
+					}
+					duk_pop_2(ctx);
+					m_running = prev;
+				}
+				if (timer.interval < 0) removeTimer(id);
+			}
+		}
+
+
+		// the receivers are indexed only for the names which have been sent, the first
+		// message of a name indexes all running instances
+		int getReceivers(const char* name)
+		{
+			u32 name_hash = crc32(name);
+			auto iter = m_receiver_map.find(name_hash);
+			if (iter != m_receiver_map.end()) return iter.value();
+
+			MessageReceivers& receivers = m_receivers.emplace(m_system.m_allocator);
+			receivers.name = name;
+			int index = m_receivers.size() - 1;
+			m_receiver_map.insert(name_hash, index);
+
+			duk_context* ctx = m_system.m_global_context;
+			for (const ScriptComponent& script_cmp : m_components)
+			{
+				for (int i = 0; i < script_cmp.m_instance_count; ++i)
+				{
+					ScriptInstance& inst = getInstance(script_cmp, i);
+					if (inst.m_slot < 0) continue;
+
+					pushInstance(ctx, inst.m_slot);
+					duk_get_prop_string(ctx, -1, name);
+					if (duk_is_callable(ctx, -1)) addReceive(script_cmp.m_entity, inst, index);
+					duk_pop_3(ctx);
+				}
+			}
+			return index;
+		}
+
+
+		// adds the instance to the receivers of the messages it has methods for. With few names
+		// each is looked up on the instance, with many the methods are looked up in m_receiver_map
+		void indexReceiver(Entity entity, ScriptInstance& inst)
+		{
+			static const int MAX_LOOKED_UP_NAMES = 16;
+
+			unindexReceiver(inst);
+			if (inst.m_slot < 0 || m_receivers.empty()) return;
+
+			duk_context* ctx = m_system.m_global_context;
+			pushInstance(ctx, inst.m_slot);
+			if (m_receivers.size() <= MAX_LOOKED_UP_NAMES)
+			{
+				for (int i = 0; i < m_receivers.size(); ++i)
+				{
+					duk_get_prop_string(ctx, -1, m_receivers[i].name.c_str());
+					if (duk_is_callable(ctx, -1)) addReceive(entity, inst, i);
+					duk_pop(ctx);
+				}
+				duk_pop_2(ctx);
+				return;
+			}
+
+			// methods of classes are not enumerable, shadowed names are enumerated once
+			duk_enum(ctx, -1, DUK_ENUM_INCLUDE_NONENUMERABLE);
+			while (duk_next(ctx, -1, 1))
+			{
+				if (duk_is_callable(ctx, -1) && duk_is_string(ctx, -2))
+				{
+					auto iter = m_receiver_map.find(crc32(duk_get_string(ctx, -2)));
+					if (iter != m_receiver_map.end()) addReceive(entity, inst, iter.value());
+				}
+				duk_pop_2(ctx);
+			}
+			duk_pop_3(ctx);
+		}
+
+
+		void addReceive(Entity entity, ScriptInstance& inst, int receivers_index)
+		{
+			int index = m_free_receive_item;
+			if (index < 0)
+			{
+				index = m_receive_items.size();
+				m_receive_items.emplace();
+			}
+			else
+			{
+				m_free_receive_item = m_receive_items[index].next;
+			}
+			MessageReceivers& receivers = m_receivers[receivers_index];
+			ReceiveItem& item = m_receive_items[index];
+			item.name_hash = crc32(receivers.name.c_str());
+			item.receivers = receivers_index;
+			item.position = receivers.instances.size();
+			item.next = inst.m_first_receive;
+			inst.m_first_receive = index;
+			receivers.instances.push({entity, inst.m_id});
+			receivers.items.push(index);
+		}
+
+
+		void unindexReceiver(ScriptInstance& inst)
+		{
+			while (inst.m_first_receive >= 0)
+			{
+				int index = inst.m_first_receive;
+				ReceiveItem& item = m_receive_items[index];
+				inst.m_first_receive = item.next;
+				item.next = m_free_receive_item;
+				m_free_receive_item = index;
+
+				// the last instance takes the place of the removed one
+				MessageReceivers& receivers = m_receivers[item.receivers];
+				int last = receivers.instances.size() - 1;
+				receivers.instances[item.position] = receivers.instances[last];
+				receivers.items[item.position] = receivers.items[last];
+				m_receive_items[receivers.items[item.position]].position = item.position;
+				receivers.instances.pop();
+				receivers.items.pop();
+			}
+		}
+
+
+		// the payload at payload_idx is passed to the method, see deliverMessages
+		void postMessage(const char* name, Entity entity, int payload_idx)
+		{
+			getReceivers(name);
+
+			duk_context* ctx = m_system.m_global_context;
+			payload_idx = duk_normalize_index(ctx, payload_idx);
+			int index = m_messages.size();
+			Message& msg = m_messages.emplace();
+			msg.name_hash = crc32(name);
+			msg.entity = entity;
+			msg.next = -1;
+
+			duk_push_heapptr(ctx, m_mailbox);
+			duk_push_string(ctx, name);
+			duk_put_prop_index(ctx, -2, (duk_uarridx_t)index * 2);
+			duk_dup(ctx, payload_idx);
+			duk_put_prop_index(ctx, -2, (duk_uarridx_t)index * 2 + 1);
+			duk_pop(ctx);
+		}
+
+
+		void clearMessages()
+		{
+			m_messages.clear();
+			duk_context* ctx = m_system.m_global_context;
+			duk_push_heapptr(ctx, m_mailbox);
+			duk_push_int(ctx, 0);
+			duk_put_prop_string(ctx, -2, "length");
+			duk_pop(ctx);
+		}
+
+
+		// [obj] -> [obj], calls the method of the message with its payload
+		void callReceiver(int message)
+		{
+			duk_context* ctx = m_system.m_global_context;
+			duk_push_heapptr(ctx, m_mailbox);
+			duk_get_prop_index(ctx, -1, (duk_uarridx_t)message * 2);
+			duk_get_prop(ctx, -3);
+			if (!duk_is_callable(ctx, -1))
+			{
+				duk_pop_2(ctx);
+				return;
+			}
+			duk_dup(ctx, -3);
+			duk_get_prop_index(ctx, -3, (duk_uarridx_t)message * 2 + 1);
+			if (duk_pcall_method(ctx, 1) != 0)
+			{
+				const char* error = duk_safe_to_string(ctx, -1);
+				g_log_error.log("JS Script") << error;
+			}
+			duk_pop_2(ctx);
+		}
+
+
+		// like dispatchEvents, every receiver gets all its messages in one batch and
+		// messages sent by the receivers are delivered in the next frame
+		void deliverMessages()
+		{
+			int count = m_messages.size();
+			if (count == 0) return;
+			PROFILE_FUNCTION();
+
+			activateTargets(m_messages, count);
+
+			linkByKey(m_messages, count, m_message_map);
+
+			// broadcasts reach the indexed receivers of the name, sendMessage the instances
+			// of the entity; each receiver is visited once
+			Array<InstanceRef> receivers(m_system.m_allocator);
+			++m_event_frame;
+			for (int i = 0; i < count; ++i)
+			{
+				const Message& msg = m_messages[i];
+				if (msg.entity.index < 0)
+				{
+					const MessageReceivers& indexed = m_receivers[m_receiver_map.find(msg.name_hash).value()];
+					for (const InstanceRef& ref : indexed.instances)
+					{
+						ScriptInstance* inst = findInstance(ref.entity, ref.id);
+						if (!inst || inst->m_event_frame == m_event_frame) continue;
+						inst->m_event_frame = m_event_frame;
+						receivers.push(ref);
+					}
+					continue;
+				}
+
+				ScriptComponent* script_cmp = findScriptComponent(msg.entity);
+				if (!script_cmp) continue;
+				for (int j = 0; j < script_cmp->m_instance_count; ++j)
+				{
+					ScriptInstance& inst = getInstance(*script_cmp, j);
+					if (inst.m_first_receive < 0 || inst.m_event_frame == m_event_frame) continue;
+					inst.m_event_frame = m_event_frame;
+					receivers.push({msg.entity, inst.m_id});
+				}
+			}
+
+			duk_context* ctx = m_system.m_global_context;
+			for (const InstanceRef& receiver : receivers)
+			{
+				ScriptInstance* inst = findInstance(receiver.entity, receiver.id);
+				if (!inst || inst->m_slot < 0) continue;
+
+				int stats_index = getStatsIndex(*inst->m_script);
+				bool is_called = false;
+				CallbackScope callback_scope = {};
+				InstanceRef prev = setRunningInstance(receiver.entity, receiver.id);
+				pushInstance(ctx, inst->m_slot);
+				for (int r = inst->m_first_receive; inst && r >= 0;)
+				{
+					u32 name_hash = m_receive_items[r].name_hash;
+					r = m_receive_items[r].next;
+					Entity entities[] = {receiver.entity, INVALID_ENTITY};
+					for (Entity entity : entities)
+					{
+						auto iter = m_message_map.find(getEventKey(name_hash, entity));
+						if (iter == m_message_map.end()) continue;
+						for (int idx = iter.value(); idx >= 0; idx = m_messages[idx].next)
+						{
+							const Message& msg = m_messages[idx];
+							if (msg.name_hash != name_hash || msg.entity.index != entity.index) continue;
+
+							if (!is_called)
+							{
+								callback_scope = beginCallback(stats_index, Callback::MESSAGE, receiver.entity);
+								is_called = true;
+							}
+							callReceiver(idx);
+						}
+					}
+					// the receivers can destroy the instance
+					inst = findInstance(receiver.entity, receiver.id);
+				}
+				if (is_called) endCallback(stats_index, Callback::MESSAGE, receiver.entity, callback_scope);
+				m_running = prev;
+				duk_pop_2(ctx);
+			}
+
+			int remaining = m_messages.size() - count;
+			duk_push_heapptr(ctx, m_mailbox);
+			for (int i = 0; i < remaining; ++i)
+			{
+				m_messages[i] = m_messages[count + i];
+				for (int j = 0; j < 2; ++j)
+				{
+					duk_get_prop_index(ctx, -1, (duk_uarridx_t)(count + i) * 2 + j);
+					duk_put_prop_index(ctx, -2, (duk_uarridx_t)i * 2 + j);
+				}
+			}
+			duk_push_int(ctx, remaining * 2);
+			duk_put_prop_string(ctx, -2, "length");
+			duk_pop(ctx);
+			m_messages.resize(remaining);
+		}
+
+
+		// [] -> [pool], the destroyed instances of the script which can be reused
+		void pushPool(duk_context* ctx, JSScript& script)
+		{
+			const char* path = script.getPath().c_str();
+			duk_push_heapptr(ctx, m_pool_table);
+			if (!duk_get_prop_string(ctx, -1, path))
+			{
+				duk_pop(ctx);
+				duk_push_array(ctx);
+				duk_dup_top(ctx);
+				duk_put_prop_string(ctx, -3, path);
+			}
+			duk_remove(ctx, -2);
+
+			// instances of the previous version are not reused
+			duk_get_prop_string(ctx, -1, "\xff" "hash");
+			bool is_current = duk_get_uint(ctx, -1) == script.getSourceHash();
+			duk_pop(ctx);
+			if (is_current) return;
+
+			duk_push_uint(ctx, 0);
+			duk_put_prop_string(ctx, -2, "length");
+			duk_push_uint(ctx, script.getSourceHash());
+			duk_put_prop_string(ctx, -2, "\xff" "hash");
+		}
+
+
+		// instances of scripts with onReuse are kept when they are destroyed during the game,
+		// the next startScript of the script calls onReuse(entity) instead of evaluating it
+		void poolInstance(ScriptInstance& inst)
+		{
+			if (!m_is_game_running || inst.m_slot < 0 || !inst.m_script) return;
+
+			duk_context* ctx = m_system.m_global_context;
+			pushInstance(ctx, inst.m_slot); // [table, obj]
+			duk_get_prop_string(ctx, -1, "onReuse");
+			bool is_reusable = duk_is_callable(ctx, -1) != 0;
+			duk_pop(ctx);
+			if (is_reusable)
+			{
+				pushPool(ctx, *inst.m_script);
+				duk_size_t size = duk_get_length(ctx, -1);
+				if (size < MAX_POOLED_INSTANCES)
+				{
+					duk_dup(ctx, -2);
+					duk_put_prop_index(ctx, -2, (duk_uarridx_t)size);
+				}
+				duk_pop(ctx);
+			}
+			duk_pop_2(ctx);
+		}
+
+
+		// [] -> [obj] if a destroyed instance of the script can be reused
+		bool pushPooledInstance(JSScript& script)
+		{
+			duk_context* ctx = m_system.m_global_context;
+			pushPool(ctx, script);
+			duk_size_t size = duk_get_length(ctx, -1);
+			if (size == 0)
+			{
+				duk_pop(ctx);
+				return false;
+			}
+			duk_get_prop_index(ctx, -1, (duk_uarridx_t)size - 1);
+			duk_push_uint(ctx, (duk_uint_t)size - 1);
+			duk_put_prop_string(ctx, -3, "length");
+			duk_remove(ctx, -2);
+			return true;
+		}
+
+
+		// [] -> [table, obj], obj is undefined if the instance is not running
+		void pushInstance(duk_context* ctx, int slot)
+		{
+			duk_push_heapptr(ctx, m_instance_table);
+			if (slot < 0)
+				duk_push_undefined(ctx);
+			else
+				duk_get_prop_index(ctx, -1, (duk_uarridx_t)slot);
+		}
+
+
+		int allocateSlot()
+		{
+			if (!m_free_slots.empty())
+			{
+				int slot = m_free_slots.back();
+				m_free_slots.pop();
+				return slot;
+			}
+			return m_slot_count++;
+		}
+
+
+		void freeSlot(ScriptInstance& inst)
+		{
+			if (inst.m_slot < 0) return;
+
+			duk_context* ctx = m_system.m_global_context;
+			duk_push_heapptr(ctx, m_instance_table);
+			duk_push_undefined(ctx);
+			duk_put_prop_index(ctx, -2, (duk_uarridx_t)inst.m_slot);
+			duk_pop(ctx);
+			m_free_slots.push(inst.m_slot);
+			inst.m_slot = -1;
+		}
+
+
+		int getVersion() const override { return (int)JSSceneVersion::LATEST; }
+
+
+		ComponentHandle getComponent(Entity entity) override
+		{
+			if (!findScriptComponent(entity)) return INVALID_COMPONENT;
+			return {entity.index};
+		}
+
+
+		ScriptComponent* findScriptComponent(Entity entity)
+		{
+			if (entity.index < 0 || entity.index >= m_component_map.size()) return nullptr;
+			int idx = m_component_map[entity.index];
+			return idx < 0 ? nullptr : &m_components[idx];
+		}
+
+
+		ScriptComponent& getScriptComponent(ComponentHandle cmp)
+		{
+			return m_components[m_component_map[cmp.index]];
+		}
+
+
+		ScriptInstance& getInstance(const ScriptComponent& script_cmp, int scr_index)
+		{
+			ASSERT(scr_index >= 0 && scr_index < script_cmp.m_instance_count);
+			return m_instances[script_cmp.m_first_instance + scr_index];
+		}
+
+
+		ScriptInstance& getInstance(ComponentHandle cmp, int scr_index)
+		{
+			return getInstance(getScriptComponent(cmp), scr_index);
+		}
+
+
+		const ScriptInstance& getInstance(ComponentHandle cmp, int scr_index) const
+		{
+			const ScriptComponent& script_cmp = m_components[m_component_map[cmp.index]];
+			ASSERT(scr_index >= 0 && scr_index < script_cmp.m_instance_count);
+			return m_instances[script_cmp.m_first_instance + scr_index];
+		}
+
+
+		static void resetInstance(ScriptInstance& inst)
+		{
+			inst.m_script = nullptr;
+			inst.m_id = 0;
+			inst.m_slot = -1;
+			inst.m_is_dormant = false;
+			inst.m_properties.clear();
+			inst.m_snapshot.clear();
+			inst.m_subscriptions.clear();
+			inst.m_timers.clear();
+			inst.m_first_receive = -1;
+		}
+
+
+		static void moveInstance(ScriptInstance& dst, ScriptInstance& src)
+		{
+			dst.m_script = src.m_script;
+			dst.m_id = src.m_id;
+			dst.m_slot = src.m_slot;
+			dst.m_is_dormant = src.m_is_dormant;
+			dst.m_properties.swap(src.m_properties);
+			dst.m_snapshot.swap(src.m_snapshot);
+			dst.m_subscriptions.swap(src.m_subscriptions);
+			dst.m_timers.swap(src.m_timers);
+			dst.m_first_receive = src.m_first_receive;
+			resetInstance(src);
+		}
+
+
+		static void swapInstances(ScriptInstance& a, ScriptInstance& b)
+		{
+			JSScript* script = a.m_script;
+			uintptr id = a.m_id;
+			int slot = a.m_slot;
+			bool is_dormant = a.m_is_dormant;
+			int first_receive = a.m_first_receive;
+			a.m_script = b.m_script;
+			a.m_id = b.m_id;
+			a.m_slot = b.m_slot;
+			a.m_is_dormant = b.m_is_dormant;
+			a.m_first_receive = b.m_first_receive;
+			b.m_script = script;
+			b.m_id = id;
+			b.m_slot = slot;
+			b.m_is_dormant = is_dormant;
+			b.m_first_receive = first_receive;
+			a.m_properties.swap(b.m_properties);
+			a.m_snapshot.swap(b.m_snapshot);
+			a.m_subscriptions.swap(b.m_subscriptions);
+			a.m_timers.swap(b.m_timers);
+		}
+
+
+		// the smallest free block which is large enough, the rest of it stays free
+		int allocateBlock(int capacity)
+		{
+			if (capacity == 0) return m_instances.size();
+
+			int best = -1;
+			for (int i = 0, c = m_free_blocks.size(); i < c; ++i)
+			{
+				int free_capacity = m_free_blocks[i].capacity;
+				if (free_capacity < capacity) continue;
+				if (best < 0 || free_capacity < m_free_blocks[best].capacity) best = i;
+			}
+			if (best >= 0)
+			{
+				InstanceBlock& block = m_free_blocks[best];
+				int first = block.first;
+				block.first += capacity;
+				block.capacity -= capacity;
+				if (block.capacity == 0) m_free_blocks.eraseFast(best);
+				return first;
+			}
+
+			// emplace grows the array geometrically, an exact reserve here would copy all
+			// the instances for every new block
+			int first = m_instances.size();
+			for (int i = 0; i < capacity; ++i)
+			{
+				m_instances.emplace(m_system.m_allocator);
+			}
+			return first;
+		}
+
+
+		void freeBlock(int first, int capacity)
+		{
+			if (capacity == 0) return;
+			for (int i = first; i < first + capacity; ++i)
+			{
+				resetInstance(m_instances[i]);
+			}
+
+			// merged with the adjacent free blocks, so they can hold larger components
+			for (int i = m_free_blocks.size() - 1; i >= 0; --i)
+			{
+				InstanceBlock& block = m_free_blocks[i];
+				if (block.first + block.capacity == first)
+				{
+					first = block.first;
+					capacity += block.capacity;
+					m_free_blocks.eraseFast(i);
+				}
+				else if (first + capacity == block.first)
+				{
+					capacity += block.capacity;
+					m_free_blocks.eraseFast(i);
+				}
+			}
+			m_free_blocks.push({first, capacity});
+		}
+
+
+		// the returned reference is valid until another instance is added
+		ScriptInstance& emplaceInstance(ComponentHandle cmp, int idx)
+		{
+			ScriptComponent* script_cmp = &getScriptComponent(cmp);
+			ASSERT(idx >= 0 && idx <= script_cmp->m_instance_count);
+			if (script_cmp->m_instance_count == script_cmp->m_capacity)
+			{
+				int new_capacity = Math::maximum(1, script_cmp->m_capacity * 2);
+				int new_first = allocateBlock(new_capacity);
+				for (int i = 0; i < script_cmp->m_instance_count; ++i)
+				{
+					moveInstance(m_instances[new_first + i], m_instances[script_cmp->m_first_instance + i]);
+				}
+				freeBlock(script_cmp->m_first_instance, script_cmp->m_capacity);
+				script_cmp->m_first_instance = new_first;
+				script_cmp->m_capacity = new_capacity;
+			}
+
+			int first = script_cmp->m_first_instance;
+			for (int i = script_cmp->m_instance_count; i > idx; --i)
+			{
+				moveInstance(m_instances[first + i], m_instances[first + i - 1]);
+			}
+			++script_cmp->m_instance_count;
+			ScriptInstance& inst = m_instances[first + idx];
+			inst.m_id = ++m_id_generator;
+			return inst;
+		}
+
+
+		void eraseInstance(ScriptComponent& script_cmp, int idx)
+		{
+			int first = script_cmp.m_first_instance;
+			resetInstance(m_instances[first + idx]);
+			for (int i = idx + 1; i < script_cmp.m_instance_count; ++i)
+			{
+				moveInstance(m_instances[first + i - 1], m_instances[first + i]);
+			}
+			--script_cmp.m_instance_count;
+		}
+
+
+		ComponentHandle addScriptComponent(Entity entity, int capacity)
+		{
+			while (m_component_map.size() <= entity.index) m_component_map.push(-1);
+			ASSERT(m_component_map[entity.index] < 0);
+
+			int first = allocateBlock(capacity);
+			m_component_map[entity.index] = m_components.size();
+			ScriptComponent& script_cmp = m_components.emplace();
+			script_cmp.m_entity = entity;
+			script_cmp.m_first_instance = first;
+			script_cmp.m_instance_count = 0;
+			script_cmp.m_capacity = capacity;
+			return {entity.index};
+		}
+
+
+		void removeScriptComponent(Entity entity)
+		{
+			int idx = m_component_map[entity.index];
+			ScriptComponent& script_cmp = m_components[idx];
+			freeBlock(script_cmp.m_first_instance, script_cmp.m_capacity);
+
+			m_component_map[entity.index] = -1;
+			int last = m_components.size() - 1;
+			if (idx != last)
+			{
+				m_components[idx] = m_components[last];
+				m_component_map[m_components[idx].m_entity.index] = idx;
+			}
+			m_components.pop();
+		}
+
+
+		static Callback getCallback(const char* function)
+		{
+			if (equalStrings(function, "update")) return Callback::UPDATE;
+			if (equalStrings(function, "onStartGame")) return Callback::START_GAME;
+			if (equalStrings(function, "onDestroy")) return Callback::DESTROY;
+			if (equalStrings(function, "onGUI")) return Callback::GUI;
+			if (equalStrings(function, "onDrawGizmo")) return Callback::DRAW_GIZMO;
+			if (equalStrings(function, "onReuse")) return Callback::REUSE;
+			return Callback::OTHER;
+		}
+
+
+		int getStatsIndex(const JSScript& script)
+		{
+			auto iter = m_script_resources.find(script.getPath().getHash());
+			return iter == m_script_resources.end() ? -1 : iter.value().stats_index;
+		}
+
+
+		int findStats(const Path& path)
+		{
+			for (int i = 0, c = m_script_stats.size(); i < c; ++i)
+			{
+				if (m_script_stats[i].path == path) return i;
+			}
+			ScriptStats& stats = m_script_stats.emplace();
+			stats.path = path;
+			setMemory(stats.callbacks, 0, sizeof(stats.callbacks));
+			return m_script_stats.size() - 1;
+		}
+
+
+		static const char* getCallbackName(Callback callback)
+		{
+			switch (callback)
+			{
+				case Callback::UPDATE: return "update";
+				case Callback::START_GAME: return "onStartGame";
+				case Callback::DESTROY: return "onDestroy";
+				case Callback::GUI: return "onGUI";
+				case Callback::DRAW_GIZMO: return "onDrawGizmo";
+				case Callback::REUSE: return "onReuse";
+				case Callback::EVENT: return "events";
+				case Callback::TIMER: return "timers";
+				case Callback::MESSAGE: return "messages";
+				default: return "other";
+			}
+		}
+
+
+		// callbacks nest, e.g. an event handler which creates a script, the scope restores
+		// the site and the script of the outer one. The profiler block is named by the script
+		// and tagged with the entity
+		CallbackScope beginCallback(int stats_index, Callback callback, Entity entity)
+		{
+			JSAllocTracker& alloc_tracker = m_system.m_allocator;
+			CallbackScope scope;
+			scope.prev_script = alloc_tracker.getSiteScript();
+			scope.prev_site = alloc_tracker.getSiteName();
+			scope.prev_is_binding = alloc_tracker.isBindingSite();
+			alloc_tracker.setSite(stats_index, getCallbackName(callback), false);
+			// the stats entry owns the path, so the name outlives the resource
+			const char* path = stats_index < 0 ? "JS Script" : m_script_stats[stats_index].path.c_str();
+			Profiler::beginBlock(path);
+			Profiler::pushInt("entity", entity.index);
+			m_system.m_script_path_stack.push(stats_index < 0 ? Path() : m_script_stats[stats_index].path);
+			m_system.m_tracer.begin("script", getCallbackName(callback), path);
+			scope.prev_binding_state = m_system.m_binding_stats.beginScript(stats_index);
+			m_system.m_gc_scheduler.beginCallback();
+			scope.start_time = m_timer->getRawTimeSinceStart();
+			return scope;
+		}
+
+
+		void endCallback(int stats_index, Callback callback, Entity entity, const CallbackScope& scope)
+		{
+			u64 time = m_timer->getRawTimeSinceStart() - scope.start_time;
+			Profiler::endBlock();
+			m_system.m_script_path_stack.pop();
+			m_system.m_tracer.end();
+			m_system.m_binding_stats.endScript(scope.prev_binding_state);
+			m_system.m_gc_scheduler.endCallback();
+			m_system.m_allocator.setSite(scope.prev_script, scope.prev_site, scope.prev_is_binding);
+			if (stats_index < 0) return;
+
+			CallbackStats& stats = m_script_stats[stats_index].callbacks[(int)callback];
+			++stats.call_count;
+			stats.total_time += time;
+			if (time >= stats.max_time)
+			{
+				stats.max_time = time;
+				stats.max_entity = entity;
+			}
+		}
+
+
+		int getProfiledScriptCount() override { return m_script_stats.size(); }
+		const Path& getProfiledScriptPath(int idx) override { return m_script_stats[idx].path; }
+		u64 getProfilerFrequency() override { return m_timer->getFrequency(); }
+
+
+		const CallbackStats& getCallbackStats(int idx, Callback callback) override
+		{
+			return m_script_stats[idx].callbacks[(int)callback];
+		}
+
+
+		void resetCallbackStats() override
+		{
+			for (ScriptStats& stats : m_script_stats)
+			{
+				setMemory(stats.callbacks, 0, sizeof(stats.callbacks));
+			}
+		}
+
+
+		IFunctionCall* beginFunctionCall(ComponentHandle cmp, int scr_index, const char* function) override
+		{
+			ASSERT(!m_function_call.is_in_progress);
+
+			auto& script = getInstance(cmp, scr_index);
+			// the first call starts a dormant instance, unless there is nothing to start for
+			Callback callback = getCallback(function);
+			if (callback != Callback::DESTROY && callback != Callback::START_GAME)
+			{
+				activateInstance({cmp.index}, script);
+			}
+
+			duk_context* ctx = m_system.m_global_context;
+
+			pushInstance(ctx, script.m_slot);
+			if (duk_is_undefined(ctx, -1))
+			{
+				duk_pop_2(ctx);
+				return nullptr;
+			}
+			duk_get_prop_string(ctx, -1, function);
+			if (!duk_is_callable(ctx, -1))
+			{
+				duk_pop_3(ctx);
+				return nullptr;
+			}
+			duk_dup(ctx, -2); // [this, func] -> [this, func, this]
+
+			m_function_call.context = ctx;
+			m_function_call.is_in_progress = true;
+			m_function_call.parameter_count = 0;
+			m_function_call.stats_index = getStatsIndex(*script.m_script);
+			m_function_call.callback = callback;
+			m_function_call.entity = {cmp.index};
+			m_function_call.prev_running = setRunningInstance({cmp.index}, script.m_id);
+			m_function_call.callback_scope = beginCallback(m_function_call.stats_index, m_function_call.callback, m_function_call.entity);
+
+			return &m_function_call;
+		}
+
+
+		void endFunctionCall() override
+		{
+			ASSERT(m_function_call.is_in_progress);
+
+			m_function_call.is_in_progress = false;
+
+			if (duk_pcall_method(m_function_call.context, m_function_call.parameter_count) == DUK_EXEC_ERROR)
+			{
+				const char* error = duk_safe_to_string(m_function_call.context, -1);
+				g_log_error.log("JS Script") << error;
+			}
+			endCallback(m_function_call.stats_index,
+				m_function_call.callback,
+				m_function_call.entity,
+				m_function_call.callback_scope);
+			m_running = m_function_call.prev_running;
+			duk_pop_2(m_function_call.context);
+		}
+
+
+		int getPropertyCount(ComponentHandle cmp, int scr_index) override
+		{
+			return getInstance(cmp, scr_index).m_properties.size();
+		}
+
+
+		const char* getPropertyName(ComponentHandle cmp, int scr_index, int prop_index) override
+		{
+			return getPropertyName(getInstance(cmp, scr_index).m_properties[prop_index].name_hash);
+		}
+
+
+		ResourceType getPropertyResourceType(ComponentHandle cmp, int scr_index, int prop_index) override
+		{
+			return getInstance(cmp, scr_index).m_properties[prop_index].resource_type;
+		}
+
+
+		Property::Type getPropertyType(ComponentHandle cmp, int scr_index, int prop_index) override
+		{
+			return getInstance(cmp, scr_index).m_properties[prop_index].type;
+		}
+
+
+		void getScriptData(ComponentHandle cmp, OutputBlob& blob) override
+		{
+			auto& scr = getScriptComponent(cmp);
+			blob.write(scr.m_instance_count);
+			for (int i = 0; i < scr.m_instance_count; ++i)
+			{
+				auto& inst = getInstance(scr, i);
+				blob.writeString(inst.m_script ? inst.m_script->getPath().c_str() : "");
+				blob.write(inst.m_properties.size());
+				for (auto& prop : inst.m_properties)
+				{
+					blob.write(prop.name_hash);
+					blob.write(prop.type);
+					char tmp[1024];
+					tmp[0] = '\0';
+					const char* prop_name = getPropertyName(prop.name_hash);
+					if(prop_name) getPropertyValue(cmp, i, getPropertyName(prop.name_hash), tmp, lengthOf(tmp));
+					blob.writeString(prop_name ? tmp : prop.stored_value.c_str());
+				}
+			}
+		}
+
+
+		duk_context* getGlobalContext() override
+		{
+			return m_system.m_global_context;
+		}
+
+
+		bool setBundleEnabled(bool enable) override
+		{
+			if (enable) return m_system.mountBundle();
+			m_system.unmountBundle();
+			return true;
+		}
+
+
+		bool isBundleEnabled() override
+		{
+			return m_system.m_is_bundle_mounted;
+		}
+
+
+		JSProfiler& getProfiler() override
+		{
+			return m_system.m_profiler;
+		}
+
+
+		const JSHeapMonitor& getHeapMonitor() override
+		{
+			return m_system.m_heap_monitor;
+		}
+
+
+		JSAllocTracker& getAllocTracker() override
+		{
+			return m_system.m_allocator;
+		}
+
+
+		JSBindingStats& getBindingStats() override
+		{
+			return m_system.m_binding_stats;
+		}
+
+
+		JSGCScheduler& getGCScheduler() override
+		{
+			return m_system.m_gc_scheduler;
+		}
+
+
+		void setScriptData(ComponentHandle cmp, InputBlob& blob) override
+		{
+			ASSERT(false); // TODO
+			/*
+			auto* scr = m_scripts[{cmp.index}];
+			int count;
+			blob.read(count);
+			for (int i = 0; i < count; ++i)
+			{
+				int idx = addScript(cmp);
+				auto& inst = scr->m_scripts[idx];
+				char tmp[MAX_PATH_LENGTH];
+				blob.readString(tmp, lengthOf(tmp));
+				setScriptPath(cmp, idx, Path(tmp));
+				
+				int prop_count;
+				blob.read(prop_count);
+				for (int j = 0; j < prop_count; ++j)
+				{
+					u32 hash;
+					blob.read(hash);
+					int prop_index = scr->getProperty(inst, hash);
+					if (prop_index < 0)
+					{
+						scr->m_scripts[idx].m_properties.emplace(m_system.m_allocator);
+						prop_index = scr->m_scripts[idx].m_properties.size() - 1;
+					}
+					auto& prop = scr->m_scripts[idx].m_properties[prop_index];
+					prop.name_hash = hash;
+					blob.read(prop.type);
+					char tmp[1024];
+					blob.readString(tmp, lengthOf(tmp));
+					prop.stored_value = tmp;
+					if (scr->m_scripts[idx].m_state) applyProperty(scr->m_scripts[idx], prop, tmp);
+				}
+			}
+			*/
+		}
+
+
+		void clear() override
+		{
+			Path invalid_path;
+			for (int i = 0; i < m_components.size(); ++i)
+			{
+				for (int j = 0; j < m_components[i].m_instance_count; ++j)
+				{
+					setScriptPath(m_components[i].m_entity, j, invalid_path);
+				}
+			}
+			m_component_map.clear();
+			m_components.clear();
+			m_instances.clear();
+			m_free_blocks.clear();
+			m_pending_starts.clear();
+			m_pending_start_index.clear();
+		}
+
+
+		Universe& getUniverse() override { return m_universe; }
+
+
+		void getInstanceName(IScene& scene, char* out_str, int size)
+		{
+			copyString(out_str, size, "g_scene_");
+			catString(out_str, size, scene.getPlugin().getName());
+		}
+
+
+		void registerAPI()
+		{
 			if (m_is_api_registered) return;
 			m_is_api_registered = true;
 
@@ -691,133 +2193,551 @@ namespace Lumix
 		}
 
 
-		void applyProperty(duk_context* ctx, ScriptInstance& script, Property& prop, const char* value)
+		void applyProperty(duk_context* ctx, ScriptInstance& script, Property& prop, const char* value)
+		{
+			// nothing stored, e.g. a restarted instance keeps the value of the script
+			if (!value || value[0] == '\0') return;
+			const char* name = getPropertyName(prop.name_hash);
+			if (!name) return;
+
+			pushInstance(ctx, script.m_slot);
+			if (!duk_is_object(ctx, -1))
+			{
+				// not started yet, value is applied in startScript
+				if (value != prop.stored_value.c_str()) prop.stored_value = value;
+				duk_pop_2(ctx);
+				return;
+			}
+
+			if (duk_peval_string(ctx, value) != 0)
+			{
+				const char* error = duk_safe_to_string(ctx, -1);
+				g_log_error.log("JS Script") << error;
+				duk_pop_3(ctx);
+				return;
+			}
+			duk_put_prop_string(ctx, -2, name);
+			duk_pop_2(ctx);
+		}
+
+
+		void setPropertyValue(ComponentHandle cmp,
+			int scr_index,
+			const char* name,
+			const char* value) override
+		{
+			ScriptInstance& inst = getInstance(cmp, scr_index);
+			Property& prop = getScriptProperty(cmp, scr_index, name);
+			if (!inst.m_script->isReady())
+			{
+				prop.stored_value = value;
+				return;
+			}
+
+			applyProperty(m_system.m_global_context, inst, prop, value);
+		}
+
+		const char* getPropertyName(ComponentHandle cmp, int scr_index, int index) const
+		{
+			auto& script = getInstance(cmp, scr_index);
+
+			return getPropertyName(script.m_properties[index].name_hash);
+		}
+
+
+		int getPropertyCount(ComponentHandle cmp, int scr_index) const
+		{
+			auto& script = getInstance(cmp, scr_index);
+
+			return script.m_properties.size();
+		}
+
+
+		static void* JSAllocator(void* ud, void* ptr, size_t osize, size_t nsize)
+		{
+			auto& allocator = *static_cast<IAllocator*>(ud);
+			if (nsize == 0)
+			{
+				allocator.deallocate(ptr);
+				return nullptr;
+			}
+			if (nsize > 0 && ptr == nullptr) return allocator.allocate(nsize);
+
+			void* new_mem = allocator.allocate(nsize);
+			copyMemory(new_mem, ptr, Math::minimum(osize, nsize));
+			allocator.deallocate(ptr);
+			return new_mem;
+		}
+
+
+		// returns the instance, onDestroy can add scripts and move the instances
+		ScriptInstance& clearInstance(Entity entity, int scr_idx)
+		{
+			auto* call = beginFunctionCall({entity.index}, scr_idx, "onDestroy");
+			if (call) endFunctionCall();
+
+			ScriptInstance& inst = getInstance(*findScriptComponent(entity), scr_idx);
+			removeUpdate(inst.m_id);
+			cancelPendingStart(inst.m_id);
+			unsubscribe(inst, 0);
+			removeTimers(inst);
+			unindexReceiver(inst);
+
+			poolInstance(inst);
+			freeSlot(inst);
+			inst.m_is_dormant = false;
+
+			inst.m_properties.clear();
+			return inst;
+		}
+
+
+		void removeUpdate(uintptr id)
+		{
+			for (int i = 0; i < m_updates.size(); ++i)
+			{
+				if (m_updates[i].id == id)
+				{
+					m_updates.eraseFast(i);
+					break;
+				}
+			}
+		}
+
+
+		JSScript* acquireScript(const Path& path)
+		{
+			if (!path.isValid()) return nullptr;
+
+			auto iter = m_script_resources.find(path.getHash());
+			if (iter != m_script_resources.end())
+			{
+				++iter.value().ref_count;
+				return iter.value().script;
+			}
+
+			auto* script = static_cast<JSScript*>(m_system.getScriptManager().load(path));
+			script->getObserverCb().bind<JSScriptSceneImpl, &JSScriptSceneImpl::onScriptLoaded>(this);
+			m_script_resources.insert(path.getHash(), {script, 1, false, findStats(path)});
+			script->setUsedAsScript();
+			return script;
+		}
+
+
+		void releaseScript(JSScript& script)
+		{
+			u32 path_hash = script.getPath().getHash();
+			auto iter = m_script_resources.find(path_hash);
+			ASSERT(iter != m_script_resources.end());
+			ScriptResource& res = iter.value();
+			--res.ref_count;
+			if (res.ref_count > 0) return;
+
+			m_script_resources.erase(path_hash);
+			m_pending_reloads.eraseItem(&script);
+			script.getObserverCb().unbind<JSScriptSceneImpl, &JSScriptSceneImpl::onScriptLoaded>(this);
+			m_system.getScriptManager().unload(script);
+		}
+
+
+		void onScriptLoaded(Resource::State, Resource::State new_state, Resource& resource)
+		{
+			// the next batch drops the pending starts of a failed script
+			if (new_state == Resource::State::FAILURE) m_has_ready_pending = true;
+			if (new_state != Resource::State::READY) return;
+
+			m_has_ready_pending = true;
+			auto iter = m_script_resources.find(resource.getPath().getHash());
+			if (iter == m_script_resources.end() || !iter.value().is_started) return;
+
+			// reloaded, swapped into the running instances in the next batch
+			JSScript* script = static_cast<JSScript*>(&resource);
+			if (m_pending_reloads.indexOf(script) < 0) m_pending_reloads.push(script);
+		}
+
+
+		void restartInstance(Entity entity, ScriptInstance& inst)
+		{
+			removeUpdate(inst.m_id);
+			pushPendingStart(entity, inst.m_id);
+		}
+
+
+		// like restartInstance for every instance of the script, with a single pass over the updates
+		void restartInstances(JSScript& script)
+		{
+			for (int i = m_updates.size() - 1; i >= 0; --i)
+			{
+				ScriptInstance* inst = findInstance(m_updates[i].entity, m_updates[i].id);
+				if (inst && inst->m_script == &script) m_updates.eraseFast(i);
+			}
+			for (const ScriptComponent& script_cmp : m_components)
+			{
+				for (int i = 0; i < script_cmp.m_instance_count; ++i)
+				{
+					ScriptInstance& inst = getInstance(script_cmp, i);
+					if (inst.m_script == &script) pushPendingStart(script_cmp.m_entity, inst.m_id);
+				}
+			}
+		}
+
+
+		// evaluates the new source once and moves its functions to the running instances,
+		// they keep their data and onStartGame is not called again. Instances of a class get
+		// the new prototype, instances which change between a class and an object are restarted.
+		// The moved functions are not evaluated per instance, see JSHotReload::apply
+		void reloadScript(JSScript& script)
+		{
+			PROFILE_FUNCTION();
+			duk_context* ctx = m_system.m_global_context;
+			// the evaluated object is not bound to any entity
+			duk_push_undefined(ctx);
+			duk_put_global_string(ctx, "_entity");
+
+			JSTracer& tracer = m_system.m_tracer;
+			tracer.begin("compile", "reload", script.getPath().c_str());
+			m_system.m_script_path_stack.push(script.getPath());
+			bool is_compiled = pushScriptFunction(script);
+			bool is_error = !is_compiled || duk_pcall(ctx, 0) != 0;
+			m_system.m_script_path_stack.pop();
+			tracer.end();
+			if (!is_compiled)
+			{
+				// running instances keep the old functions
+				g_log_error.log("JS Script") << duk_safe_to_string(ctx, -1);
+				duk_pop(ctx);
+				return;
+			}
+			if (is_error)
+			{
+				// the script needs its entity, e.g. phase : _entity.c_entity * 0.1, every
+				// instance evaluates it again and reports its own errors
+				duk_pop(ctx);
+				restartInstances(script);
+				return;
+			}
+
+			bool is_object = duk_is_object(ctx, -1);
+			bool is_class = duk_is_function(ctx, -1) != 0;
+			const char* path = script.getPath().c_str();
+			pushClasses(ctx);
+			// prototype of the instances of the previous version
+			if (duk_get_prop_string(ctx, -1, path)) duk_get_prop_string(ctx, -1, "prototype");
+			else duk_push_undefined(ctx);
+			duk_remove(ctx, -2);
+			// [script, classes, old_prototype]
+			if (is_class)
+			{
+				duk_dup(ctx, -3);
+				duk_push_uint(ctx, script.getSourceHash());
+				duk_put_prop_string(ctx, -2, "\xff" "hash");
+				duk_put_prop_string(ctx, -3, path);
+			}
+			else
+			{
+				duk_del_prop_string(ctx, -2, path);
+			}
+			duk_remove(ctx, -2);
+
+			int stats_index = getStatsIndex(script);
+			for (const ScriptComponent& script_cmp : m_components)
+			{
+				for (int i = 0; i < script_cmp.m_instance_count; ++i)
+				{
+					ScriptInstance& inst = getInstance(script_cmp, i);
+					if (inst.m_script != &script) continue;
+					if (inst.m_slot < 0 || !is_object)
+					{
+						restartInstance(script_cmp.m_entity, inst);
+						continue;
+					}
+
+					pushInstance(ctx, inst.m_slot); // [script, old_prototype, table, obj]
+					duk_get_prototype(ctx, -1);
+					bool was_class = duk_strict_equals(ctx, -1, -4) != 0;
+					duk_pop(ctx);
+					duk_get_prop_string(ctx, -1, "update");
+					bool had_update = duk_is_callable(ctx, -1) != 0;
+					duk_pop(ctx);
+					if (was_class && is_class)
+					{
+						duk_get_prop_string(ctx, -4, "prototype");
+						duk_set_prototype(ctx, -2);
+					}
+					else if (was_class || is_class || JSHotReload::apply(ctx, -1, -4) == JSHotReload::Result::RESTART)
+					{
+						restartInstance(script_cmp.m_entity, inst);
+						duk_pop_2(ctx);
+						continue;
+					}
+
+					duk_get_prop_string(ctx, -1, "update");
+					bool has_update = duk_is_callable(ctx, -1) != 0;
+					duk_pop_3(ctx);
+					if (had_update && !has_update) removeUpdate(inst.m_id);
+					if (!had_update && has_update)
+					{
+						UpdateData& update = m_updates.emplace();
+						update.context = ctx;
+						update.id = inst.m_id;
+						update.slot = inst.m_slot;
+						update.stats_index = stats_index;
+						update.entity = script_cmp.m_entity;
+					}
+					// the new version can have other methods
+					indexReceiver(script_cmp.m_entity, inst);
+				}
+			}
+			duk_pop_2(ctx);
+		}
+
+
+		void queueStart(Entity entity, ScriptInstance& inst)
+		{
+			if (!inst.m_script) return;
+			pushPendingStart(entity, inst.m_id);
+			if (inst.m_script->isReady()) m_has_ready_pending = true;
+		}
+
+
+		// an instance is queued at most once, the previous start is cancelled
+		void pushPendingStart(Entity entity, uintptr id)
 		{
-			if (!value) return;
-			const char* name = getPropertyName(prop.name_hash);
-			if (!name) return;
+			cancelPendingStart(id);
+			m_pending_start_index.insert(id, m_pending_starts.size());
+			m_pending_starts.push({entity, id});
+		}
 
-			duk_push_global_stash(ctx);
-			duk_push_pointer(ctx, (void*)script.m_id);
-			duk_get_prop(ctx, -2);
 
-			if (duk_peval_string(ctx, value) != 0)
-			{
-				const char* error = duk_safe_to_string(ctx, -1);
-				g_log_error.log("JS Script") << error;
-				duk_pop_3(ctx);
-				return;
-			}
-			duk_put_prop_string(ctx, -2, name);
-			duk_pop_2(ctx);
+		void cancelPendingStart(uintptr id)
+		{
+			auto iter = m_pending_start_index.find(id);
+			if (iter == m_pending_start_index.end()) return;
+			m_pending_starts[iter.value()].entity = INVALID_ENTITY;
+			m_pending_start_index.erase(id);
 		}
 
 
-		void setPropertyValue(ComponentHandle cmp,
-			int scr_index,
-			const char* name,
-			const char* value) override
+		ScriptInstance* findInstance(Entity entity, uintptr id)
 		{
-			ScriptComponent* script_cmp = m_scripts[{cmp.index}];
-			if (!script_cmp) return;
-			Property& prop = getScriptProperty(cmp, scr_index, name);
-			if (!script_cmp->m_scripts[scr_index].m_script->isReady())
+			ScriptComponent* script_cmp = findScriptComponent(entity);
+			if (!script_cmp) return nullptr;
+			for (int i = 0; i < script_cmp->m_instance_count; ++i)
 			{
-				prop.stored_value = value;
-				return;
+				ScriptInstance& inst = getInstance(*script_cmp, i);
+				if (inst.m_id == id) return &inst;
 			}
-
-			applyProperty(m_system.m_global_context, script_cmp->m_scripts[scr_index], prop, value);
+			return nullptr;
 		}
 
-		const char* getPropertyName(ComponentHandle cmp, int scr_index, int index) const
-		{
-			auto& script = m_scripts[{cmp.index}]->m_scripts[scr_index];
 
-			return getPropertyName(script.m_properties[index].name_hash);
+		bool isCompiling(JSScript& script)
+		{
+			return m_system.m_compiler.isPending(script.getPath());
 		}
 
 
-		int getPropertyCount(ComponentHandle cmp, int scr_index) const
+		// [] -> [function] or [error], calling the function evaluates the script. It is cached
+		// for all instances and compiled here only if neither the bundle nor the compiler
+		// has bytecode for it
+		bool pushScriptFunction(JSScript& script)
 		{
-			auto& script = m_scripts[{cmp.index}]->m_scripts[scr_index];
+			duk_context* ctx = m_system.m_global_context;
+			const char* path = script.getPath().c_str();
+			duk_push_global_stash(ctx);
+			if (!duk_get_prop_string(ctx, -1, "functions"))
+			{
+				duk_pop(ctx);
+				duk_push_object(ctx);
+				duk_dup_top(ctx);
+				duk_put_prop_string(ctx, -3, "functions");
+			}
+			// [stash, functions]
+			if (duk_get_prop_string(ctx, -1, path))
+			{
+				duk_get_prop_string(ctx, -1, "\xff" "hash");
+				bool is_current = duk_get_uint(ctx, -1) == script.getSourceHash();
+				duk_pop(ctx);
+				if (is_current)
+				{
+					duk_remove(ctx, -2);
+					duk_remove(ctx, -2);
+					return true;
+				}
+			}
+			duk_pop(ctx);
 
-			return script.m_properties.size();
+			JSTracer& tracer = m_system.m_tracer;
+			tracer.begin("compile", "load", path);
+			const Array<u8>& bytecode = script.getBytecode();
+			bool is_loaded = !bytecode.empty();
+			if (is_loaded)
+			{
+				void* buffer = duk_push_fixed_buffer(ctx, bytecode.size());
+				copyMemory(buffer, &bytecode[0], bytecode.size());
+				duk_load_function(ctx);
+			}
+			else
+			{
+				is_loaded = m_system.m_compiler.load(ctx, script.getPath(), script.getSourceHash());
+			}
+			tracer.end();
+			if (!is_loaded && !script.hasSource())
+			{
+				duk_pop_2(ctx);
+				duk_push_error_object(ctx, DUK_ERR_ERROR, "source of %s has been released", path);
+				return false;
+			}
+			if (!is_loaded)
+			{
+				tracer.begin("compile", "compile", path);
+				duk_push_string(ctx, path);
+				bool is_error =
+					duk_pcompile_lstring_filename(ctx, DUK_COMPILE_EVAL, script.getSourceCode(), script.getSourceSize()) != 0;
+				tracer.end();
+				if (is_error)
+				{
+					duk_remove(ctx, -2);
+					duk_remove(ctx, -2);
+					return false;
+				}
+			}
+
+			// [stash, functions, function]
+			duk_push_uint(ctx, script.getSourceHash());
+			duk_put_prop_string(ctx, -2, "\xff" "hash");
+			duk_dup_top(ctx);
+			duk_put_prop_string(ctx, -3, path);
+			duk_remove(ctx, -2);
+			duk_remove(ctx, -2);
+			script.setFunctionCached();
+			return true;
 		}
 
 
-		static void* JSAllocator(void* ud, void* ptr, size_t osize, size_t nsize)
+		// [] -> [classes], constructors of the scripts which evaluate to a function, by path
+		static void pushClasses(duk_context* ctx)
 		{
-			auto& allocator = *static_cast<IAllocator*>(ud);
-			if (nsize == 0)
+			duk_push_global_stash(ctx);
+			if (!duk_get_prop_string(ctx, -1, "classes"))
 			{
-				allocator.deallocate(ptr);
-				return nullptr;
+				duk_pop(ctx);
+				duk_push_object(ctx);
+				duk_dup_top(ctx);
+				duk_put_prop_string(ctx, -3, "classes");
 			}
-			if (nsize > 0 && ptr == nullptr) return allocator.allocate(nsize);
-
-			void* new_mem = allocator.allocate(nsize);
-			copyMemory(new_mem, ptr, Math::minimum(osize, nsize));
-			allocator.deallocate(ptr);
-			return new_mem;
+			duk_remove(ctx, -2);
 		}
 
 
-		static int getScriptIndex(ScriptComponent& scr, ScriptInstance& inst)
+		// [] -> [obj] or [error]. A script which evaluates to a function is a class - it is
+		// evaluated once and the instances share its prototype, they are constructed with the
+		// entity, e.g.
+		//   function Mover(entity) { this.entity = entity; this.time = 0; }
+		//   Mover.prototype.update = function(time_delta) { this.time += time_delta; };
+		//   Mover
+		// any other script is evaluated for every instance, the result is the instance
+		bool pushScriptInstance(JSScript& script)
 		{
-			return int(&inst - &scr.m_scripts[0]);
+			duk_context* ctx = m_system.m_global_context;
+			const char* path = script.getPath().c_str();
+			pushClasses(ctx);
+			bool is_cached = false;
+			if (duk_get_prop_string(ctx, -1, path))
+			{
+				duk_get_prop_string(ctx, -1, "\xff" "hash");
+				is_cached = duk_get_uint(ctx, -1) == script.getSourceHash();
+				duk_pop(ctx);
+			}
+			if (!is_cached)
+			{
+				duk_pop(ctx);
+				bool is_error = !pushScriptFunction(script) || duk_pcall(ctx, 0) != 0;
+				if (is_error || !duk_is_function(ctx, -1))
+				{
+					duk_remove(ctx, -2);
+					return !is_error;
+				}
+				duk_push_uint(ctx, script.getSourceHash());
+				duk_put_prop_string(ctx, -2, "\xff" "hash");
+				duk_dup_top(ctx);
+				duk_put_prop_string(ctx, -3, path);
+			}
+
+			// [classes, class]
+			duk_remove(ctx, -2);
+			duk_get_global_string(ctx, "_entity");
+			return duk_pnew(ctx, 1) == 0;
 		}
 
 
-		void clearInstance(ScriptComponent& scr,  ScriptInstance& inst)
+		void startPendingScripts()
 		{
-			int scr_idx = getScriptIndex(scr, inst);
-			auto* call = beginFunctionCall({scr.m_entity.index}, scr_idx, "onDestroy");
-			if (call) endFunctionCall();
+			// scripts wait for the compiler, see isCompiling
+			u32 compiled_count = m_system.m_compiler.getFinishedCount();
+			if (!m_has_ready_pending && compiled_count == m_compiled_count) return;
+			PROFILE_FUNCTION();
+			m_has_ready_pending = false;
+			m_compiled_count = compiled_count;
 
-			for (int i = 0; i < m_updates.size(); ++i)
+			for (int i = m_pending_reloads.size() - 1; i >= 0; --i)
 			{
-				if (m_updates[i].id == inst.m_id)
+				JSScript* script = m_pending_reloads[i];
+				if (script->isReady() && isCompiling(*script)) continue;
+				if (script->isReady()) reloadScript(*script);
+				m_pending_reloads.erase(i);
+			}
+
+			// startScript can queue other scripts
+			Array<PendingStart> pending(m_system.m_allocator);
+			pending.swap(m_pending_starts);
+			m_pending_start_index.clear();
+			for (const PendingStart& item : pending)
+			{
+				// cancelled starts and instances of failed scripts are dropped
+				ScriptInstance* inst = findInstance(item.entity, item.id);
+				if (!inst || !inst->m_script || inst->m_script->isFailure()) continue;
+				if (!inst->m_script->isReady() || isCompiling(*inst->m_script))
 				{
-					m_updates.eraseFast(i);
-					break;
+					pushPendingStart(item.entity, item.id);
+					continue;
 				}
+
+				startScript(item.entity, *inst, false);
 			}
+		}
 
-			duk_context* ctx = m_system.m_global_context;
-			duk_push_global_stash(ctx);
-			duk_push_pointer(ctx, (void*)inst.m_id);
-			duk_del_prop(ctx, -2);
-			duk_pop(ctx);
 
-			inst.m_properties.clear();
+		void setScriptPath(Entity entity, int scr_index, const Path& path)
+		{
+			ScriptInstance* inst = &getInstance(*findScriptComponent(entity), scr_index);
+			if (inst->m_script)
+			{
+				inst = &clearInstance(entity, scr_index);
+				releaseScript(*inst->m_script);
+			}
+			inst->m_script = acquireScript(path);
+			if (!inst->m_script) return;
 
+			if (inst->m_script->isReady() && !isCompiling(*inst->m_script))
+				startScript(entity, *inst, false);
+			else
+				queueStart(entity, *inst);
 		}
 
 
-		void setScriptPath(ScriptComponent& cmp, ScriptInstance& inst, const Path& path)
+		void queueScript(ScriptComponent& cmp, ScriptInstance& inst, const Path& path)
 		{
-			if (inst.m_script)
-			{
-				clearInstance(cmp, inst);
-				auto& cb = inst.m_script->getObserverCb();
-				cb.unbind<ScriptComponent, &ScriptComponent::onScriptLoaded>(&cmp);
-				m_system.getScriptManager().unload(*inst.m_script);
-			}
-			inst.m_script = path.isValid() ? static_cast<JSScript*>(m_system.getScriptManager().load(path)) : nullptr;
-			if (inst.m_script)
-			{
-				inst.m_script->onLoaded<ScriptComponent, &ScriptComponent::onScriptLoaded>(&cmp);
-			}
+			ASSERT(!inst.m_script);
+			inst.m_script = acquireScript(path);
+			queueStart(cmp.m_entity, inst);
 		}
 
 
 		void detectProperties(ScriptInstance& inst)
 		{
 			duk_context* ctx = m_system.m_global_context;
-			duk_push_global_stash(ctx);
-			duk_push_pointer(ctx, (void*)inst.m_id);
-			duk_get_prop(ctx, -2); //[stash, id] -> [stash, obj]
+			pushInstance(ctx, inst.m_slot); // [table, obj]
 
 			duk_enum(ctx, -1, 0);
 			while (duk_next(ctx, -1, 1))
@@ -854,7 +2774,8 @@ namespace Lumix
 							default: existing_prop.type = Property::NUMBER;
 						}
 					}
-					applyProperty(ctx, inst, existing_prop, existing_prop.stored_value.c_str());
+					// the snapshot has the value too, without evaluating it
+					if (inst.m_snapshot.empty()) applyProperty(ctx, inst, existing_prop, existing_prop.stored_value.c_str());
 				}
 				else
 				{
@@ -870,61 +2791,333 @@ namespace Lumix
 				}
 				duk_pop_2(ctx);
 			}
-			duk_pop_3(ctx); // [stash obj enum] -> []
+			duk_pop_3(ctx); // [table obj enum] -> []
+		}
+
+
+		// a running instance is written to m_snapshot_blob, dormant instances keep the snapshot
+		// they were loaded with
+		const u8* getSnapshot(ScriptInstance& inst, int* size)
+		{
+			duk_context* ctx = m_system.m_global_context;
+			pushInstance(ctx, inst.m_slot); // [table obj]
+			if (!duk_is_object(ctx, -1))
+			{
+				duk_pop_2(ctx);
+				*size = inst.m_snapshot.size();
+				return inst.m_snapshot.empty() ? nullptr : &inst.m_snapshot[0];
+			}
+
+			m_snapshot_blob.clear();
+			JSSnapshot::write(ctx, -1, m_snapshot_blob, m_system.m_allocator);
+			duk_pop_2(ctx);
+			*size = m_snapshot_blob.getPos();
+			return (const u8*)m_snapshot_blob.getData();
+		}
+
+
+		void writeSnapshot(ScriptInstance& inst, OutputBlob& blob)
+		{
+			int size;
+			const u8* data = getSnapshot(inst, &size);
+			blob.write(size);
+			if (size > 0) blob.write(data, size);
+		}
+
+
+		// the text serializer has no binary values, the snapshot is written as hex digits. Entities
+		// are written by the serializer too, so pasted instances reference the pasted entities
+		void writeSnapshot(ScriptInstance& inst, ISerializer& serializer)
+		{
+			int size;
+			const u8* data = getSnapshot(inst, &size);
+			Array<Entity> entities(m_system.m_allocator);
+			if (size > 0) JSSnapshot::getEntities(data, size, entities);
+			serializer.write("snapshot_entity_count", entities.size());
+			for (Entity entity : entities)
+			{
+				serializer.write("snapshot_entity_index", entity.index);
+				serializer.write("snapshot_entity", entity);
+			}
+
+			static const char DIGITS[] = "0123456789abcdef";
+			Array<char> hex(m_system.m_allocator);
+			hex.resize(size * 2 + 1);
+			for (int i = 0; i < size; ++i)
+			{
+				hex[i * 2] = DIGITS[data[i] >> 4];
+				hex[i * 2 + 1] = DIGITS[data[i] & 0xf];
+			}
+			hex[size * 2] = '\0';
+			serializer.write("snapshot_size", size);
+			serializer.write("snapshot", &hex[0]);
+		}
+
+
+		// maps the entities the snapshot was written with to the read ones
+		struct SnapshotEntityRemap : JSSnapshot::IEntityRemap
+		{
+			explicit SnapshotEntityRemap(IAllocator& allocator)
+				: map(allocator)
+			{
+			}
+
+			Entity remap(Entity entity) override
+			{
+				auto iter = map.find(entity.index);
+				return iter == map.end() ? INVALID_ENTITY : iter.value();
+			}
+
+			HashMap<int, Entity> map;
+		};
+
+
+		void readSnapshot(ScriptInstance& inst, IDeserializer& serializer)
+		{
+			SnapshotEntityRemap remap(m_system.m_allocator);
+			int entity_count;
+			serializer.read(&entity_count);
+			for (int i = 0; i < entity_count; ++i)
+			{
+				int index;
+				Entity entity;
+				serializer.read(&index);
+				serializer.read(&entity);
+				remap.map.insert(index, entity);
+			}
+
+			int size;
+			serializer.read(&size);
+			Array<char> hex(m_system.m_allocator);
+			hex.resize(size * 2 + 1);
+			serializer.read(&hex[0], hex.size());
+			inst.m_snapshot.resize(size);
+			for (int i = 0; i < size; ++i)
+			{
+				u8 byte = 0;
+				for (int j = 0; j < 2; ++j)
+				{
+					char c = hex[i * 2 + j];
+					u8 digit = c >= 'a' ? c - 'a' + 10 : c - '0';
+					byte = (byte << 4) | (digit & 0xf);
+				}
+				inst.m_snapshot[i] = byte;
+			}
+			if (size > 0 && !JSSnapshot::remapEntities(&inst.m_snapshot[0], size, remap))
+			{
+				g_log_error.log("JS Script") << "Invalid script state";
+				inst.m_snapshot.clear();
+			}
+		}
+
+
+		void readSnapshot(ScriptInstance& inst, InputBlob& blob)
+		{
+			int size;
+			blob.read(size);
+			inst.m_snapshot.resize(size);
+			if (size > 0) blob.read(&inst.m_snapshot[0], size);
+		}
+
+
+		// entities are kept by index in a loaded universe, but scripts which started earlier
+		// may have destroyed some of them
+		struct UniverseEntityRemap : JSSnapshot::IEntityRemap
+		{
+			explicit UniverseEntityRemap(Universe& _universe)
+				: universe(_universe)
+			{
+			}
+
+			Entity remap(Entity entity) override { return universe.hasEntity(entity) ? entity : INVALID_ENTITY; }
+
+			Universe& universe;
+		};
+
+
+		// merged into the evaluated instance, so the restore costs on top of the initialization.
+		// The evaluation sets up what a snapshot does not keep, e.g. functions, subscriptions and
+		// timers, stored properties are not evaluated again, see detectProperties
+		void restoreSnapshot(ScriptInstance& inst)
+		{
+			if (inst.m_snapshot.empty()) return;
+
+			duk_context* ctx = m_system.m_global_context;
+			pushInstance(ctx, inst.m_slot); // [table obj]
+			InputBlob blob(&inst.m_snapshot[0], inst.m_snapshot.size());
+			UniverseEntityRemap remap(m_universe);
+			if (!JSSnapshot::read(ctx, -1, blob, m_universe, &remap, m_system.m_allocator))
+			{
+				g_log_error.log("JS Script") << "Failed to restore state of " << inst.m_script->getPath();
+			}
+			duk_pop_2(ctx);
+			inst.m_snapshot.clear();
 		}
 
 
+		// with lazy start the instance stays dormant until activateInstance
 		void startScript(Entity entity, ScriptInstance& instance, bool is_restart)
+		{
+			if (m_is_lazy_start && !is_restart)
+			{
+				instance.m_is_dormant = true;
+				return;
+			}
+			InstanceRef prev = setRunningInstance(entity, instance.m_id);
+			instantiate(entity, instance, is_restart);
+			m_running = prev;
+		}
+
+
+		// returns false if the instance is not running, e.g. its script failed
+		bool activateInstance(Entity entity, ScriptInstance& instance)
+		{
+			if (instance.m_is_dormant)
+			{
+				instance.m_is_dormant = false;
+				InstanceRef prev = setRunningInstance(entity, instance.m_id);
+				instantiate(entity, instance, false);
+				m_running = prev;
+			}
+			return instance.m_slot >= 0;
+		}
+
+
+		// [] -> [obj] or [undefined], a dormant instance is started first
+		void pushActiveInstance(Entity entity, int scr_index)
 		{
 			duk_context* ctx = m_system.m_global_context;
-			duk_push_global_stash(ctx);
+			ScriptComponent* script_cmp = findScriptComponent(entity);
+			if (!script_cmp || scr_index < 0 || scr_index >= script_cmp->m_instance_count)
+			{
+				duk_push_undefined(ctx);
+				return;
+			}
+			ScriptInstance& instance = getInstance(*script_cmp, scr_index);
+			activateInstance(entity, instance);
+			pushInstance(ctx, instance.m_slot);
+			duk_remove(ctx, -2);
+		}
+
+
+		void setLazyStart(bool is_lazy) override { m_is_lazy_start = is_lazy; }
+		bool isLazyStart() const override { return m_is_lazy_start; }
+
+
+		bool activateScript(ComponentHandle cmp, int scr_index) override
+		{
+			return activateInstance({cmp.index}, getInstance(cmp, scr_index));
+		}
+
+
+		bool isScriptActive(ComponentHandle cmp, int scr_index) override
+		{
+			return getInstance(cmp, scr_index).m_slot >= 0;
+		}
+
+
+		int getDormantScriptCount() const override
+		{
+			int count = 0;
+			for (const ScriptInstance& inst : m_instances)
+			{
+				if (inst.m_is_dormant) ++count;
+			}
+			return count;
+		}
+
+
+		int getPendingScriptCount() const override
+		{
+			return m_pending_start_index.size() + m_pending_reloads.size();
+		}
+
+
+		void instantiate(Entity entity, ScriptInstance& instance, bool is_restart)
+		{
+			// the script subscribes and adds its timers again when it is evaluated
+			unsubscribe(instance, 0);
+			removeTimers(instance);
+			unindexReceiver(instance);
+			JSScript* script = instance.m_script;
+			uintptr id = instance.m_id;
+
+			duk_context* ctx = m_system.m_global_context;
+			duk_push_heapptr(ctx, m_instance_table);
 
-			duk_push_pointer(ctx, (void*)instance.m_id);
-			
 			duk_get_global_string(ctx, "Entity");
 			duk_push_pointer(ctx, &m_universe);
 			JSWrapper::push(ctx, entity);
 			duk_new(ctx, 2);
 			duk_put_global_string(ctx, "_entity");
-			
-			if (duk_peval_string(ctx, instance.m_script->getSourceCode()) != 0)
+
+			bool is_error;
+			if (!is_restart && pushPooledInstance(*script))
+			{
+				// [table, obj] -> obj.onReuse(entity)
+				duk_get_prop_string(ctx, -1, "onReuse");
+				duk_dup(ctx, -2);
+				duk_get_global_string(ctx, "_entity");
+				int stats_index = getStatsIndex(*script);
+				CallbackScope callback_scope = beginCallback(stats_index, Callback::REUSE, entity);
+				is_error = duk_pcall_method(ctx, 1) != 0;
+				endCallback(stats_index, Callback::REUSE, entity, callback_scope);
+				if (is_error) duk_remove(ctx, -2);
+				else duk_pop(ctx);
+			}
+			else
+			{
+				JSTracer& tracer = m_system.m_tracer;
+				tracer.begin("compile", "eval", script->getPath().c_str());
+				m_system.m_script_path_stack.push(script->getPath());
+				is_error = !pushScriptInstance(*script);
+				m_system.m_script_path_stack.pop();
+				tracer.end();
+			}
+			if (is_error)
 			{
 				const char* error = duk_safe_to_string(ctx, -1);
 				g_log_error.log("JS Script") << error;
-				duk_pop_3(ctx);
+				duk_pop_2(ctx);
 				return;
 			}
 
-			if (!duk_is_object(ctx, -1))
+			// the script can add or remove instances while it is evaluated, the array may have
+			// moved and the instance may be gone
+			ScriptInstance* inst = findInstance(entity, id);
+			if (!duk_is_object(ctx, -1) || !inst || inst->m_script != script)
 			{
-				duk_pop_3(ctx);
+				duk_pop_2(ctx);
 				return;
 			}
 
-			duk_put_prop(ctx, -3); // stash[instance.id] = obj
+			// restarted instances keep their slot
+			if (inst->m_slot < 0) inst->m_slot = allocateSlot();
+			duk_put_prop_index(ctx, -2, (duk_uarridx_t)inst->m_slot); // table[slot] = obj
+			auto res_iter = m_script_resources.find(script->getPath().getHash());
+			if (res_iter != m_script_resources.end()) res_iter.value().is_started = true;
 
-			duk_push_pointer(ctx, (void*)instance.m_id); // [stash, id]
-			duk_get_prop(ctx, -2); // [stash, obj]
-			if (duk_is_undefined(ctx, -1))
-			{
-				duk_pop_2(ctx);
-				return;
-			}
+			duk_get_prop_index(ctx, -1, (duk_uarridx_t)inst->m_slot); // [table, obj]
 
 			duk_get_prop_string(ctx, -1, "update");
 			if (duk_is_callable(ctx, -1))
 			{
 				UpdateData& update = m_updates.emplace();
 				update.context = ctx;
-				update.id = instance.m_id;
+				update.id = id;
+				update.slot = inst->m_slot;
+				update.stats_index = getStatsIndex(*script);
+				update.entity = entity;
 			}
 			duk_pop(ctx);
 
-			detectProperties(instance);
+			detectProperties(*inst);
+			indexReceiver(entity, *inst);
+			restoreSnapshot(*inst);
 
 			if (!m_scripts_init_called)
 			{
-				duk_pop_2(ctx); // stash
+				duk_pop_2(ctx); // table
 				return;
 			}
 
@@ -936,12 +3129,15 @@ namespace Lumix
 			}
 			duk_dup(ctx, -2); // [this, func] -> [this, func, this]
 
+			int stats_index = getStatsIndex(*script);
+			CallbackScope callback_scope = beginCallback(stats_index, Callback::START_GAME, entity);
 			if (duk_pcall_method(ctx, 0))
 			{
 				const char* error = duk_safe_to_string(ctx, -1);
 				g_log_error.log("JS Script") << error;
 			}
-			duk_pop_2(ctx);
+			endCallback(stats_index, Callback::START_GAME, entity, callback_scope);
+			duk_pop_3(ctx);
 		}
 
 
@@ -956,6 +3152,10 @@ namespace Lumix
 			m_scripts_init_called = false;
 			m_is_game_running = false;
 			m_updates.clear();
+			clearEvents();
+			clearMessages();
+			for (ScriptInstance& inst : m_instances) removeTimers(inst);
+			clearPools();
 		}
 
 
@@ -963,11 +3163,7 @@ namespace Lumix
 		{
 			if (type != JS_SCRIPT_TYPE) return INVALID_COMPONENT;
 
-			auto& allocator = m_system.m_allocator;
-			ScriptComponent* script = LUMIX_NEW(allocator, ScriptComponent)(*this, allocator);
-			ComponentHandle cmp = {entity.index};
-			script->m_entity = entity;
-			m_scripts.insert(entity, script);
+			ComponentHandle cmp = addScriptComponent(entity, 0);
 			m_universe.addComponent(entity, type, this, cmp);
 
 			return cmp;
@@ -979,19 +3175,12 @@ namespace Lumix
 			if (type != JS_SCRIPT_TYPE) return;
 
 			Entity entity = {component.index};
-			auto* script = m_scripts[entity];
-			for (auto& scr : script->m_scripts)
+			for (int i = 0; i < getScriptComponent(component).m_instance_count; ++i)
 			{
-				clearInstance(*script, scr);
-				if (scr.m_script)
-				{
-					auto& cb = scr.m_script->getObserverCb();
-					cb.unbind<ScriptComponent, &ScriptComponent::onScriptLoaded>(script);
-					m_system.getScriptManager().unload(*scr.m_script);
-				}
+				ScriptInstance& scr = clearInstance(entity, i);
+				if (scr.m_script) releaseScript(*scr.m_script);
 			}
-			LUMIX_DELETE(m_system.m_allocator, script);
-			m_scripts.erase(entity);
+			removeScriptComponent(entity);
 			m_universe.destroyComponent(entity, type, this, component);
 		}
 
@@ -1005,7 +3194,7 @@ namespace Lumix
 			ASSERT(max_size > 0);
 
 			u32 hash = crc32(property_name);
-			auto& inst = m_scripts[{cmp.index}]->m_scripts[scr_index];
+			auto& inst = getInstance(cmp, scr_index);
 			for (auto& prop : inst.m_properties)
 			{
 				if (prop.name_hash == hash)
@@ -1024,9 +3213,13 @@ namespace Lumix
 		void getProperty(Property& prop, const char* prop_name, ScriptInstance& scr, char* out, int max_size)
 		{
 			duk_context* ctx = m_system.m_global_context;
-			duk_push_global_stash(ctx);
-			duk_push_pointer(ctx, (void*)scr.m_id);
-			duk_get_prop(ctx, -2); // -> [stash obj]
+			pushInstance(ctx, scr.m_slot); // -> [table obj]
+			if (!duk_is_object(ctx, -1))
+			{
+				copyString(out, max_size, prop.stored_value.c_str());
+				duk_pop_2(ctx);
+				return;
+			}
 			duk_get_prop_string(ctx, -1, prop_name); // -> [stash obj prop]
 			if (duk_is_null_or_undefined(ctx, -1))
 			{
@@ -1050,7 +3243,8 @@ namespace Lumix
 				break;
 				case Property::STRING: 
 				{ 
-					copyString(out, max_size, duk_get_string(ctx, -1));
+					// applyProperty evaluates the value, so it is stored as a literal
+					copyString(out, max_size, duk_json_encode(ctx, -1));
 				}
 				break;
 				default: ASSERT(false); break;
@@ -1061,10 +3255,11 @@ namespace Lumix
 
 		void serializeJSScript(ISerializer& serializer, ComponentHandle cmp)
 		{
-			ScriptComponent* script = m_scripts[{cmp.index}];
-			serializer.write("count", script->m_scripts.size());
-			for (ScriptInstance& inst : script->m_scripts)
+			ScriptComponent& script = getScriptComponent(cmp);
+			serializer.write("count", script.m_instance_count);
+			for (int i = 0; i < script.m_instance_count; ++i)
 			{
+				ScriptInstance& inst = getInstance(script, i);
 				serializer.write("source", inst.m_script ? inst.m_script->getPath().c_str() : "");
 				serializer.write("prop_count", inst.m_properties.size());
 				for (Property& prop : inst.m_properties)
@@ -1086,6 +3281,7 @@ namespace Lumix
 						serializer.write("prop_value", "");
 					}
 				}
+				writeSnapshot(inst, serializer);
 			}
 		}
 
@@ -1093,21 +3289,15 @@ namespace Lumix
 		void deserializeJSScript(IDeserializer& serializer, Entity entity, int scene_version)
 		{
 			auto& allocator = m_system.m_allocator;
-			ScriptComponent* script = LUMIX_NEW(allocator, ScriptComponent)(*this, allocator);
-			ComponentHandle cmp = {entity.index};
-			script->m_entity = entity;
-			m_scripts.insert(entity, script);
-			
 			int count;
 			serializer.read(&count);
-			script->m_scripts.reserve(count);
-			auto* manager = m_system.m_engine.getResourceManager().get(JS_SCRIPT_RESOURCE_TYPE);
+			ComponentHandle cmp = addScriptComponent(entity, count);
 			for (int i = 0; i < count; ++i)
 			{
-				ScriptInstance& inst = script->m_scripts.emplace(allocator);
+				ScriptInstance& inst = emplaceInstance(cmp, i);
 				char tmp[MAX_PATH_LENGTH];
 				serializer.read(tmp, lengthOf(tmp));
-				setScriptPath(cmp, i, Path(tmp));
+				queueScript(getScriptComponent(cmp), inst, Path(tmp));
 
 				int prop_count;
 				serializer.read(&prop_count);
@@ -1128,6 +3318,7 @@ namespace Lumix
 					
 					prop.stored_value = tmp;
 				}
+				if (scene_version > (int)JSSceneVersion::TEXT_SNAPSHOT) readSnapshot(inst, serializer);
 			}
 
 			m_universe.addComponent(entity, JS_SCRIPT_TYPE, this, cmp);
@@ -1136,14 +3327,16 @@ namespace Lumix
 
 		void serialize(OutputBlob& serializer) override
 		{
-			serializer.write(m_scripts.size());
-			for (auto iter = m_scripts.begin(), end = m_scripts.end(); iter != end; ++iter)
+			// negative, older blobs start with the component count
+			serializer.write(-1 - (int)JSSceneVersion::LATEST);
+			serializer.write(m_components.size());
+			for (const ScriptComponent& script_cmp : m_components)
 			{
-				ScriptComponent* script_cmp = iter.value();
-				serializer.write(script_cmp->m_entity);
-				serializer.write(script_cmp->m_scripts.size());
-				for (auto& scr : script_cmp->m_scripts)
+				serializer.write(script_cmp.m_entity);
+				serializer.write(script_cmp.m_instance_count);
+				for (int i = 0; i < script_cmp.m_instance_count; ++i)
 				{
+					ScriptInstance& scr = getInstance(script_cmp, i);
 					serializer.writeString(scr.m_script ? scr.m_script->getPath().c_str() : "");
 					serializer.write(scr.m_id);
 					serializer.write(scr.m_properties.size());
@@ -1163,6 +3356,7 @@ namespace Lumix
 							serializer.writeString("");
 						}
 					}
+					writeSnapshot(scr, serializer);
 				}
 			}
 		}
@@ -1170,24 +3364,30 @@ namespace Lumix
 
 		void deserialize(InputBlob& serializer) override
 		{
+			int scene_version = (int)JSSceneVersion::SNAPSHOT;
 			int len = serializer.read<int>();
-			m_scripts.rehash(len);
+			if (len < 0)
+			{
+				scene_version = -1 - len;
+				len = serializer.read<int>();
+			}
+			m_components.reserve(len);
 			for (int i = 0; i < len; ++i)
 			{
 				auto& allocator = m_system.m_allocator;
-				ScriptComponent* script = LUMIX_NEW(allocator, ScriptComponent)(*this, allocator);
-
-				serializer.read(script->m_entity);
-				m_scripts.insert(script->m_entity, script);
+				Entity entity;
+				serializer.read(entity);
 				int scr_count;
 				serializer.read(scr_count);
+				ComponentHandle cmp = addScriptComponent(entity, scr_count);
 				for (int j = 0; j < scr_count; ++j)
 				{
-					auto& scr = script->m_scripts.emplace(allocator);
+					auto& scr = emplaceInstance(cmp, j);
 
 					char tmp[MAX_PATH_LENGTH];
 					serializer.readString(tmp, MAX_PATH_LENGTH);
 					serializer.read(scr.m_id);
+					m_id_generator = Math::maximum(m_id_generator, scr.m_id);
 					int prop_count;
 					serializer.read(prop_count);
 					scr.m_properties.reserve(prop_count);
@@ -1201,11 +3401,12 @@ namespace Lumix
 						serializer.readString(tmp, sizeof(tmp));
 						prop.stored_value = tmp;
 					}
-					setScriptPath(*script, scr, Path(tmp));
+					if (scene_version > (int)JSSceneVersion::SNAPSHOT) readSnapshot(scr, serializer);
+					queueScript(getScriptComponent(cmp), scr, Path(tmp));
 				}
-				ComponentHandle cmp = { script->m_entity.index };
-				m_universe.addComponent(script->m_entity, JS_SCRIPT_TYPE, this, cmp);
+				m_universe.addComponent(entity, JS_SCRIPT_TYPE, this, cmp);
 			}
+			startPendingScripts();
 		}
 
 
@@ -1215,20 +3416,24 @@ namespace Lumix
 		void initScripts()
 		{
 			ASSERT(!m_scripts_init_called && m_is_game_running);
-			// copy m_scripts to tmp, because scripts can create other scripts -> m_scripts is not const
-			Array<ScriptComponent*> tmp(m_system.m_allocator);
-			tmp.reserve(m_scripts.size());
-			for (auto* scr : m_scripts) tmp.push(scr);
+			// copy entities to tmp, because scripts can create other scripts -> m_components is not const
+			Array<Entity> tmp(m_system.m_allocator);
+			tmp.reserve(m_components.size());
+			for (const ScriptComponent& scr : m_components) tmp.push(scr.m_entity);
 
-			for (auto* scr : tmp)
+			for (Entity entity : tmp)
 			{
-				for (int j = 0; j < scr->m_scripts.size(); ++j)
+				for (int j = 0;; ++j)
 				{
-					auto& instance = scr->m_scripts[j];
+					ScriptComponent* scr = findScriptComponent(entity);
+					if (!scr || j >= scr->m_instance_count) break;
+					auto& instance = getInstance(*scr, j);
 					if (!instance.m_script) continue;
 					if (!instance.m_script->isReady()) continue;
+					// started when activated
+					if (instance.m_is_dormant) continue;
 
-					auto* call = beginFunctionCall({ scr->m_entity.index }, j, "onStartGame");
+					auto* call = beginFunctionCall({ entity.index }, j, "onStartGame");
 					if (call) endFunctionCall();
 				}
 			}
@@ -1240,32 +3445,74 @@ namespace Lumix
 		{
 			PROFILE_FUNCTION();
 
+			startPendingScripts();
 			if (m_is_game_running && !m_scripts_init_called) initScripts();
+			// nobody to deliver to in the editor
+			if (!m_is_game_running)
+			{
+				clearEvents();
+				if (!m_messages.empty()) clearMessages();
+			}
 
 			if (paused || !m_is_game_running) return;
 
+			dispatchEvents();
+			deliverMessages();
+			fireTimers(time_delta);
+
+			JSAllocTracker& alloc_tracker = m_system.m_allocator;
+			alloc_tracker.beginFrame();
+			alloc_tracker.setSite(-1, DISPATCH_SITE, true);
 			for (int i = 0; i < m_updates.size(); ++i)
 			{
 				UpdateData update_item = m_updates[i];
-				duk_push_global_stash(update_item.context);
-				duk_push_pointer(update_item.context, (void*)update_item.id);
-				duk_get_prop(update_item.context, -2); //[stash, this]
-				duk_get_prop_string(update_item.context, -1, "update"); //[stash, this, func]
-				duk_dup(update_item.context, -2); //[stash, this, func, this]
+				duk_push_heapptr(update_item.context, m_instance_table);
+				duk_get_prop_index(update_item.context, -1, (duk_uarridx_t)update_item.slot); //[table, this]
+				duk_get_prop_string(update_item.context, -1, "update"); //[table, this, func]
+				duk_dup(update_item.context, -2); //[table, this, func, this]
 				duk_push_number(update_item.context, time_delta);
-				if (duk_pcall_method(update_item.context, 1) == DUK_EXEC_ERROR) //[stash, this, func, this, arg] -> [stash, this, retval]
+				InstanceRef prev = setRunningInstance(update_item.entity, update_item.id);
+				CallbackScope callback_scope = beginCallback(update_item.stats_index, Callback::UPDATE, update_item.entity);
+				if (duk_pcall_method(update_item.context, 1) == DUK_EXEC_ERROR) //[table, this, func, this, arg] -> [table, this, retval]
 				{
 					const char* error = duk_safe_to_string(update_item.context, -1);
 					g_log_error.log("JS Script") << error;
 				}
+				endCallback(update_item.stats_index, Callback::UPDATE, update_item.entity, callback_scope);
+				m_running = prev;
 				duk_pop_3(update_item.context);
 			}
+			if (alloc_tracker.endFrame()) reportAllocations();
+		}
+
+
+		void reportAllocations()
+		{
+			static const u32 MAX_REPORTED_FRAMES = 10;
+
+			const JSAllocTracker& tracker = m_system.m_allocator;
+			if (tracker.getDirtyFrameCount() > MAX_REPORTED_FRAMES) return;
+
+			for (int i = 0, c = tracker.getSiteCount(); i < c; ++i)
+			{
+				const JSAllocTracker::Site& site = tracker.getSite(i);
+				g_log_warning.log("JS Script") << "Frame " << (int)tracker.getLastDirtyFrame() << ": "
+											   << int(site.heap_count + site.engine_count) << " allocations, "
+											   << int(site.heap_bytes + site.engine_bytes) << " bytes in "
+											   << (site.script < 0 ? "plugin" : m_script_stats[site.script].path.c_str())
+											   << ", " << (site.name ? site.name : "unknown")
+											   << (site.is_binding ? " (binding)" : "");
+			}
+			if (tracker.getDirtyFrameCount() == MAX_REPORTED_FRAMES)
+			{
+				g_log_warning.log("JS Script") << "Further allocations are shown only in the profiler window";
+			}
 		}
 
 
 		ComponentHandle getComponent(Entity entity, ComponentType type) override
 		{
-			if (m_scripts.find(entity) == m_scripts.end()) return INVALID_COMPONENT;
+			if (type != JS_SCRIPT_TYPE || !findScriptComponent(entity)) return INVALID_COMPONENT;
 			return {entity.index};
 		}
 
@@ -1273,8 +3520,8 @@ namespace Lumix
 		Property& getScriptProperty(ComponentHandle cmp, int scr_index, const char* name)
 		{
 			u32 name_hash = crc32(name);
-			ScriptComponent* script_cmp = m_scripts[{cmp.index}];
-			for (auto& prop : script_cmp->m_scripts[scr_index].m_properties)
+			ScriptInstance& inst = getInstance(cmp, scr_index);
+			for (auto& prop : inst.m_properties)
 			{
 				if (prop.name_hash == name_hash)
 				{
@@ -1282,8 +3529,7 @@ namespace Lumix
 				}
 			}
 
-			script_cmp->m_scripts[scr_index].m_properties.emplace(m_system.m_allocator);
-			auto& prop = script_cmp->m_scripts[scr_index].m_properties.back();
+			auto& prop = inst.m_properties.emplace(m_system.m_allocator);
 			prop.name_hash = name_hash;
 			return prop;
 		}
@@ -1291,64 +3537,60 @@ namespace Lumix
 
 		Path getScriptPath(ComponentHandle cmp, int scr_index) override
 		{
-			auto& tmp = m_scripts[{cmp.index}]->m_scripts[scr_index];
+			auto& tmp = getInstance(cmp, scr_index);
 			return tmp.m_script ? tmp.m_script->getPath() : Path("");
 		}
 
 
 		void setScriptPath(ComponentHandle cmp, int scr_index, const Path& path) override
 		{
-			auto* script_cmp = m_scripts[{cmp.index}];
-			if (script_cmp->m_scripts.size() <= scr_index) return;
-			setScriptPath(*script_cmp, script_cmp->m_scripts[scr_index], path);
+			ScriptComponent& script_cmp = getScriptComponent(cmp);
+			if (script_cmp.m_instance_count <= scr_index) return;
+			setScriptPath(script_cmp.m_entity, scr_index, path);
 		}
 
 
 		int getScriptCount(ComponentHandle cmp) override
 		{
-			return m_scripts[{cmp.index}]->m_scripts.size();
+			return getScriptComponent(cmp).m_instance_count;
 		}
 
 
 		void insertScript(ComponentHandle cmp, int idx) override
 		{
-			m_scripts[{cmp.index}]->m_scripts.emplaceAt(idx, m_system.m_allocator);
+			emplaceInstance(cmp, idx);
 		}
 
 
 		int addScript(ComponentHandle cmp) override
 		{
-			ScriptComponent* script_cmp = m_scripts[{cmp.index}];
-			ScriptInstance& inst = script_cmp->m_scripts.emplace(m_system.m_allocator);
-			inst.m_id = ++m_id_generator;
-			return script_cmp->m_scripts.size() - 1;
+			int idx = getScriptComponent(cmp).m_instance_count;
+			emplaceInstance(cmp, idx);
+			return idx;
 		}
 
 
 		void moveScript(ComponentHandle cmp, int scr_index, bool up) override
 		{
-			auto* script_cmp = m_scripts[{cmp.index}];
-			if (!up && scr_index > script_cmp->m_scripts.size() - 2) return;
+			ScriptComponent& script_cmp = getScriptComponent(cmp);
+			if (!up && scr_index > script_cmp.m_instance_count - 2) return;
 			if (up && scr_index == 0) return;
 			int other = up ? scr_index - 1 : scr_index + 1;
-			ScriptInstance tmp = script_cmp->m_scripts[scr_index];
-			script_cmp->m_scripts[scr_index] = script_cmp->m_scripts[other];
-			script_cmp->m_scripts[other] = tmp;
+			swapInstances(getInstance(script_cmp, scr_index), getInstance(script_cmp, other));
 		}
 
 
 		void removeScript(ComponentHandle cmp, int scr_index) override
 		{
 			setScriptPath(cmp, scr_index, Path());
-			ScriptComponent* script_cmp = m_scripts[{cmp.index}];
-			clearInstance(*script_cmp, script_cmp->m_scripts[scr_index]);
-			script_cmp->m_scripts.eraseFast(scr_index);
+			clearInstance({cmp.index}, scr_index);
+			eraseInstance(getScriptComponent(cmp), scr_index);
 		}
 
 
 		void serializeScript(ComponentHandle cmp, int scr_index, OutputBlob& blob) override
 		{
-			auto& scr = m_scripts[{cmp.index}]->m_scripts[scr_index];
+			auto& scr = getInstance(cmp, scr_index);
 			blob.writeString(scr.m_script ? scr.m_script->getPath().c_str() : "");
 			blob.write(scr.m_properties.size());
 			for (auto& prop : scr.m_properties)
@@ -1371,7 +3613,7 @@ namespace Lumix
 
 		void deserializeScript(ComponentHandle cmp, int scr_index, InputBlob& blob) override
 		{
-			auto& scr = m_scripts[{cmp.index}]->m_scripts[scr_index];
+			auto& scr = getInstance(cmp, scr_index);
 			int count;
 			char path[MAX_PATH_LENGTH];
 			blob.readString(path, lengthOf(path));
@@ -1391,36 +3633,463 @@ namespace Lumix
 
 
 		JSScriptSystemImpl& m_system;
-		HashMap<Entity, ScriptComponent*> m_scripts;
+		Array<int> m_component_map;
+		Array<ScriptComponent> m_components;
+		Array<ScriptInstance> m_instances;
+		Array<InstanceBlock> m_free_blocks;
+		void* m_instance_table;
+		void* m_pool_table; // pools of reusable instances by script path, see poolInstance
+		void* m_handler_table; // event handlers, see subscribe
+		Array<int> m_free_handlers;
+		int m_handler_count = 0;
+		Array<InstanceRef> m_subscribers;
+		InstanceRef m_running;
+		Array<Event> m_events;
+		Array<u8> m_event_args;
+		EventArgs m_event_args_call;
+		HashMap<u32, int> m_event_map; // first event of the key, see dispatchEvents
+		u32 m_event_frame = 0;
+		JSTimerQueue m_timer_queue;
+		Array<int> m_expired_timers;
+		Array<MessageReceivers> m_receivers;
+		HashMap<u32, int> m_receiver_map; // name hash -> index in m_receivers
+		Array<ReceiveItem> m_receive_items;
+		int m_free_receive_item = -1;
+		Array<Message> m_messages;
+		void* m_mailbox; // names and payloads of m_messages, two items per message
+		HashMap<u32, int> m_message_map; // first message of the key, see deliverMessages
+		Array<int> m_free_slots;
+		int m_slot_count = 0;
+		Array<ScriptStats> m_script_stats;
+		Timer* m_timer;
 		AssociativeArray<u32, string> m_property_names;
 		Universe& m_universe;
 		Array<UpdateData> m_updates;
 		FunctionCall m_function_call;
+		HashMap<u32, ScriptResource> m_script_resources;
+		Array<JSScript*> m_pending_reloads;
+		// in the order of queueing, cancelled starts stay with an invalid entity
+		Array<PendingStart> m_pending_starts;
+		// instance id -> index in m_pending_starts
+		HashMap<uintptr, int> m_pending_start_index;
+		OutputBlob m_snapshot_blob;
 		ScriptInstance* m_current_script_instance;
 		bool m_scripts_init_called = false;
 		bool m_is_api_registered = false;
 		bool m_is_game_running = false;
+		bool m_is_lazy_start = false;
+		bool m_has_ready_pending = false;
+		u32 m_compiled_count = 0;
 		uintptr m_id_generator = 0;
 	};
 
 
+	static void* heapAlloc(void* udata, duk_size_t size)
+	{
+		auto* system = static_cast<JSScriptSystemImpl*>(udata);
+		system->m_allocator.onHeapAllocate(size);
+		return system->m_heap_monitor.allocate(size);
+	}
+
+
+	static void* heapRealloc(void* udata, void* ptr, duk_size_t size)
+	{
+		auto* system = static_cast<JSScriptSystemImpl*>(udata);
+		system->m_allocator.onHeapAllocate(size);
+		return system->m_heap_monitor.reallocate(ptr, size);
+	}
+
+
+	static void heapFree(void* udata, void* ptr)
+	{
+		static_cast<JSScriptSystemImpl*>(udata)->m_heap_monitor.deallocate(ptr);
+	}
+
+
 	JSScriptSystemImpl::JSScriptSystemImpl(Engine& engine)
 		: m_engine(engine)
-		, m_allocator(engine.getAllocator())
+		, m_debug_allocator(engine.getAllocator())
+		, m_allocator(m_debug_allocator)
 		, m_script_manager(m_allocator)
+		, m_profiler(m_allocator)
+		, m_heap_monitor(m_debug_allocator) // script heap allocations are reported by heapAlloc
+		, m_tracer(m_debug_allocator)
+		, m_binding_stats(m_debug_allocator)
+		, m_compiler(m_debug_allocator) // used from the compiler thread too
+		, m_bundle(m_allocator)
+		, m_bundle_device(m_bundle, m_allocator)
+		, m_script_path_stack(m_debug_allocator)
 	{
 		m_script_manager.create(JS_SCRIPT_RESOURCE_TYPE, engine.getResourceManager());
+		m_script_manager.setTracer(&m_tracer);
+		m_script_manager.setCompiler(&m_compiler);
+		m_compiler.start();
+
+		// the game runs from the bundle if there is one, the studio unmounts it
+		mountBundle();
 
 		auto& allocator = engine.getAllocator();
 		PropertyRegister::add("js_script",
 			LUMIX_NEW(allocator, BlobPropertyDescriptor<JSScriptScene>)(
 				"data", &JSScriptScene::getScriptData, &JSScriptScene::setScriptData));
 
-		m_global_context = duk_create_heap_default();
+		// the system is the heap udata, see lumix_duk_interrupt
+		m_global_context = duk_create_heap(&heapAlloc, &heapRealloc, &heapFree, this, nullptr);
+		m_profiler.setContext(m_global_context);
+		m_gc_scheduler.setContext(m_global_context);
 		registerGlobalAPI();
 	}
 
 
+	static JSScriptSystemImpl& getSystem(duk_context* ctx)
+	{
+		duk_memory_functions funcs;
+		duk_get_memory_functions(ctx, &funcs);
+		return *static_cast<JSScriptSystemImpl*>(funcs.udata);
+	}
+
+
+	static JSAllocTracker& getAllocTracker(duk_context* ctx)
+	{
+		return getSystem(ctx).m_allocator;
+	}
+
+
+	static JSTracer& getTracer(duk_context* ctx)
+	{
+		return getSystem(ctx).m_tracer;
+	}
+
+
+	static JSBindingStats& getBindingStats(duk_context* ctx)
+	{
+		return getSystem(ctx).m_binding_stats;
+	}
+
+
+	// startAllocationTracking(warmup_frames = 60)
+	static int startAllocationTracking(duk_context* ctx)
+	{
+		int warmup_frames = duk_is_number(ctx, 0) ? duk_get_int(ctx, 0) : 60;
+		getAllocTracker(ctx).start(warmup_frames);
+		return 0;
+	}
+
+
+	static int stopAllocationTracking(duk_context* ctx)
+	{
+		getAllocTracker(ctx).stop();
+		return 0;
+	}
+
+
+	// startTrace(path = "js_trace.json", binding_threshold_ms = 0.1)
+	static int startTrace(duk_context* ctx)
+	{
+		JSTracer& tracer = getTracer(ctx);
+		if (duk_is_number(ctx, 1)) tracer.setBindingThreshold((float)duk_get_number(ctx, 1));
+		const char* path = duk_is_string(ctx, 0) ? duk_get_string(ctx, 0) : "js_trace.json";
+		duk_push_boolean(ctx, tracer.start(path));
+		return 1;
+	}
+
+
+	static int stopTrace(duk_context* ctx)
+	{
+		getTracer(ctx).stop();
+		return 0;
+	}
+
+
+	// the module function is called as (exports, require, module), require is bound to the module
+	static bool compileModule(duk_context* ctx, JSScript& module)
+	{
+		const Array<u8>& bytecode = module.getModuleBytecode();
+		if (!bytecode.empty())
+		{
+			void* buffer = duk_push_fixed_buffer(ctx, bytecode.size());
+			copyMemory(buffer, &bytecode[0], bytecode.size());
+			duk_load_function(ctx);
+			return true;
+		}
+
+		const char* path = module.getPath().c_str();
+		JSTracer& tracer = getTracer(ctx);
+		tracer.begin("compile", "module", path);
+		duk_push_string(ctx, JS_MODULE_HEADER);
+		duk_push_lstring(ctx, module.getSourceCode(), module.getSourceSize());
+		duk_push_string(ctx, JS_MODULE_FOOTER);
+		duk_concat(ctx, 3);
+		duk_push_string(ctx, path);
+		bool is_error = duk_pcompile(ctx, DUK_COMPILE_FUNCTION) != 0;
+		tracer.end();
+		return !is_error;
+	}
+
+
+	// the scene of the entity object at idx, nullptr if it is not an entity
+	static JSScriptSceneImpl* getEntityScene(duk_context* ctx, int idx, Entity* entity)
+	{
+		if (!duk_is_object(ctx, idx)) return nullptr;
+		duk_get_prop_string(ctx, idx, "c_universe");
+		auto* universe = (Universe*)duk_get_pointer(ctx, -1);
+		duk_get_prop_string(ctx, idx, "c_entity");
+		*entity = {duk_get_int(ctx, -1)};
+		duk_pop_2(ctx);
+		return universe ? static_cast<JSScriptSceneImpl*>(universe->getScene(JS_SCRIPT_TYPE)) : nullptr;
+	}
+
+
+	// getScriptInstance(entity, index = 0), the object of a script of the entity,
+	// a dormant instance is started first, see JSScriptScene::setLazyStart
+	static int getScriptInstance(duk_context* ctx)
+	{
+		Entity entity;
+		auto* scene = getEntityScene(ctx, 0, &entity);
+		if (!scene) return duk_error(ctx, DUK_ERR_TYPE_ERROR, "entity expected");
+		scene->pushActiveInstance(entity, duk_get_int_default(ctx, 1, 0));
+		return 1;
+	}
+
+
+	// sendMessage(entity, name, payload), the scripts of the entity with a method of the name
+	// are called with the payload once per frame before update, in one batch per script
+	static int sendMessage(duk_context* ctx)
+	{
+		duk_set_top(ctx, 3);
+		Entity entity;
+		auto* scene = getEntityScene(ctx, 0, &entity);
+		if (!scene) return duk_error(ctx, DUK_ERR_TYPE_ERROR, "entity expected");
+		const char* name = JSWrapper::checkArg<const char*>(ctx, 1);
+		scene->postMessage(name, entity, 2);
+		return 0;
+	}
+
+
+	// broadcast(name, payload), like sendMessage for all scripts in the scene of the caller
+	static int broadcast(duk_context* ctx)
+	{
+		duk_set_top(ctx, 2);
+		const char* name = JSWrapper::checkArg<const char*>(ctx, 0);
+		JSScriptSceneImpl* scene = getSystem(ctx).m_running_scene;
+		if (!scene) return duk_error(ctx, DUK_ERR_ERROR, "broadcast() can be called only by a script instance");
+		scene->postMessage(name, INVALID_ENTITY, 1);
+		return 0;
+	}
+
+
+	// on(name, handler), the handler is called with the instance as this and the arguments
+	// of the event, see JSScriptScene::postEvent. Subscriptions end when the instance is
+	// destroyed, a reused instance subscribes again in onReuse
+	static int on(duk_context* ctx)
+	{
+		const char* name = JSWrapper::checkArg<const char*>(ctx, 0);
+		if (!duk_is_callable(ctx, 1)) return duk_error(ctx, DUK_ERR_TYPE_ERROR, "function expected");
+		JSScriptSceneImpl* scene = getSystem(ctx).m_running_scene;
+		if (!scene || !scene->subscribe(name, 1))
+		{
+			return duk_error(ctx, DUK_ERR_ERROR, "on() can be called only by a script instance");
+		}
+		return 0;
+	}
+
+
+	// off(name), removes all handlers of the event of the running instance
+	static int off(duk_context* ctx)
+	{
+		const char* name = JSWrapper::checkArg<const char*>(ctx, 0);
+		JSScriptSceneImpl* scene = getSystem(ctx).m_running_scene;
+		if (!scene || !scene->unsubscribe(name))
+		{
+			return duk_error(ctx, DUK_ERR_ERROR, "off() can be called only by a script instance");
+		}
+		return 0;
+	}
+
+
+	// [fn, ms] -> id, see JSScriptSceneImpl::addTimer
+	static int addTimer(duk_context* ctx, bool is_interval)
+	{
+		if (!duk_is_callable(ctx, 0)) return duk_error(ctx, DUK_ERR_TYPE_ERROR, "function expected");
+		float time = (float)duk_get_number_default(ctx, 1, 0) * 0.001f;
+		if (!(time > 0)) time = 0; // NaN too
+		JSScriptSceneImpl* scene = getSystem(ctx).m_running_scene;
+		int id = scene ? scene->addTimer(0, time, is_interval ? time : -1) : 0;
+		if (id == 0) return duk_error(ctx, DUK_ERR_ERROR, "timers can be added only by a script instance");
+		duk_push_int(ctx, id);
+		return 1;
+	}
+
+
+	// setTimeout(fn, ms = 0), fn is called once with the instance as this. Timers advance
+	// with the game time and are removed with the instance which added them.
+	static int setTimeout(duk_context* ctx)
+	{
+		return addTimer(ctx, false);
+	}
+
+
+	// setInterval(fn, ms = 0), fn is called at most once per frame
+	static int setInterval(duk_context* ctx)
+	{
+		return addTimer(ctx, true);
+	}
+
+
+	// clearTimeout(id), removes timeouts and intervals of any instance of the scene
+	static int clearTimeout(duk_context* ctx)
+	{
+		int id = duk_get_int_default(ctx, 0, 0);
+		JSScriptSceneImpl* scene = getSystem(ctx).m_running_scene;
+		if (scene && id != 0) scene->removeTimer(id);
+		return 0;
+	}
+
+
+	static int clearInterval(duk_context* ctx)
+	{
+		return clearTimeout(ctx);
+	}
+
+
+	// require(path), a module is evaluated once and its exports are shared by all scripts;
+	// only modules required with a string literal are loaded, see JSScript::loadModules
+	static int require(duk_context* ctx)
+	{
+		JSScriptSystemImpl& system = getSystem(ctx);
+		const char* request = JSWrapper::checkArg<const char*>(ctx, 0);
+
+		duk_push_current_function(ctx);
+		duk_get_prop_string(ctx, -1, "\xff" "path");
+		const char* base = "";
+		if (duk_is_string(ctx, -1)) base = duk_get_string(ctx, -1);
+		else if (!system.m_script_path_stack.empty()) base = system.m_script_path_stack.back().c_str();
+		char path[MAX_PATH_LENGTH];
+		resolveJSModulePath(base, request, path, lengthOf(path));
+		duk_pop_2(ctx);
+
+		duk_push_global_stash(ctx);
+		if (!duk_get_prop_string(ctx, -1, "modules"))
+		{
+			duk_pop(ctx);
+			duk_push_object(ctx);
+			duk_dup_top(ctx);
+			duk_put_prop_string(ctx, -3, "modules");
+		}
+		// [stash, modules]
+		auto* module = static_cast<JSScript*>(system.m_script_manager.get(Path(path)));
+		bool is_ready = module && module->isReady();
+		if (duk_get_prop_string(ctx, -1, path))
+		{
+			// reloaded modules are evaluated again, scripts which already got the old exports keep them
+			duk_get_prop_string(ctx, -1, "\xff" "hash");
+			bool is_stale = is_ready && duk_get_uint(ctx, -1) != module->getSourceHash();
+			duk_pop(ctx);
+			if (!is_stale)
+			{
+				duk_get_prop_string(ctx, -1, "exports");
+				return 1;
+			}
+		}
+		duk_pop(ctx);
+
+		if (!is_ready)
+		{
+			return duk_error(ctx, DUK_ERR_ERROR, "module %s is not loaded, require it with a string literal", path);
+		}
+		if (!module->hasSource() && module->getModuleBytecode().empty())
+		{
+			return duk_error(ctx, DUK_ERR_ERROR, "source of %s has been released", path);
+		}
+		if (!compileModule(ctx, *module)) return duk_throw(ctx);
+
+		// [stash, modules, func]
+		duk_push_object(ctx);
+		duk_push_object(ctx);
+		duk_put_prop_string(ctx, -2, "exports");
+		duk_push_uint(ctx, module->getSourceHash());
+		duk_put_prop_string(ctx, -2, "\xff" "hash");
+		// cached before it runs, so circular requires get the partial exports
+		duk_dup_top(ctx);
+		duk_put_prop_string(ctx, -4, path);
+
+		// [stash, modules, func, module]
+		duk_dup(ctx, -2);
+		duk_get_prop_string(ctx, -2, "exports");
+		duk_push_c_function(ctx, &instrumentedBinding<require>, 1);
+		duk_push_string(ctx, path);
+		duk_put_prop_string(ctx, -2, "\xff" "path");
+		duk_dup(ctx, -4);
+		// [stash, modules, func, module, func, exports, require, module] -> [stash, modules, func, module, ret]
+		if (duk_pcall(ctx, 3) != 0)
+		{
+			duk_del_prop_string(ctx, -4, path);
+			return duk_throw(ctx);
+		}
+		// evaluated only once, until a reload
+		module->setModuleCached();
+		duk_pop(ctx);
+		duk_get_prop_string(ctx, -1, "exports");
+		return 1;
+	}
+
+
+	// startProfiler(interval_ms, interrupt_instructions)
+	static int startProfiler(duk_context* ctx)
+	{
+		JSProfiler& profiler = getSystem(ctx).m_profiler;
+		if (duk_is_number(ctx, 0)) profiler.setSampleInterval((float)duk_get_number(ctx, 0));
+		if (duk_is_number(ctx, 1)) profiler.setInterruptInstructions(duk_get_int(ctx, 1));
+		profiler.start();
+		return 0;
+	}
+
+
+	// setGCPolicy("immediate" | "frame_end" | "budgeted", budget_ms = 1, max_pending_frames = 30)
+	static int setGCPolicy(duk_context* ctx)
+	{
+		JSGCScheduler& scheduler = getSystem(ctx).m_gc_scheduler;
+		const char* name = JSWrapper::checkArg<const char*>(ctx, 0);
+		for (int i = 0; i < (int)JSGCScheduler::Policy::COUNT; ++i)
+		{
+			JSGCScheduler::Policy policy = (JSGCScheduler::Policy)i;
+			if (!equalStrings(name, JSGCScheduler::getPolicyName(policy))) continue;
+
+			scheduler.setPolicy(policy);
+			if (duk_is_number(ctx, 1)) scheduler.setBudget((float)duk_get_number(ctx, 1));
+			if (duk_is_number(ctx, 2)) scheduler.setMaxPendingFrames(duk_get_int(ctx, 2));
+			return 0;
+		}
+		return duk_error(ctx, DUK_ERR_TYPE_ERROR, "unknown GC policy %s", name);
+	}
+
+
+	static int stopProfiler(duk_context* ctx)
+	{
+		getSystem(ctx).m_profiler.stop();
+		return 0;
+	}
+
+
+	static int clearProfiler(duk_context* ctx)
+	{
+		getSystem(ctx).m_profiler.clear();
+		return 0;
+	}
+
+
+	// saveProfile(path), .json is written as speedscope, anything else as collapsed stacks
+	static int saveProfile(duk_context* ctx)
+	{
+		auto* path = JSWrapper::checkArg<const char*>(ctx, 0);
+		char ext[10];
+		PathUtils::getExtension(ext, lengthOf(ext), path);
+		auto format = equalIStrings(ext, "json") ? JSProfiler::Format::SPEEDSCOPE : JSProfiler::Format::COLLAPSED;
+		JSWrapper::push(ctx, getSystem(ctx).m_profiler.save(path, format));
+		return 1;
+	}
+
+
 	static void logError(const char* msg) { g_log_error.log("JS Script") << msg; }
 	static void logWarning(const char* msg) { g_log_warning.log("JS Script") << msg; }
 	static void logInfo(const char* msg) { g_log_info.log("JS Script") << msg; }
@@ -1454,7 +4123,9 @@ namespace Lumix
 	}
 
 
-	static int JS_getProperty(duk_context* ctx)
+	// component and descriptor of the accessor being called, the result is pushed
+	// by the caller outside of the allocation scope as it is requested by the script
+	static ComponentUID getAccessedComponent(duk_context* ctx, PropertyDescriptorBase** desc)
 	{
 		duk_push_this(ctx);
 		if (duk_is_null_or_undefined(ctx, -1))
@@ -1463,24 +4134,40 @@ namespace Lumix
 		}
 		duk_get_prop_string(ctx, -1, "c_scene");
 		IScene* scene = JSWrapper::toType<IScene*>(ctx, -1);
-		if(!scene) duk_eval_error(ctx, "getting property on invalid object");
+		if (!scene) duk_eval_error(ctx, "getting property on invalid object");
 
-		duk_get_prop_string(ctx, -1, "c_cmphandle");
+		JSAllocTracker::Scope alloc_scope(getAllocTracker(ctx), "component property");
+		duk_get_prop_string(ctx, -2, "c_cmphandle");
 		ComponentHandle cmp_handle = JSWrapper::toType<ComponentHandle>(ctx, -1);
-		duk_get_prop_string(ctx, -1, "c_cmptype");
+		duk_get_prop_string(ctx, -3, "c_cmptype");
 		ComponentType cmp_type = { JSWrapper::toType<int>(ctx, -1) };
-		duk_pop(ctx);
+		duk_pop_n(ctx, 4);
 
 		duk_push_current_function(ctx);
 		duk_get_prop_string(ctx, -1, "c_desc");
-		PropertyDescriptorBase* desc = JSWrapper::toType<PropertyDescriptorBase*>(ctx, -1);
-		duk_pop(ctx);
+		*desc = JSWrapper::toType<PropertyDescriptorBase*>(ctx, -1);
+		JSBindingStats& stats = getBindingStats(ctx);
+		if (stats.getCurrentBinding() >= 0)
+		{
+			duk_get_prop_string(ctx, -2, "c_binding");
+			stats.redirect(duk_get_int(ctx, -1));
+			duk_pop(ctx);
+		}
+		duk_pop_2(ctx);
 
 		ComponentUID cmp;
 		cmp.scene = scene;
 		cmp.handle = cmp_handle;
 		cmp.type = cmp_type;
 		cmp.entity = INVALID_ENTITY;
+		return cmp;
+	}
+
+
+	static int JS_getProperty(duk_context* ctx)
+	{
+		PropertyDescriptorBase* desc;
+		ComponentUID cmp = getAccessedComponent(ctx, &desc);
 		switch (desc->getType())
 		{
 			case PropertyDescriptorBase::DECIMAL:
@@ -1566,31 +4253,8 @@ namespace Lumix
 	
 	static int JS_setProperty(duk_context* ctx)
 	{
-		duk_push_this(ctx);
-		if (duk_is_null_or_undefined(ctx, -1))
-		{
-			duk_eval_error(ctx, "this is null or undefined");
-		}
-		duk_get_prop_string(ctx, -1, "c_scene");
-		IScene* scene = JSWrapper::toType<IScene*>(ctx, -1);
-		if (!scene) duk_eval_error(ctx, "getting property on invalid object");
-
-		duk_get_prop_string(ctx, -2, "c_cmphandle");
-		ComponentHandle cmp_handle = JSWrapper::toType<ComponentHandle>(ctx, -1);
-		duk_get_prop_string(ctx, -3, "c_cmptype");
-		ComponentType cmp_type = { JSWrapper::toType<int>(ctx, -1) };
-		duk_pop_3(ctx);
-
-		duk_push_current_function(ctx);
-		duk_get_prop_string(ctx, -1, "c_desc");
-		PropertyDescriptorBase* desc = JSWrapper::toType<PropertyDescriptorBase*>(ctx, -1);
-		duk_pop(ctx);
-
-		ComponentUID cmp;
-		cmp.scene = scene;
-		cmp.handle = cmp_handle;
-		cmp.type = cmp_type;
-		cmp.entity = INVALID_ENTITY;
+		PropertyDescriptorBase* desc;
+		ComponentUID cmp = getAccessedComponent(ctx, &desc);
 		switch (desc->getType())
 		{
 			case PropertyDescriptorBase::DECIMAL:
@@ -1660,12 +4324,12 @@ namespace Lumix
 
 	#define REGISTER_JS_METHOD(O, F) \
 		do { \
-			auto f = &JSWrapper::wrapMethod<O, decltype(&O::F), &O::F>; \
+			auto f = instrumented<&JSWrapper::wrapMethod<O, decltype(&O::F), &O::F>>(m_binding_stats, #O "." #F); \
 			registerMethod(m_global_context, #O, #F, f); \
 		} while(false)
 
 
-	static void registerComponent(duk_context* ctx, const char* cmp_type_name)
+	static void registerComponent(duk_context* ctx, JSBindingStats& stats, const char* cmp_type_name)
 	{
 		auto cmp_type = PropertyRegister::getComponentType(cmp_type_name);
 		registerJSComponent(ctx, cmp_type, cmp_type_name, &componentJSConstructor);
@@ -1674,6 +4338,7 @@ namespace Lumix
 		char tmp[50];
 		char setter[50];
 		char getter[50];
+		char binding_name[64];
 		for (auto* desc : descs)
 		{
 			switch (desc->getType())
@@ -1701,13 +4366,24 @@ namespace Lumix
 
 					duk_push_string(ctx, tmp);
 
-					duk_push_c_function(ctx, JS_getProperty, 0);
+					// calls are attributed to the property, see getAccessedComponent
+					copyString(binding_name, cmp_type_name);
+					catString(binding_name, ".");
+					catString(binding_name, getter);
+					duk_push_c_function(ctx, instrumented<JS_getProperty>(stats, "JS_getProperty"), 0);
 					JSWrapper::push(ctx, desc);
 					duk_put_prop_string(ctx, -2, "c_desc");
+					duk_push_int(ctx, stats.addBinding(binding_name));
+					duk_put_prop_string(ctx, -2, "c_binding");
 
-					duk_push_c_function(ctx, JS_setProperty, 1);
+					copyString(binding_name, cmp_type_name);
+					catString(binding_name, ".");
+					catString(binding_name, setter);
+					duk_push_c_function(ctx, instrumented<JS_setProperty>(stats, "JS_setProperty"), 1);
 					JSWrapper::push(ctx, desc);
 					duk_put_prop_string(ctx, -2, "c_desc");
+					duk_push_int(ctx, stats.addBinding(binding_name));
+					duk_put_prop_string(ctx, -2, "c_binding");
 
 					duk_def_prop(ctx, -4, DUK_DEFPROP_HAVE_GETTER | DUK_DEFPROP_HAVE_SETTER | DUK_DEFPROP_ENUMERABLE);
 
@@ -1727,11 +4403,11 @@ namespace Lumix
 		duk_put_global_string(ctx, "ImGui");
 
 		#define REGISTER_JS_FUNCTION(F) \
-			duk_push_c_function(ctx, &JSWrapper::wrap<decltype(ImGui::F), &ImGui::F>, DUK_VARARGS); \
+			duk_push_c_function(ctx, instrumented<&JSWrapper::wrap<decltype(ImGui::F), &ImGui::F>>(m_binding_stats, "ImGui." #F), DUK_VARARGS); \
 			duk_put_prop_string(ctx, -2, #F); \
 
 		#define REGISTER_JS_RAW_FUNCTION(F) \
-			duk_push_c_function(ctx, &JSImGui::F, DUK_VARARGS); \
+			duk_push_c_function(ctx, instrumented<&JSImGui::F>(m_binding_stats, "ImGui." #F), DUK_VARARGS); \
 			duk_put_prop_string(ctx, -2, #F); \
 
 		REGISTER_JS_RAW_FUNCTION(Begin);
@@ -1776,7 +4452,7 @@ namespace Lumix
 	{
 		#define REGISTER_JS_FUNCTION(F) \
 			do { \
-				duk_push_c_function(m_global_context, &JSWrapper::wrap<decltype(F), &F>, DUK_VARARGS); \
+				duk_push_c_function(m_global_context, instrumented<&JSWrapper::wrap<decltype(F), &F>>(m_binding_stats, #F), DUK_VARARGS); \
 				duk_put_global_string(m_global_context, #F); \
 			} while(false)
 
@@ -1784,6 +4460,34 @@ namespace Lumix
 		REGISTER_JS_FUNCTION(logWarning);
 		REGISTER_JS_FUNCTION(logInfo);
 
+		#define REGISTER_JS_RAW_FUNCTION(F) \
+			do { \
+				duk_push_c_function(m_global_context, instrumented<&F>(m_binding_stats, #F), DUK_VARARGS); \
+				duk_put_global_string(m_global_context, #F); \
+			} while(false)
+
+		REGISTER_JS_RAW_FUNCTION(startProfiler);
+		REGISTER_JS_RAW_FUNCTION(startAllocationTracking);
+		REGISTER_JS_RAW_FUNCTION(stopAllocationTracking);
+		REGISTER_JS_RAW_FUNCTION(startTrace);
+		REGISTER_JS_RAW_FUNCTION(stopTrace);
+		REGISTER_JS_RAW_FUNCTION(setGCPolicy);
+		REGISTER_JS_RAW_FUNCTION(require);
+		REGISTER_JS_RAW_FUNCTION(getScriptInstance);
+		REGISTER_JS_RAW_FUNCTION(on);
+		REGISTER_JS_RAW_FUNCTION(off);
+		REGISTER_JS_RAW_FUNCTION(setTimeout);
+		REGISTER_JS_RAW_FUNCTION(setInterval);
+		REGISTER_JS_RAW_FUNCTION(clearTimeout);
+		REGISTER_JS_RAW_FUNCTION(clearInterval);
+		REGISTER_JS_RAW_FUNCTION(sendMessage);
+		REGISTER_JS_RAW_FUNCTION(broadcast);
+		REGISTER_JS_RAW_FUNCTION(stopProfiler);
+		REGISTER_JS_RAW_FUNCTION(clearProfiler);
+		REGISTER_JS_RAW_FUNCTION(saveProfile);
+
+		#undef REGISTER_JS_RAW_FUNCTION
+
 		registerImGuiAPI();
 
 		registerJSObject(m_global_context, nullptr, "Engine", &ptrJSConstructor);
@@ -1799,11 +4503,18 @@ namespace Lumix
 
 		registerJSObject(m_global_context, nullptr, "Universe", &ptrJSConstructor);
 
-		registerMethod(m_global_context, "Universe", "createEntity", &createEntity);
-		registerMethod(m_global_context, "Universe", "getEntityByName", &getEntityByName);
+		registerMethod(m_global_context, "Universe", "createEntity", instrumented<&createEntity>(m_binding_stats, "Universe.createEntity"));
+		registerMethod(m_global_context, "Universe", "getEntityByName", instrumented<&getEntityByName>(m_binding_stats, "Universe.getEntityByName"));
 
 		registerJSObject(m_global_context, nullptr, "SceneBase", &ptrJSConstructor);
 		registerJSObject(m_global_context, nullptr, "Entity", &entityJSConstructor);
+		duk_get_global_string(m_global_context, "Entity");
+		duk_push_object(m_global_context);
+		duk_push_c_function(m_global_context,
+			instrumented<entityProxyGetter>(m_binding_stats, "entityProxyGetter"), 3);
+		duk_put_prop_string(m_global_context, -2, "get");
+		duk_put_prop_string(m_global_context, -2, "\xff" "handler");
+		duk_pop(m_global_context);
 
 		#undef REGISTER_JS_FUNCTION
 
@@ -1811,7 +4522,7 @@ namespace Lumix
 		for (int i = 0; i < count; ++i)
 		{
 			const char* cmp_type_id = PropertyRegister::getComponentTypeID(i);
-			registerComponent(m_global_context, cmp_type_id);
+			registerComponent(m_global_context, m_binding_stats, cmp_type_id);
 		}
 	}
 
@@ -1819,8 +4530,67 @@ namespace Lumix
 
 	JSScriptSystemImpl::~JSScriptSystemImpl()
 	{
+		m_compiler.stop();
 		duk_destroy_heap(m_global_context);
 		m_script_manager.destroy();
+		unmountBundle();
+	}
+
+
+	// the list starts with the last device of the chain, out gets the names from the first one
+	static void catDeviceNames(const FS::DeviceList& devices, const FS::IFileDevice* skipped, char* out, int max_size)
+	{
+		int count = 0;
+		while (count < lengthOf(devices.m_devices) && devices.m_devices[count]) ++count;
+		for (int i = count - 1; i >= 0; --i)
+		{
+			if (devices.m_devices[i] == skipped) continue;
+			if (out[0] != '\0') catString(out, max_size, ":");
+			catString(out, max_size, devices.m_devices[i]->name());
+		}
+	}
+
+
+	// the bundle device wraps the default devices, e.g. "memory:disk" becomes "jsbundle:memory:disk"
+	bool JSScriptSystemImpl::mountBundle()
+	{
+		if (m_is_bundle_mounted) return true;
+		if (!m_bundle.open(JS_BUNDLE_PATH)) return false;
+
+		FS::FileSystem& file_system = m_engine.getFileSystem();
+		char devices[256];
+		copyString(devices, m_bundle_device.name());
+		catDeviceNames(file_system.getDefaultDevice(), nullptr, devices, lengthOf(devices));
+		file_system.mount(&m_bundle_device);
+		file_system.setDefaultDevice(devices);
+		m_is_bundle_mounted = true;
+		g_log_info.log("JS Script") << "Loaded " << m_bundle.getEntryCount() << " scripts from " << JS_BUNDLE_PATH;
+		return true;
+	}
+
+
+	void JSScriptSystemImpl::unmountBundle()
+	{
+		if (!m_is_bundle_mounted) return;
+
+		FS::FileSystem& file_system = m_engine.getFileSystem();
+		char devices[256] = "";
+		catDeviceNames(file_system.getDefaultDevice(), &m_bundle_device, devices, lengthOf(devices));
+		file_system.setDefaultDevice(devices);
+		file_system.unMount(&m_bundle_device);
+		m_bundle.close();
+		m_is_bundle_mounted = false;
+	}
+
+
+	// once per engine frame after the scenes, however many universes there are
+	void JSScriptSystemImpl::update(float time_delta)
+	{
+		// collections deferred during the frame, before its stats are closed
+		m_gc_scheduler.endFrame();
+		m_heap_monitor.endFrame(time_delta);
+		m_tracer.flush();
+		m_binding_stats.endFrame();
 	}
 
 
@@ -1842,3 +4612,46 @@ namespace Lumix
 		return LUMIX_NEW(engine.getAllocator(), JSScriptSystemImpl)(engine);
 	}
 }
+
+
+// called from duktape's interrupt, see DUK_USE_EXEC_TIMEOUT_CHECK in duk_config.h
+extern "C" int lumix_duk_interrupt(void* udata)
+{
+	if (!udata) return 0;
+	static_cast<Lumix::JSScriptSystemImpl*>(udata)->m_profiler.onInterrupt();
+	return 0;
+}
+
+
+extern "C" duk_int_t lumix_duk_interrupt_interval(void* udata)
+{
+	if (!udata) return 0;
+	return static_cast<Lumix::JSScriptSystemImpl*>(udata)->m_profiler.getInterruptInterval();
+}
+
+
+extern "C" void lumix_duk_gc_begin(void* udata)
+{
+	if (!udata) return;
+	auto* system = static_cast<Lumix::JSScriptSystemImpl*>(udata);
+	system->m_tracer.begin("gc", "mark-and-sweep");
+	system->m_gc_scheduler.onGCBegin();
+	system->m_heap_monitor.beginGC();
+}
+
+
+extern "C" void lumix_duk_gc_end(void* udata, duk_size_t object_count, duk_size_t string_count)
+{
+	if (!udata) return;
+	auto* system = static_cast<Lumix::JSScriptSystemImpl*>(udata);
+	system->m_heap_monitor.endGC(object_count, string_count);
+	system->m_gc_scheduler.onGCEnd(system->m_heap_monitor.getStats().last_gc_time);
+	system->m_tracer.end();
+}
+
+
+extern "C" int lumix_duk_gc_voluntary(void* udata)
+{
+	if (!udata) return 1;
+	return static_cast<Lumix::JSScriptSystemImpl*>(udata)->m_gc_scheduler.onVoluntaryGC() ? 1 : 0;
+}
@@ -12,6 +12,13 @@ namespace Lumix
 {
 
 
+class JSAllocTracker;
+class JSBindingStats;
+class JSGCScheduler;
+class JSHeapMonitor;
+class JSProfiler;
+
+
 class JSScriptScene : public IScene
 {
 public:
@@ -45,12 +52,54 @@ public:
 		virtual void add(void* parameter) = 0;
 	};
 
+
+	enum class Callback : int
+	{
+		UPDATE,
+		START_GAME,
+		DESTROY,
+		GUI,
+		DRAW_GIZMO,
+		REUSE,
+		EVENT,
+		TIMER,
+		MESSAGE,
+		OTHER,
+
+		COUNT
+	};
+
+
+	// times are in raw timer ticks, see getProfilerFrequency
+	struct CallbackStats
+	{
+		u32 call_count;
+		u64 total_time;
+		u64 max_time;
+		Entity max_entity;
+	};
+
 public:
 	virtual Path getScriptPath(ComponentHandle cmp, int scr_index) = 0;	
 	virtual void setScriptPath(ComponentHandle cmp, int scr_index, const Path& path) = 0;
 	virtual ComponentHandle getComponent(Entity entity) = 0;
 	virtual IFunctionCall* beginFunctionCall(ComponentHandle cmp, int scr_index, const char* function) = 0;
 	virtual void endFunctionCall() = 0;
+	// instances of ready scripts stay dormant, without an object, until they are activated -
+	// explicitly, by a function call, by an event or a message sent to their entity or by
+	// getScriptInstance(entity, index) from a script. Broadcasts do not activate them
+	virtual void setLazyStart(bool is_lazy) = 0;
+	virtual bool isLazyStart() const = 0;
+	// returns false if the instance is not running, e.g. its script failed
+	virtual bool activateScript(ComponentHandle cmp, int scr_index) = 0;
+	virtual bool isScriptActive(ComponentHandle cmp, int scr_index) = 0;
+	virtual int getDormantScriptCount() const = 0;
+	// instances waiting for their script to load or compile and scripts waiting to be reloaded
+	virtual int getPendingScriptCount() const = 0;
+	// queues an event for the instances of the entity which subscribed to it with
+	// on(name, fn), or for all subscribers if the entity is invalid. Arguments are added
+	// to the returned call, events are dispatched once per frame before update.
+	virtual IFunctionCall& postEvent(const char* name, Entity entity) = 0;
 	virtual int getScriptCount(ComponentHandle cmp) = 0;
 	virtual void insertScript(ComponentHandle cmp, int idx) = 0;
 	virtual int addScript(ComponentHandle cmp) = 0;
@@ -67,6 +116,20 @@ public:
 	virtual void getScriptData(ComponentHandle cmp, OutputBlob& blob) = 0;
 	virtual void setScriptData(ComponentHandle cmp, InputBlob& blob) = 0;
 	virtual duk_context* getGlobalContext() = 0;
+	// scripts are read from JS_BUNDLE_PATH in front of the default devices, the game enables
+	// it at start if the file exists, the studio when asked to. Loaded scripts are not reloaded
+	virtual bool setBundleEnabled(bool enable) = 0;
+	virtual bool isBundleEnabled() = 0;
+	virtual JSProfiler& getProfiler() = 0;
+	virtual const JSHeapMonitor& getHeapMonitor() = 0;
+	virtual JSAllocTracker& getAllocTracker() = 0;
+	virtual JSBindingStats& getBindingStats() = 0;
+	virtual JSGCScheduler& getGCScheduler() = 0;
+	virtual int getProfiledScriptCount() = 0;
+	virtual const Path& getProfiledScriptPath(int idx) = 0;
+	virtual const CallbackStats& getCallbackStats(int idx, Callback callback) = 0;
+	virtual u64 getProfilerFrequency() = 0;
+	virtual void resetCallbackStats() = 0;
 };
 
 
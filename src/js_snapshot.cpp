@@ -0,0 +1,601 @@
+#include "js_snapshot.h"
+#include "engine/array.h"
+#include "engine/blob.h"
+#include "engine/hash_map.h"
+#include "engine/iallocator.h"
+#include "engine/universe/universe.h"
+#include "js_wrapper.h"
+
+
+namespace Lumix
+{
+namespace JSSnapshot
+{
+
+
+static const u8 SNAPSHOT_VERSION = 0;
+static const int MAX_DEPTH = 256;
+static const u8 PLAIN_BUFFER = 0xff;
+
+
+enum class Tag : u8
+{
+	INVALID,
+	UNDEFINED,
+	NULL_VALUE,
+	FALSE_VALUE,
+	TRUE_VALUE,
+	NUMBER,
+	STRING,
+	OBJECT,
+	ARRAY,
+	BUFFER,
+	REFERENCE,
+	ENTITY
+};
+
+
+struct BufferType
+{
+	const char* constructor;
+	duk_uint_t flags;
+};
+
+
+static const BufferType BUFFER_TYPES[] = {
+	{"ArrayBuffer", DUK_BUFOBJ_ARRAYBUFFER},
+	{"DataView", DUK_BUFOBJ_DATAVIEW},
+	{"Int8Array", DUK_BUFOBJ_INT8ARRAY},
+	{"Uint8Array", DUK_BUFOBJ_UINT8ARRAY},
+	{"Uint8ClampedArray", DUK_BUFOBJ_UINT8CLAMPEDARRAY},
+	{"Int16Array", DUK_BUFOBJ_INT16ARRAY},
+	{"Uint16Array", DUK_BUFOBJ_UINT16ARRAY},
+	{"Int32Array", DUK_BUFOBJ_INT32ARRAY},
+	{"Uint32Array", DUK_BUFOBJ_UINT32ARRAY},
+	{"Float32Array", DUK_BUFOBJ_FLOAT32ARRAY},
+	{"Float64Array", DUK_BUFOBJ_FLOAT64ARRAY}
+};
+
+
+static bool getEntity(duk_context* ctx, duk_idx_t idx, Entity* entity)
+{
+	duk_get_prop_string(ctx, idx, "c_universe");
+	bool is_entity = duk_is_pointer(ctx, -1) != 0;
+	duk_pop(ctx);
+	if (!is_entity) return false;
+
+	duk_get_prop_string(ctx, idx, "c_entity");
+	entity->index = duk_get_int(ctx, -1);
+	duk_pop(ctx);
+	return true;
+}
+
+
+static bool isNative(duk_context* ctx, duk_idx_t idx)
+{
+	return duk_has_prop_string(ctx, idx, "c_ptr") || duk_has_prop_string(ctx, idx, "c_scene");
+}
+
+
+static bool isSerializable(duk_context* ctx, duk_idx_t idx)
+{
+	switch (duk_get_type(ctx, idx))
+	{
+		case DUK_TYPE_UNDEFINED:
+		case DUK_TYPE_NULL:
+		case DUK_TYPE_BOOLEAN:
+		case DUK_TYPE_NUMBER:
+		case DUK_TYPE_STRING:
+		case DUK_TYPE_BUFFER: return true;
+		case DUK_TYPE_OBJECT: return !duk_is_function(ctx, idx) && !isNative(ctx, idx);
+		default: return false;
+	}
+}
+
+
+struct Writer
+{
+	Writer(duk_context* _ctx, OutputBlob& _blob, IAllocator& allocator)
+		: ctx(_ctx)
+		, blob(_blob)
+		, ids(allocator)
+	{
+	}
+
+
+	void writeString(duk_idx_t idx)
+	{
+		duk_size_t len;
+		const char* str = duk_get_lstring(ctx, idx, &len);
+		blob.write((u32)len);
+		blob.write(str, (int)len);
+	}
+
+
+	bool writeReference(duk_idx_t idx)
+	{
+		void* ptr = duk_get_heapptr(ctx, idx);
+		auto iter = ids.find(ptr);
+		if (iter != ids.end())
+		{
+			blob.write(Tag::REFERENCE);
+			blob.write((u32)iter.value());
+			return true;
+		}
+		ids.insert(ptr, ids.size());
+		return false;
+	}
+
+
+	void writeBuffer(duk_idx_t idx, u8 type)
+	{
+		duk_size_t size;
+		void* data = duk_get_buffer_data(ctx, idx, &size);
+		blob.write(Tag::BUFFER);
+		blob.write(type);
+		blob.write((u32)size);
+		if (size > 0) blob.write(data, (int)size);
+	}
+
+
+	u8 getBufferType(duk_idx_t idx)
+	{
+		for (int i = 0; i < lengthOf(BUFFER_TYPES); ++i)
+		{
+			duk_get_global_string(ctx, BUFFER_TYPES[i].constructor);
+			bool is_instance = duk_instanceof(ctx, idx, -1) != 0;
+			duk_pop(ctx);
+			if (is_instance) return (u8)i;
+		}
+		return PLAIN_BUFFER;
+	}
+
+
+	void writeArray(duk_idx_t idx, int depth)
+	{
+		u32 length = (u32)duk_get_length(ctx, idx);
+		blob.write(Tag::ARRAY);
+		blob.write(length);
+		for (u32 i = 0; i < length; ++i)
+		{
+			duk_get_prop_index(ctx, idx, i);
+			if (isSerializable(ctx, -1))
+				writeValue(-1, depth + 1);
+			else
+				blob.write(Tag::UNDEFINED);
+			duk_pop(ctx);
+		}
+	}
+
+
+	void writeObject(duk_idx_t idx, int depth)
+	{
+		blob.write(Tag::OBJECT);
+		duk_enum(ctx, idx, DUK_ENUM_OWN_PROPERTIES_ONLY);
+		while (duk_next(ctx, -1, 1))
+		{
+			// [... enum key value]
+			if (isSerializable(ctx, -1))
+			{
+				blob.write((u8)1);
+				writeString(-2);
+				writeValue(-1, depth + 1);
+			}
+			duk_pop_2(ctx);
+		}
+		duk_pop(ctx);
+		blob.write((u8)0);
+	}
+
+
+	void writeValue(duk_idx_t idx, int depth)
+	{
+		idx = duk_normalize_index(ctx, idx);
+		if (depth > MAX_DEPTH)
+		{
+			blob.write(Tag::UNDEFINED);
+			return;
+		}
+		duk_require_stack(ctx, 4);
+
+		switch (duk_get_type(ctx, idx))
+		{
+			case DUK_TYPE_NULL: blob.write(Tag::NULL_VALUE); break;
+			case DUK_TYPE_BOOLEAN: blob.write(duk_get_boolean(ctx, idx) ? Tag::TRUE_VALUE : Tag::FALSE_VALUE); break;
+			case DUK_TYPE_NUMBER:
+				blob.write(Tag::NUMBER);
+				blob.write(duk_get_number(ctx, idx));
+				break;
+			case DUK_TYPE_STRING:
+				blob.write(Tag::STRING);
+				writeString(idx);
+				break;
+			case DUK_TYPE_BUFFER:
+				if (!writeReference(idx)) writeBuffer(idx, PLAIN_BUFFER);
+				break;
+			case DUK_TYPE_OBJECT:
+			{
+				Entity entity;
+				if (getEntity(ctx, idx, &entity))
+				{
+					blob.write(Tag::ENTITY);
+					blob.write(entity.index);
+					break;
+				}
+				if (writeReference(idx)) break;
+				if (duk_is_buffer_data(ctx, idx))
+					writeBuffer(idx, getBufferType(idx));
+				else if (duk_is_array(ctx, idx))
+					writeArray(idx, depth);
+				else
+					writeObject(idx, depth);
+			}
+			break;
+			default: blob.write(Tag::UNDEFINED); break;
+		}
+	}
+
+
+	duk_context* ctx;
+	OutputBlob& blob;
+	HashMap<void*, int> ids;
+};
+
+
+struct Reader
+{
+	Reader(duk_context* _ctx, InputBlob& _blob, Universe& _universe, IEntityRemap* _remap, IAllocator& allocator)
+		: ctx(_ctx)
+		, blob(_blob)
+		, universe(_universe)
+		, remap(_remap)
+		, objects(allocator)
+		, ids(allocator)
+	{
+	}
+
+
+	void addObject(void* ptr)
+	{
+		ids.insert(ptr, objects.size());
+		objects.push(ptr);
+	}
+
+
+	bool pushString()
+	{
+		u32 len = 0;
+		blob.read(len);
+		if ((int)len > blob.getSize() - blob.getPosition()) return false;
+		duk_push_lstring(ctx, (const char*)blob.getData() + blob.getPosition(), len);
+		blob.skip((int)len);
+		return true;
+	}
+
+
+	bool pushBuffer()
+	{
+		u8 type = PLAIN_BUFFER;
+		u32 size = 0;
+		blob.read(type);
+		blob.read(size);
+		if ((int)size > blob.getSize() - blob.getPosition()) return false;
+		if (type != PLAIN_BUFFER && type >= lengthOf(BUFFER_TYPES)) return false;
+
+		void* data = duk_push_fixed_buffer(ctx, size);
+		blob.read(data, (int)size);
+		if (type != PLAIN_BUFFER)
+		{
+			duk_push_buffer_object(ctx, -1, 0, size, BUFFER_TYPES[type].flags);
+			duk_remove(ctx, -2);
+		}
+		addObject(duk_get_heapptr(ctx, -1));
+		return true;
+	}
+
+
+	bool pushEntity()
+	{
+		Entity entity;
+		blob.read(entity.index);
+		if (remap) entity = remap->remap(entity);
+		if (!entity.isValid())
+		{
+			duk_push_null(ctx);
+			return true;
+		}
+		duk_get_global_string(ctx, "Entity");
+		duk_push_pointer(ctx, &universe);
+		JSWrapper::push(ctx, entity);
+		duk_new(ctx, 2);
+		return true;
+	}
+
+
+	bool pushArray(int depth)
+	{
+		u32 length = 0;
+		blob.read(length);
+		duk_push_array(ctx);
+		addObject(duk_get_heapptr(ctx, -1));
+		for (u32 i = 0; i < length; ++i)
+		{
+			Tag tag = Tag::INVALID;
+			blob.read(tag);
+			if (!pushValue(tag, depth + 1)) return false;
+			duk_put_prop_index(ctx, -2, i);
+		}
+		return true;
+	}
+
+
+	bool isMergeable(duk_idx_t idx)
+	{
+		if (!duk_is_object(ctx, idx)) return false;
+		if (duk_is_function(ctx, idx) || duk_is_array(ctx, idx) || duk_is_buffer_data(ctx, idx)) return false;
+		if (isNative(ctx, idx)) return false;
+		Entity entity;
+		if (getEntity(ctx, idx, &entity)) return false;
+		return ids.find(duk_get_heapptr(ctx, idx)) == ids.end();
+	}
+
+
+	// [... obj] -> [... obj]
+	bool readProperties(int depth)
+	{
+		if (depth > MAX_DEPTH) return false;
+		duk_require_stack(ctx, 4);
+
+		duk_idx_t obj_idx = duk_get_top_index(ctx);
+		for (;;)
+		{
+			u8 has_next = 0;
+			blob.read(has_next);
+			if (!has_next) return true;
+			if (!pushString()) return false;
+
+			Tag tag = Tag::INVALID;
+			blob.read(tag);
+			if (tag == Tag::OBJECT)
+			{
+				duk_dup(ctx, -1);
+				duk_get_prop(ctx, obj_idx); // [... obj key existing]
+				if (isMergeable(-1))
+				{
+					addObject(duk_get_heapptr(ctx, -1));
+					if (!readProperties(depth + 1)) return false;
+					duk_pop_2(ctx);
+					continue;
+				}
+				duk_pop(ctx);
+			}
+			if (!pushValue(tag, depth + 1)) return false;
+			duk_put_prop(ctx, obj_idx);
+		}
+	}
+
+
+	bool pushValue(Tag tag, int depth)
+	{
+		if (depth > MAX_DEPTH) return false;
+		duk_require_stack(ctx, 4);
+
+		switch (tag)
+		{
+			case Tag::UNDEFINED: duk_push_undefined(ctx); return true;
+			case Tag::NULL_VALUE: duk_push_null(ctx); return true;
+			case Tag::FALSE_VALUE: duk_push_false(ctx); return true;
+			case Tag::TRUE_VALUE: duk_push_true(ctx); return true;
+			case Tag::NUMBER:
+			{
+				double value = 0;
+				blob.read(value);
+				duk_push_number(ctx, value);
+				return true;
+			}
+			case Tag::STRING: return pushString();
+			case Tag::BUFFER: return pushBuffer();
+			case Tag::ENTITY: return pushEntity();
+			case Tag::ARRAY: return pushArray(depth);
+			case Tag::OBJECT:
+				duk_push_object(ctx);
+				addObject(duk_get_heapptr(ctx, -1));
+				return readProperties(depth);
+			case Tag::REFERENCE:
+			{
+				u32 id = 0xffffFFFF;
+				blob.read(id);
+				if (id >= (u32)objects.size()) return false;
+				duk_push_heapptr(ctx, objects[id]);
+				return true;
+			}
+			default: return false;
+		}
+	}
+
+
+	duk_context* ctx;
+	InputBlob& blob;
+	Universe& universe;
+	IEntityRemap* remap;
+	Array<void*> objects;
+	HashMap<void*, int> ids; // index in objects, so merging does not search them
+};
+
+
+// walks the encoding without a context, entity references are passed to the remap
+struct EntityVisitor
+{
+	EntityVisitor(const u8* _data, u8* _out, int _size, IEntityRemap& _remap)
+		: data(_data)
+		, out(_out)
+		, size(_size)
+		, pos(0)
+		, remap(_remap)
+	{
+	}
+
+
+	bool skip(int count)
+	{
+		if (count < 0 || count > size - pos) return false;
+		pos += count;
+		return true;
+	}
+
+
+	bool readU32(u32* value)
+	{
+		if (size - pos < (int)sizeof(*value)) return false;
+		copyMemory(value, data + pos, sizeof(*value));
+		pos += sizeof(*value);
+		return true;
+	}
+
+
+	bool visitString()
+	{
+		u32 len;
+		return readU32(&len) && skip((int)len);
+	}
+
+
+	bool visitEntity()
+	{
+		Entity entity;
+		if (size - pos < (int)sizeof(entity.index)) return false;
+		copyMemory(&entity.index, data + pos, sizeof(entity.index));
+		Entity remapped = remap.remap(entity);
+		if (out && remapped != entity) copyMemory(out + pos, &remapped.index, sizeof(remapped.index));
+		pos += sizeof(entity.index);
+		return true;
+	}
+
+
+	bool visitValue(int depth)
+	{
+		if (depth > MAX_DEPTH || pos >= size) return false;
+
+		Tag tag = (Tag)data[pos++];
+		switch (tag)
+		{
+			case Tag::UNDEFINED:
+			case Tag::NULL_VALUE:
+			case Tag::FALSE_VALUE:
+			case Tag::TRUE_VALUE: return true;
+			case Tag::NUMBER: return skip(sizeof(double));
+			case Tag::STRING: return visitString();
+			case Tag::ENTITY: return visitEntity();
+			case Tag::REFERENCE: return skip(sizeof(u32));
+			case Tag::BUFFER:
+			{
+				u32 buffer_size;
+				return skip(sizeof(u8)) && readU32(&buffer_size) && skip((int)buffer_size);
+			}
+			case Tag::ARRAY:
+			{
+				u32 length;
+				if (!readU32(&length)) return false;
+				for (u32 i = 0; i < length; ++i)
+				{
+					if (!visitValue(depth + 1)) return false;
+				}
+				return true;
+			}
+			case Tag::OBJECT:
+			{
+				for (;;)
+				{
+					if (pos >= size) return false;
+					if (data[pos++] == 0) return true;
+					if (!visitString() || !visitValue(depth + 1)) return false;
+				}
+			}
+			default: return false;
+		}
+	}
+
+
+	bool visit()
+	{
+		if (size < 1 || data[0] != SNAPSHOT_VERSION) return false;
+		pos = 1;
+		return visitValue(0);
+	}
+
+
+	const u8* data;
+	u8* out;
+	int size;
+	int pos;
+	IEntityRemap& remap;
+};
+
+
+struct EntityCollector : IEntityRemap
+{
+	explicit EntityCollector(Array<Entity>& _entities)
+		: entities(_entities)
+	{
+	}
+
+
+	Entity remap(Entity entity) override
+	{
+		if (entities.indexOf(entity) < 0) entities.push(entity);
+		return entity;
+	}
+
+
+	Array<Entity>& entities;
+};
+
+
+void write(duk_context* ctx, duk_idx_t idx, OutputBlob& blob, IAllocator& allocator)
+{
+	Writer writer(ctx, blob, allocator);
+	blob.write(SNAPSHOT_VERSION);
+	writer.writeValue(idx, 0);
+}
+
+
+bool read(duk_context* ctx,
+	duk_idx_t target_idx,
+	InputBlob& blob,
+	Universe& universe,
+	IEntityRemap* entity_remap,
+	IAllocator& allocator)
+{
+	u8 version = 0xff;
+	Tag tag = Tag::INVALID;
+	blob.read(version);
+	blob.read(tag);
+	if (version != SNAPSHOT_VERSION || tag != Tag::OBJECT) return false;
+
+	Reader reader(ctx, blob, universe, entity_remap, allocator);
+	duk_idx_t top = duk_get_top(ctx);
+	duk_dup(ctx, target_idx);
+	reader.addObject(duk_get_heapptr(ctx, -1));
+	bool success = reader.readProperties(0);
+	duk_set_top(ctx, top);
+	return success;
+}
+
+
+bool remapEntities(u8* data, int size, IEntityRemap& entity_remap)
+{
+	EntityVisitor visitor(data, data, size, entity_remap);
+	return visitor.visit();
+}
+
+
+bool getEntities(const u8* data, int size, Array<Entity>& entities)
+{
+	EntityCollector collector(entities);
+	EntityVisitor visitor(data, nullptr, size, collector);
+	return visitor.visit();
+}
+
+
+} // namespace JSSnapshot
+} // namespace Lumix
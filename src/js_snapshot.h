@@ -0,0 +1,52 @@
+#pragma once
+
+
+#include "engine/lumix.h"
+#include "duktape/duktape.h"
+
+
+namespace Lumix
+{
+
+
+template <typename T> class Array;
+class InputBlob;
+class OutputBlob;
+class Universe;
+struct IAllocator;
+
+
+namespace JSSnapshot
+{
+
+
+struct IEntityRemap
+{
+	virtual Entity remap(Entity entity) = 0;
+};
+
+
+// Encodes the value at idx, including nested objects, arrays, typed arrays and cycles.
+// Functions and native pointers are skipped, entities are stored as references.
+void write(duk_context* ctx, duk_idx_t idx, OutputBlob& blob, IAllocator& allocator);
+
+// Decodes a snapshot and merges it into the object at target_idx.
+// Existing nested objects are updated in place, so methods set up by the script survive.
+bool read(duk_context* ctx,
+	duk_idx_t target_idx,
+	InputBlob& blob,
+	Universe& universe,
+	IEntityRemap* entity_remap,
+	IAllocator& allocator);
+
+// Rewrites the entity references of a snapshot in place, e.g. when it is pasted to other entities.
+bool remapEntities(u8* data, int size, IEntityRemap& entity_remap);
+
+// Entities referenced by a snapshot, each once.
+bool getEntities(const u8* data, int size, Array<Entity>& entities);
+
+
+} // namespace JSSnapshot
+
+
+} // namespace Lumix
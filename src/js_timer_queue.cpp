@@ -0,0 +1,166 @@
+#include "js_timer_queue.h"
+
+
+namespace Lumix
+{
+
+
+JSTimerQueue::JSTimerQueue(IAllocator& allocator)
+	: m_allocator(allocator)
+	, m_timers(allocator)
+	, m_free_slots(allocator)
+	, m_heap(allocator)
+	, m_map(allocator)
+	, m_time(0)
+	, m_id_generator(0)
+{
+}
+
+
+// timers which fire at the same time keep the order they were added in
+bool JSTimerQueue::isBefore(const HeapItem& a, const HeapItem& b)
+{
+	return a.time < b.time || (a.time == b.time && a.id < b.id);
+}
+
+
+void JSTimerQueue::push(const HeapItem& item)
+{
+	m_heap.push(item);
+	int i = m_heap.size() - 1;
+	while (i > 0)
+	{
+		int parent = (i - 1) / 2;
+		if (!isBefore(m_heap[i], m_heap[parent])) break;
+		HeapItem tmp = m_heap[i];
+		m_heap[i] = m_heap[parent];
+		m_heap[parent] = tmp;
+		i = parent;
+	}
+}
+
+
+void JSTimerQueue::popTop()
+{
+	m_heap[0] = m_heap.back();
+	m_heap.pop();
+	int size = m_heap.size();
+	int i = 0;
+	for (;;)
+	{
+		int first = i;
+		int left = i * 2 + 1;
+		int right = left + 1;
+		if (left < size && isBefore(m_heap[left], m_heap[first])) first = left;
+		if (right < size && isBefore(m_heap[right], m_heap[first])) first = right;
+		if (first == i) break;
+		HeapItem tmp = m_heap[i];
+		m_heap[i] = m_heap[first];
+		m_heap[first] = tmp;
+		i = first;
+	}
+}
+
+
+// drops the items of removed timers
+void JSTimerQueue::rebuildHeap()
+{
+	Array<HeapItem> items(m_allocator);
+	items.swap(m_heap);
+	for (const HeapItem& item : items)
+	{
+		if (m_map.find(item.id) != m_map.end()) push(item);
+	}
+}
+
+
+int JSTimerQueue::add(float delay, float interval, int handler, Entity entity, uintptr owner)
+{
+	int slot;
+	if (m_free_slots.empty())
+	{
+		slot = m_timers.size();
+		m_timers.emplace();
+	}
+	else
+	{
+		slot = m_free_slots.back();
+		m_free_slots.pop();
+	}
+
+	++m_id_generator;
+	if (m_id_generator <= 0) m_id_generator = 1;
+	Timer& timer = m_timers[slot];
+	timer.time = m_time + (delay > 0 ? delay : 0);
+	timer.interval = interval;
+	timer.id = m_id_generator;
+	timer.handler = handler;
+	timer.entity = entity;
+	timer.owner = owner;
+	m_map.insert(timer.id, slot);
+	push({timer.time, timer.id, slot});
+	return timer.id;
+}
+
+
+bool JSTimerQueue::remove(int id, Timer* removed)
+{
+	auto iter = m_map.find(id);
+	if (iter == m_map.end()) return false;
+
+	int slot = iter.value();
+	if (removed) *removed = m_timers[slot];
+	m_timers[slot].id = 0;
+	m_free_slots.push(slot);
+	m_map.erase(id);
+
+	if (m_heap.size() > m_map.size() * 2 + 64) rebuildHeap();
+	return true;
+}
+
+
+JSTimerQueue::Timer* JSTimerQueue::get(int id)
+{
+	auto iter = m_map.find(id);
+	if (iter == m_map.end()) return nullptr;
+	return &m_timers[iter.value()];
+}
+
+
+void JSTimerQueue::update(float time_delta, Array<int>& expired)
+{
+	m_time += time_delta;
+	int first_expired = expired.size();
+	while (!m_heap.empty() && m_heap[0].time <= m_time)
+	{
+		HeapItem item = m_heap[0];
+		popTop();
+		if (m_map.find(item.id) == m_map.end()) continue;
+		expired.push(item.id);
+	}
+
+	// after all expired timers are popped, so intervals fire at most once per update
+	for (int i = first_expired; i < expired.size(); ++i)
+	{
+		int slot = m_map.find(expired[i]).value();
+		Timer& timer = m_timers[slot];
+		if (timer.interval < 0) continue;
+
+		timer.time += timer.interval;
+		if (timer.time < m_time) timer.time = m_time;
+		push({timer.time, timer.id, slot});
+	}
+}
+
+
+void JSTimerQueue::clear()
+{
+	m_timers.clear();
+	m_free_slots.clear();
+	m_heap.clear();
+	m_map.clear();
+	m_time = 0;
+}
+
+
+} // namespace Lumix
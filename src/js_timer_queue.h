@@ -0,0 +1,74 @@
+#pragma once
+
+
+#include "engine/array.h"
+#include "engine/hash_map.h"
+#include "engine/lumix.h"
+
+
+namespace Lumix
+{
+
+
+struct IAllocator;
+
+
+// Timers of setTimeout and setInterval, a binary min-heap ordered by the time the timers
+// fire. Removed timers are left in the heap and skipped when they reach the top, so
+// a frame costs O(expired * log(total)) and removing a timer is O(1).
+class JSTimerQueue
+{
+public:
+	struct Timer
+	{
+		double time; // when the timer fires, see getTime
+		float interval; // seconds, negative for timeouts
+		int id;
+		int handler; // owned by the caller, e.g. an index in a table of functions
+		Entity entity;
+		uintptr owner;
+	};
+
+public:
+	explicit JSTimerQueue(IAllocator& allocator);
+
+	// returns the id of the timer, ids are never 0
+	int add(float delay, float interval, int handler, Entity entity, uintptr owner);
+	// returns false if the timer does not exist, removed is optional
+	bool remove(int id, Timer* removed);
+	Timer* get(int id);
+	// advances the time and appends the ids of the expired timers to expired, in the order
+	// they fire. Intervals are scheduled again right away, at the earliest in the next
+	// update; expired timeouts stay until they are removed.
+	void update(float time_delta, Array<int>& expired);
+	void clear();
+
+	double getTime() const { return m_time; }
+	int getCount() const { return m_map.size(); }
+	int getHeapSize() const { return m_heap.size(); }
+
+private:
+	struct HeapItem
+	{
+		double time;
+		int id;
+		int slot;
+	};
+
+	static bool isBefore(const HeapItem& a, const HeapItem& b);
+	void push(const HeapItem& item);
+	void popTop();
+	void rebuildHeap();
+
+private:
+	IAllocator& m_allocator;
+	Array<Timer> m_timers;
+	Array<int> m_free_slots;
+	Array<HeapItem> m_heap;
+	HashMap<int, int> m_map; // id -> slot
+	double m_time;
+	int m_id_generator;
+};
+
+
+} // namespace Lumix
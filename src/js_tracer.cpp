@@ -0,0 +1,320 @@
+#include "js_tracer.h"
+#include "engine/array.h"
+#include "engine/blob.h"
+#include "engine/fs/os_file.h"
+#include "engine/iallocator.h"
+#include "engine/log.h"
+#include "engine/mt/sync.h"
+#include "engine/mt/task.h"
+#include "engine/mt/thread.h"
+#include "engine/string.h"
+#include "engine/timer.h"
+
+
+namespace Lumix
+{
+
+
+static void writeString(OutputBlob& blob, const char* str)
+{
+	blob.write(str, stringLength(str));
+}
+
+
+static void writeInt(OutputBlob& blob, u64 value)
+{
+	char tmp[32];
+	toCString(value, tmp, lengthOf(tmp));
+	writeString(blob, tmp);
+}
+
+
+// microseconds with three decimal places
+static void writeMicroseconds(OutputBlob& blob, u64 ticks, u64 frequency)
+{
+	double us = ticks * 1000000.0 / frequency;
+	u64 whole = (u64)us;
+	int frac = int((us - whole) * 1000);
+	writeInt(blob, whole);
+	blob.write('.');
+	blob.write(char('0' + frac / 100));
+	blob.write(char('0' + frac / 10 % 10));
+	blob.write(char('0' + frac % 10));
+}
+
+
+static void writeJSONString(OutputBlob& blob, const char* str)
+{
+	blob.write('"');
+	for (const char* c = str; *c; ++c)
+	{
+		switch (*c)
+		{
+			case '"': writeString(blob, "\\\""); break;
+			case '\\': writeString(blob, "\\\\"); break;
+			default:
+				if ((u8)*c >= 0x20) blob.write(*c);
+				break;
+		}
+	}
+	blob.write('"');
+}
+
+
+// writes the blobs queued by the recording thread, blobs are recycled through m_free
+struct JSTracer::Writer LUMIX_FINAL : public MT::Task
+{
+	explicit Writer(IAllocator& allocator)
+		: MT::Task(allocator)
+		, m_allocator(allocator)
+		, m_queue(allocator)
+		, m_free(allocator)
+		, m_semaphore(0, 0x7fffFFFF)
+		, m_mutex(false)
+		, m_is_finishing(false)
+		, m_blob_count(0)
+	{
+	}
+
+
+	~Writer()
+	{
+		for (OutputBlob* blob : m_free) LUMIX_DELETE(m_allocator, blob);
+		ASSERT(m_queue.empty());
+	}
+
+
+	OutputBlob* getBlob()
+	{
+		{
+			MT::SpinLock lock(m_mutex);
+			if (!m_free.empty())
+			{
+				OutputBlob* blob = m_free.back();
+				m_free.pop();
+				return blob;
+			}
+			// the allocator is not thread safe, the writer thread must not grow m_free
+			++m_blob_count;
+			m_free.reserve(m_blob_count);
+		}
+		OutputBlob* blob = LUMIX_NEW(m_allocator, OutputBlob)(m_allocator);
+		blob->reserve(64 * 1024);
+		return blob;
+	}
+
+
+	void push(OutputBlob* blob)
+	{
+		{
+			MT::SpinLock lock(m_mutex);
+			m_queue.push(blob);
+		}
+		m_semaphore.signal();
+	}
+
+
+	void finish()
+	{
+		{
+			MT::SpinLock lock(m_mutex);
+			m_is_finishing = true;
+		}
+		m_semaphore.signal();
+	}
+
+
+	int task() override
+	{
+		for (;;)
+		{
+			m_semaphore.wait();
+
+			OutputBlob* blob = nullptr;
+			{
+				MT::SpinLock lock(m_mutex);
+				if (m_queue.empty())
+				{
+					if (m_is_finishing) break;
+					continue;
+				}
+				blob = m_queue[0];
+				m_queue.erase(0);
+			}
+
+			if (!m_file.write(blob->getData(), blob->getPos()))
+			{
+				g_log_error.log("JS Script") << "Failed to write the trace";
+			}
+			blob->clear();
+
+			MT::SpinLock lock(m_mutex);
+			m_free.push(blob);
+		}
+		m_file.close();
+		return 0;
+	}
+
+
+	IAllocator& m_allocator;
+	FS::OsFile m_file;
+	Array<OutputBlob*> m_queue;
+	Array<OutputBlob*> m_free;
+	MT::Semaphore m_semaphore;
+	MT::SpinMutex m_mutex;
+	bool m_is_finishing;
+	int m_blob_count;
+};
+
+
+JSTracer::JSTracer(IAllocator& allocator)
+	: m_allocator(allocator)
+	, m_writer(nullptr)
+	, m_blob(nullptr)
+	, m_is_running(false)
+	, m_is_first_event(true)
+	, m_thread_id(0)
+{
+	m_timer = Timer::create(allocator);
+	setBindingThreshold(0.1f);
+}
+
+
+JSTracer::~JSTracer()
+{
+	if (m_is_running) stop();
+	Timer::destroy(m_timer);
+}
+
+
+bool JSTracer::start(const char* path)
+{
+	if (m_is_running) stop();
+
+	m_writer = LUMIX_NEW(m_allocator, Writer)(m_allocator);
+	if (!m_writer->m_file.open(path, FS::Mode::CREATE_AND_WRITE, m_allocator))
+	{
+		g_log_error.log("JS Script") << "Failed to create " << path;
+		LUMIX_DELETE(m_allocator, m_writer);
+		m_writer = nullptr;
+		return false;
+	}
+	m_writer->create("js_trace_writer");
+
+	m_is_running = true;
+	m_is_first_event = true;
+	m_thread_id = (u32)MT::getCurrentThreadID();
+	m_blob = m_writer->getBlob();
+	writeString(*m_blob, "{\"traceEvents\":[\n");
+	return true;
+}
+
+
+void JSTracer::stop()
+{
+	if (!m_is_running) return;
+
+	m_is_running = false;
+	writeString(*m_blob, "\n]}\n");
+	m_writer->push(m_blob);
+	m_blob = nullptr;
+
+	// only waits for the last frame, the rest has been written meanwhile
+	m_writer->finish();
+	m_writer->destroy();
+	LUMIX_DELETE(m_allocator, m_writer);
+	m_writer = nullptr;
+}
+
+
+void JSTracer::setBindingThreshold(float ms)
+{
+	m_binding_threshold = ms < 0 ? 0 : ms;
+	m_binding_threshold_ticks = u64(m_binding_threshold * 0.001f * m_timer->getFrequency());
+}
+
+
+u64 JSTracer::getTime() const
+{
+	return m_timer->getRawTimeSinceStart();
+}
+
+
+void JSTracer::begin(const char* category, const char* name, const char* detail)
+{
+	if (!m_is_running) return;
+	writeEvent('B', category, name, getTime(), 0, detail);
+}
+
+
+void JSTracer::end()
+{
+	if (!m_is_running) return;
+	writeEvent('E', nullptr, nullptr, getTime(), 0, nullptr);
+}
+
+
+void JSTracer::binding(const char* name, u64 duration)
+{
+	if (!m_is_running) return;
+	if (duration < m_binding_threshold_ticks) return;
+
+	u64 now = getTime();
+	u64 start_time = now > duration ? now - duration : 0;
+	writeEvent('X', "binding", name, start_time, duration, nullptr);
+}
+
+
+void JSTracer::flush()
+{
+	if (!m_is_running) return;
+
+	writeEvent('i', "frame", "frame", getTime(), 0, nullptr);
+	m_writer->push(m_blob);
+	m_blob = m_writer->getBlob();
+}
+
+
+void JSTracer::writeEvent(char phase, const char* category, const char* name, u64 time, u64 duration, const char* detail)
+{
+	OutputBlob& blob = *m_blob;
+	if (!m_is_first_event) writeString(blob, ",\n");
+	m_is_first_event = false;
+
+	u64 frequency = m_timer->getFrequency();
+	writeString(blob, "{\"ph\":\"");
+	blob.write(phase);
+	writeString(blob, "\",\"pid\":0,\"tid\":");
+	writeInt(blob, m_thread_id);
+	writeString(blob, ",\"ts\":");
+	writeMicroseconds(blob, time, frequency);
+	if (phase == 'X')
+	{
+		writeString(blob, ",\"dur\":");
+		writeMicroseconds(blob, duration, frequency);
+	}
+	else if (phase == 'i')
+	{
+		writeString(blob, ",\"s\":\"g\"");
+	}
+	if (name)
+	{
+		writeString(blob, ",\"name\":");
+		writeJSONString(blob, name);
+	}
+	if (category)
+	{
+		writeString(blob, ",\"cat\":");
+		writeJSONString(blob, category);
+	}
+	if (detail)
+	{
+		writeString(blob, ",\"args\":{\"detail\":");
+		writeJSONString(blob, detail);
+		blob.write('}');
+	}
+	blob.write('}');
+}
+
+
+} // namespace Lumix
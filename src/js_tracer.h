@@ -0,0 +1,58 @@
+#pragma once
+
+
+#include "engine/lumix.h"
+
+
+namespace Lumix
+{
+
+
+class OutputBlob;
+class Timer;
+struct IAllocator;
+
+
+// Records script execution as Chrome trace_event JSON (chrome://tracing, Perfetto).
+// Events are recorded on the script thread, formatted right away and handed to a writer
+// thread once per frame, so writing the file does not stall the frame.
+class JSTracer
+{
+public:
+	explicit JSTracer(IAllocator& allocator);
+	~JSTracer();
+
+	bool start(const char* path);
+	void stop();
+	bool isRunning() const { return m_is_running; }
+	void setBindingThreshold(float ms);
+	float getBindingThreshold() const { return m_binding_threshold; }
+	u64 getTime() const;
+
+	void begin(const char* category, const char* name, const char* detail = nullptr);
+	void end();
+	// recorded only if the binding took longer than the threshold, duration in timer ticks
+	// of the same frequency, the call is assumed to have just ended
+	void binding(const char* name, u64 duration);
+	// hands the recorded events to the writer thread
+	void flush();
+
+private:
+	struct Writer;
+
+	void writeEvent(char phase, const char* category, const char* name, u64 time, u64 duration, const char* detail);
+
+private:
+	IAllocator& m_allocator;
+	Timer* m_timer;
+	Writer* m_writer;
+	OutputBlob* m_blob;
+	bool m_is_running;
+	bool m_is_first_event;
+	u32 m_thread_id;
+	float m_binding_threshold;
+	u64 m_binding_threshold_ticks;
+};
+
+
+} // namespace Lumix
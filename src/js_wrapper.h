@@ -380,11 +380,11 @@ template <typename T> T checkArg(duk_context* ctx, int index)
 template <typename T>
 inline void getOptionalField(duk_context* ctx, int idx, const char* field_name, T* out)
 {
-	if (duk_get_prop(ctx, idx, field_name) && isType<T>(ctx, -1))
+	if (duk_get_prop_string(ctx, idx, field_name) && isType<T>(ctx, -1))
 	{
 		*out = toType<T>(ctx, -1);
 	}
-	duk_pop(ctx, 1);
+	duk_pop(ctx);
 }
 
 
@@ -438,6 +438,23 @@ template <class T> struct remove_cv_reference
 };
 
 
+// non-const references are passed through, e.g. the universe of Engine::startGame
+template <class T> struct arg_type
+{
+	using type = typename remove_cv_reference<T>::type;
+};
+
+template <class T> struct arg_type<T&>
+{
+	using type = T&;
+};
+
+template <class T> struct arg_type<const T&>
+{
+	using type = T;
+};
+
+
 template <int... T>
 struct Indices {};
 
@@ -457,9 +474,9 @@ struct build_indices<offset, 0, T...>
 
 
 template <typename T, int index>
-typename remove_cv_reference<T>::type convert(duk_context* ctx)
+typename arg_type<T>::type convert(duk_context* ctx)
 {
-	return checkArg<typename remove_cv_reference<T>::type>(ctx, index - 1);
+	return checkArg<typename arg_type<T>::type>(ctx, index - 1);
 }
 
 